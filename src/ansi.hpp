@@ -0,0 +1,254 @@
+#ifndef ANSI_HPP
+#define ANSI_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ansi_detail {
+
+enum State : uint8_t { S_GROUND, S_ESC, S_ESC_INTER, S_CSI, S_CSI_IGNORE, S_STRING, STATE_COUNT };
+enum Action : uint8_t { A_NONE, A_PRINT, A_START, A_DIGIT, A_SEP, A_DISPATCH };
+enum Class : uint8_t {
+    C_TEXT,     // printable ASCII outside sequences, and bytes 0x7F-0xFF
+    C_CTRL,     // C0 controls other than BEL and ESC
+    C_BEL,
+    C_ESC,
+    C_DIGIT,
+    C_SEP,      // ; and :
+    C_PRIVATE,  // < = > ?
+    C_INTER,    // 0x20-0x2F
+    C_CSI,      // [
+    C_STRING,   // ] P X ^ _ (OSC, DCS, SOS, PM, APC)
+    C_FINAL,    // the rest of 0x40-0x7E
+    CLASS_COUNT
+};
+
+struct ClassTable {
+    uint8_t of[256];
+    constexpr ClassTable() : of() {
+        for (int c = 0; c < 256; c++) {
+            uint8_t cls = C_TEXT;
+            if (c < 0x20) {
+                cls = c == 0x1B ? C_ESC : c == 0x07 ? C_BEL : C_CTRL;
+            } else if (c < 0x30) {
+                cls = C_INTER;
+            } else if (c <= '9') {
+                cls = C_DIGIT;
+            } else if (c == ';' || c == ':') {
+                cls = C_SEP;
+            } else if (c < 0x40) {
+                cls = C_PRIVATE;
+            } else if (c == '[') {
+                cls = C_CSI;
+            } else if (c == ']' || c == 'P' || c == 'X' || c == '^' || c == '_') {
+                cls = C_STRING;
+            } else if (c < 0x7F) {
+                cls = C_FINAL;
+            }
+            of[c] = cls;
+        }
+    }
+    constexpr uint8_t operator[](uint8_t c) const { return of[c]; }
+};
+
+constexpr uint8_t T(State next, Action action) { return static_cast<uint8_t>(action << 4 | next); }
+
+constexpr ClassTable classes{};
+
+// Next state and action for each state and character class. Only ESC
+// reaches the table from S_GROUND; AnsiParser::strip() copies plain text in
+// bulk.
+constexpr uint8_t transitions[STATE_COUNT][CLASS_COUNT] = {
+    //            TEXT                      CTRL                      BEL                       ESC                 DIGIT                      SEP                      PRIVATE                    INTER                      CSI                     STRING                  FINAL
+    /* GROUND */ {T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_ESC, A_NONE),   T(S_GROUND, A_PRINT),      T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),      T(S_GROUND, A_PRINT),      T(S_GROUND, A_PRINT),   T(S_GROUND, A_PRINT),   T(S_GROUND, A_PRINT)},
+    /* ESC */    {T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_ESC, A_NONE),   T(S_GROUND, A_NONE),       T(S_GROUND, A_NONE),     T(S_GROUND, A_NONE),       T(S_ESC_INTER, A_NONE),    T(S_CSI, A_START),      T(S_STRING, A_NONE),    T(S_GROUND, A_NONE)},
+    /* ESC_INT */{T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_ESC, A_NONE),   T(S_GROUND, A_NONE),       T(S_GROUND, A_NONE),     T(S_GROUND, A_NONE),       T(S_ESC_INTER, A_NONE),    T(S_GROUND, A_NONE),    T(S_GROUND, A_NONE),    T(S_GROUND, A_NONE)},
+    /* CSI */    {T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_ESC, A_NONE),   T(S_CSI, A_DIGIT),         T(S_CSI, A_SEP),         T(S_CSI_IGNORE, A_NONE),   T(S_CSI_IGNORE, A_NONE),   T(S_GROUND, A_DISPATCH), T(S_GROUND, A_DISPATCH), T(S_GROUND, A_DISPATCH)},
+    /* CSI_IGN */{T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_GROUND, A_PRINT),    T(S_ESC, A_NONE),   T(S_CSI_IGNORE, A_NONE),   T(S_CSI_IGNORE, A_NONE), T(S_CSI_IGNORE, A_NONE),   T(S_CSI_IGNORE, A_NONE),   T(S_GROUND, A_NONE),    T(S_GROUND, A_NONE),    T(S_GROUND, A_NONE)},
+    /* STRING */ {T(S_STRING, A_NONE),     T(S_GROUND, A_PRINT),    T(S_GROUND, A_NONE),     T(S_ESC, A_NONE),   T(S_STRING, A_NONE),       T(S_STRING, A_NONE),     T(S_STRING, A_NONE),       T(S_STRING, A_NONE),       T(S_STRING, A_NONE),    T(S_STRING, A_NONE),    T(S_STRING, A_NONE)},
+};
+
+} // namespace ansi_detail
+
+// Strips ANSI/VT100 escape sequences from captured output and tracks the
+// foreground color they select, as a PRNT color (0xAARRGGBB).
+//
+// SGR (ESC [ ... m) is understood for the foreground: 0 and 39 return to the
+// default color of the stream, 1 and 22 switch bright on and off for the
+// eight basic colors, 30-37 and 90-97 pick from the 16-color palette, and
+// 38;5;n and 38;2;r;g;b from the 256-color palette and true color. Everything
+// else is removed without effect: other CSI sequences (cursor movement,
+// erase), background colors, OSC strings such as window titles ended by BEL
+// or ESC \, DCS/PM/APC strings and two-byte ESC sequences. A control
+// character inside an unfinished sequence abandons it and is kept, so a
+// stray ESC can never swallow the lines after it.
+//
+// Parsing is one pass over the bytes in place. Plain text costs a memchr()
+// for ESC; inside a sequence each byte is one lookup in a character class
+// table and one in a state transition table. State carries over between
+// calls, so a sequence split across two reads is still recognized.
+class AnsiParser {
+public:
+    static constexpr size_t MAX_PARAMS = 16;
+
+    explicit AnsiParser(uint32_t defaultColor = 0xFFFFFFFF) : m_defaultColor(defaultColor) { reset(); }
+
+    // Back to plain text in the default color
+    void reset() {
+        m_state = ansi_detail::S_GROUND;
+        m_paramCount = 0;
+        m_fg = FG_DEFAULT;
+        m_fgRgb = 0;
+        m_bright = false;
+        m_color = m_defaultColor;
+    }
+
+    uint32_t color() const { return m_color; }
+    uint32_t defaultColor() const { return m_defaultColor; }
+
+    // Removes escape sequences from data and returns the length of the text
+    // left at its start. onColor(offset, color) is called whenever the color
+    // changes, offset being where the new color starts in the stripped text;
+    // everything before offset is final by then.
+    template <typename OnColor>
+    size_t strip(char* data, size_t len, OnColor&& onColor) {
+        char* out = data;
+        const char* in = data;
+        const char* end = data + len;
+
+        while (in < end) {
+            if (m_state == ansi_detail::S_GROUND) {
+                const char* esc = static_cast<const char*>(memchr(in, 0x1B, end - in));
+                size_t run = (esc ? esc : end) - in;
+                if (out != in) {
+                    memmove(out, in, run);
+                }
+                out += run;
+                in += run;
+                if (!esc) {
+                    break;
+                }
+            }
+
+            uint8_t c = static_cast<uint8_t>(*in++);
+            uint8_t t = ansi_detail::transitions[m_state][ansi_detail::classes[c]];
+            m_state = t & 0x0F;
+            switch (t >> 4) {
+            case ansi_detail::A_PRINT:
+                *out++ = static_cast<char>(c);
+                break;
+            case ansi_detail::A_START:
+                m_params[0] = 0;
+                m_paramCount = 1;
+                break;
+            case ansi_detail::A_DIGIT:
+                if (m_paramCount <= MAX_PARAMS) {
+                    uint16_t& p = m_params[m_paramCount - 1];
+                    p = p < 1000 ? static_cast<uint16_t>(p * 10 + (c - '0')) : 9999;
+                }
+                break;
+            case ansi_detail::A_SEP:
+                if (m_paramCount < MAX_PARAMS) {
+                    m_params[m_paramCount] = 0;
+                }
+                m_paramCount++;
+                break;
+            case ansi_detail::A_DISPATCH:
+                if (c == 'm' && m_paramCount <= MAX_PARAMS) {
+                    uint32_t before = m_color;
+                    applySgr();
+                    if (m_color != before) {
+                        onColor(static_cast<size_t>(out - data), m_color);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        return static_cast<size_t>(out - data);
+    }
+
+    // xterm's colors for the 256-color palette
+    static uint32_t paletteColor(uint32_t index) {
+        static const uint32_t basic[16] = {
+            0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+            0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF,
+        };
+        uint32_t rgb;
+        if (index < 16) {
+            rgb = basic[index];
+        } else if (index < 232) {
+            index -= 16;
+            uint32_t r = index / 36, g = index / 6 % 6, b = index % 6;
+            auto level = [](uint32_t v) { return v ? 55 + v * 40 : 0; };
+            rgb = (level(r) << 16) | (level(g) << 8) | level(b);
+        } else {
+            uint32_t gray = 8 + (index - 232) * 10;
+            rgb = (gray << 16) | (gray << 8) | gray;
+        }
+        return 0xFF000000 | rgb;
+    }
+
+private:
+    static constexpr int16_t FG_DEFAULT = -1;
+    static constexpr int16_t FG_RGB = 256;
+
+    void applySgr() {
+        size_t count = m_paramCount;
+        for (size_t i = 0; i < count; i++) {
+            uint16_t p = m_params[i];
+            if (p == 0) {
+                m_fg = FG_DEFAULT;
+                m_bright = false;
+            } else if (p == 1) {
+                m_bright = true;
+            } else if (p == 22) {
+                m_bright = false;
+            } else if (p >= 30 && p <= 37) {
+                m_fg = static_cast<int16_t>(p - 30);
+            } else if (p == 39) {
+                m_fg = FG_DEFAULT;
+            } else if (p >= 90 && p <= 97) {
+                m_fg = static_cast<int16_t>(p - 90 + 8);
+            } else if (p == 38 || p == 48) {
+                // Extended color; the background form is only skipped
+                if (i + 2 < count && m_params[i + 1] == 5) {
+                    if (p == 38 && m_params[i + 2] < 256) {
+                        m_fg = static_cast<int16_t>(m_params[i + 2]);
+                    }
+                    i += 2;
+                } else if (i + 4 < count && m_params[i + 1] == 2) {
+                    if (p == 38) {
+                        m_fg = FG_RGB;
+                        m_fgRgb = 0xFF000000 | (static_cast<uint32_t>(m_params[i + 2] & 0xFF) << 16) |
+                                  (static_cast<uint32_t>(m_params[i + 3] & 0xFF) << 8) | (m_params[i + 4] & 0xFF);
+                    }
+                    i += 4;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        if (m_fg == FG_DEFAULT) {
+            m_color = m_defaultColor;
+        } else if (m_fg == FG_RGB) {
+            m_color = m_fgRgb;
+        } else {
+            m_color = paletteColor(m_bright && m_fg < 8 ? m_fg + 8 : m_fg);
+        }
+    }
+
+    uint32_t m_defaultColor;
+    uint32_t m_color;
+    uint32_t m_fgRgb;
+    int16_t m_fg;  // palette index, FG_DEFAULT or FG_RGB
+    bool m_bright;
+    uint8_t m_state;
+    size_t m_paramCount;
+    uint16_t m_params[MAX_PARAMS];
+};
+
+#endif // ANSI_HPP
@@ -0,0 +1,136 @@
+#ifndef CAPTURE_LIMITER_HPP
+#define CAPTURE_LIMITER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "metrics.hpp"
+#include "token_bucket.hpp"
+
+// Lines from one emitter: a capture source plus, for AlertMessage, the
+// format string the caller passed, which tells apart the call sites of
+// every plugin and engine subsystem
+struct CaptureEmitter {
+    bool used = false;
+    CaptureSource source = CAPTURE_STDOUT;
+    const void* key = nullptr;
+    int32_t channelId = 0;
+    char label[64] = {};  // copy of the format string, which may not outlive its plugin
+    TokenBucket bucket;
+    uint64_t suppressed = 0;  // since the last report
+    uint64_t sampled = 0;     // over budget but let through, since the last report
+    uint64_t windowStartNs = 0;
+};
+
+// Per-emitter token buckets for lines sent to clients. Each emitter gets its
+// own rate and burst, so one plugin flooding the console uses up only its
+// own budget. Lines over budget are suppressed, except every sampleEvery-th one,
+// and counted for a periodic report. Emitters live in a fixed open-addressed
+// table; once it is full, new ones share one bucket per source.
+class CaptureLimiter {
+public:
+    static constexpr size_t SLOTS = 256;
+    static constexpr size_t PROBES = 8;
+
+    // rate 0 admits everything
+    void configure(double rate, double burst, uint32_t sampleEvery) {
+        m_rate = rate;
+        m_burst = burst;
+        m_sampleEvery = sampleEvery;
+        m_count = 0;
+        for (CaptureEmitter& emitter : m_slots) {
+            emitter = CaptureEmitter();
+        }
+        for (int i = 0; i < CAPTURE_SOURCE_COUNT; i++) {
+            m_shared[i] = CaptureEmitter();
+            m_shared[i].used = true;
+            m_shared[i].source = static_cast<CaptureSource>(i);
+            m_shared[i].bucket.configure(rate, burst);
+        }
+    }
+
+    bool enabled() const { return m_rate > 0.0; }
+    double rate() const { return m_rate; }
+    double burst() const { return m_burst; }
+    size_t emitters() const { return m_count; }
+
+    // Charges one line to an emitter; false if it should be dropped. label
+    // names the emitter in reports and is copied the first time it is seen.
+    bool admit(CaptureSource source, const void* key, const char* label, int32_t channelId, uint64_t nowNs) {
+        if (!enabled()) {
+            return true;
+        }
+
+        CaptureEmitter& emitter = find(source, key, label, channelId);
+        if (emitter.bucket.consume(TokenBucket::Clock::time_point(std::chrono::nanoseconds(nowNs)))) {
+            return true;
+        }
+
+        if (emitter.suppressed == 0 && emitter.sampled == 0) {
+            emitter.windowStartNs = nowNs;
+        }
+        if (m_sampleEvery > 0 && (emitter.suppressed + emitter.sampled + 1) % m_sampleEvery == 0) {
+            emitter.sampled++;
+            return true;
+        }
+        emitter.suppressed++;
+        return false;
+    }
+
+    // Calls report(emitter, nowNs - windowStartNs) for every emitter that
+    // went over budget at least intervalNs ago, then starts its count over
+    template <typename Report>
+    void collect(uint64_t nowNs, uint64_t intervalNs, Report&& report) {
+        for (CaptureEmitter& emitter : m_slots) {
+            collectOne(emitter, nowNs, intervalNs, report);
+        }
+        for (CaptureEmitter& emitter : m_shared) {
+            collectOne(emitter, nowNs, intervalNs, report);
+        }
+    }
+
+private:
+    CaptureEmitter& find(CaptureSource source, const void* key, const char* label, int32_t channelId) {
+        uint64_t hash = (reinterpret_cast<uintptr_t>(key) ^ (static_cast<uint64_t>(source) << 56)) *
+                        0x9E3779B97F4A7C15ull;
+        size_t index = static_cast<size_t>(hash >> 32) & (SLOTS - 1);
+        for (size_t probe = 0; probe < PROBES; probe++) {
+            CaptureEmitter& emitter = m_slots[(index + probe) & (SLOTS - 1)];
+            if (emitter.used && emitter.source == source && emitter.key == key) {
+                return emitter;
+            }
+            if (!emitter.used) {
+                emitter.used = true;
+                emitter.source = source;
+                emitter.key = key;
+                emitter.channelId = channelId;
+                if (label) {
+                    strncpy(emitter.label, label, sizeof(emitter.label) - 1);
+                }
+                emitter.bucket.configure(m_rate, m_burst);
+                m_count++;
+                return emitter;
+            }
+        }
+        return m_shared[source];
+    }
+
+    template <typename Report>
+    static void collectOne(CaptureEmitter& emitter, uint64_t nowNs, uint64_t intervalNs, Report& report) {
+        if ((emitter.suppressed > 0 || emitter.sampled > 0) && nowNs >= emitter.windowStartNs + intervalNs) {
+            report(static_cast<const CaptureEmitter&>(emitter), nowNs - emitter.windowStartNs);
+            emitter.suppressed = 0;
+            emitter.sampled = 0;
+        }
+    }
+
+    double m_rate = 0.0;
+    double m_burst = 0.0;
+    uint32_t m_sampleEvery = 0;
+    size_t m_count = 0;
+    CaptureEmitter m_slots[SLOTS];
+    CaptureEmitter m_shared[CAPTURE_SOURCE_COUNT];
+};
+
+#endif // CAPTURE_LIMITER_HPP
@@ -0,0 +1,146 @@
+#ifndef CLIENT_TABLE_HPP
+#define CLIENT_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Names an entry for as long as it exists; 0 never names one. Ids carry the
+// slot's generation, so an id kept past its entry's removal (in a timer, say)
+// finds nothing instead of whatever was inserted into the slot since.
+using ClientId = uint64_t;
+
+// Slot map of connected clients. Entries are stored densely, in no
+// particular order, so fan-out walks one contiguous array; removal moves the
+// last entry into the hole instead of shifting everything after it. Lookup
+// by id goes through a slot that follows the entry around, lookup by socket
+// through a hash index, and insert, find and remove are all O(1).
+//
+// References to entries are invalidated by insert and remove, ids are not.
+// Removing while walking the table works back to front: the entry moved
+// into the hole has already been visited.
+template <typename T>
+class ClientTable {
+public:
+    size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+
+    T& operator[](size_t index) { return m_items[index]; }
+    const T& operator[](size_t index) const { return m_items[index]; }
+    typename std::vector<T>::iterator begin() { return m_items.begin(); }
+    typename std::vector<T>::iterator end() { return m_items.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_items.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_items.end(); }
+
+    // Constructs an entry for key; nullptr if the key is already in use
+    template <typename... Args>
+    T* emplace(uint64_t key, Args&&... args) {
+        if (m_byKey.count(key)) {
+            return nullptr;
+        }
+
+        uint32_t slot;
+        if (!m_freeSlots.empty()) {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot());
+        }
+        m_slots[slot].index = static_cast<uint32_t>(m_items.size());
+        m_items.emplace_back(std::forward<Args>(args)...);
+        m_keys.push_back(key);
+        m_itemSlots.push_back(slot);
+        m_byKey.emplace(key, slot);
+        return &m_items.back();
+    }
+
+    T* find(uint64_t key) {
+        auto it = m_byKey.find(key);
+        return it == m_byKey.end() ? nullptr : &m_items[m_slots[it->second].index];
+    }
+
+    T* get(ClientId id) {
+        uint32_t slot = slotOf(id);
+        return slot == NIL ? nullptr : &m_items[m_slots[slot].index];
+    }
+
+    // Id of an entry in the table, from a reference or a position
+    ClientId idOf(const T& item) const { return idAt(static_cast<size_t>(&item - m_items.data())); }
+    ClientId idAt(size_t index) const {
+        uint32_t slot = m_itemSlots[index];
+        return (static_cast<uint64_t>(m_slots[slot].gen) << 32) | (slot + 1);
+    }
+
+    bool remove(uint64_t key) {
+        auto it = m_byKey.find(key);
+        if (it == m_byKey.end()) {
+            return false;
+        }
+        removeAt(m_slots[it->second].index);
+        return true;
+    }
+
+    // Removes the entry at a position; the last entry takes its place
+    void removeAt(size_t index) {
+        uint32_t slot = m_itemSlots[index];
+        m_byKey.erase(m_keys[index]);
+        m_slots[slot].index = NIL;
+        m_slots[slot].gen++;
+        m_freeSlots.push_back(slot);
+
+        size_t last = m_items.size() - 1;
+        if (index != last) {
+            m_items[index] = std::move(m_items[last]);
+            m_keys[index] = m_keys[last];
+            m_itemSlots[index] = m_itemSlots[last];
+            m_slots[m_itemSlots[index]].index = static_cast<uint32_t>(index);
+        }
+        m_items.pop_back();
+        m_keys.pop_back();
+        m_itemSlots.pop_back();
+    }
+
+    // Removes everything; ids handed out before stay dead
+    void clear() {
+        for (uint32_t slot : m_itemSlots) {
+            m_slots[slot].index = NIL;
+            m_slots[slot].gen++;
+            m_freeSlots.push_back(slot);
+        }
+        m_items.clear();
+        m_keys.clear();
+        m_itemSlots.clear();
+        m_byKey.clear();
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Slot {
+        uint32_t index = NIL;  // position in m_items, NIL while free
+        uint32_t gen = 1;
+    };
+
+    uint32_t slotOf(ClientId id) const {
+        uint32_t slot = static_cast<uint32_t>(id) - 1;
+        if (id == 0 || slot >= m_slots.size()) {
+            return NIL;
+        }
+        const Slot& s = m_slots[slot];
+        return s.index != NIL && s.gen == static_cast<uint32_t>(id >> 32) ? slot : NIL;
+    }
+
+    // Parallel to m_items
+    std::vector<T> m_items;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_itemSlots;
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<uint64_t, uint32_t> m_byKey;
+};
+
+#endif // CLIENT_TABLE_HPP
@@ -1,4 +1,5 @@
 #include "config.hpp"
+#include "vconsole_protocol.hpp"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -72,6 +73,10 @@ bool loadConfig(const std::string& path, VConsoleConfig& config) {
 
         if (line[0] == '[' && line.back() == ']') {
             currentSection = line.substr(1, line.length() - 2);
+            if (currentSection.compare(0, 9, "listener.") == 0) {
+                config.listeners.emplace_back();
+                config.listeners.back().name = currentSection.substr(9);
+            }
             continue;
         }
 
@@ -86,7 +91,7 @@ bool loadConfig(const std::string& path, VConsoleConfig& config) {
         if (currentSection == "vconsole") {
             if (key == "port") {
                 int port = std::stoi(value);
-                if (port > 0 && port <= 65535) {
+                if (port >= 0 && port <= 65535) {
                     config.port = static_cast<uint16_t>(port);
                 }
             } else if (key == "bind") {
@@ -95,6 +100,150 @@ bool loadConfig(const std::string& path, VConsoleConfig& config) {
                 config.max_connections = std::stoi(value);
             } else if (key == "logging") {
                 config.logging = (std::stoi(value) != 0);
+            } else if (key == "cmd_rate") {
+                double rate = std::stod(value);
+                if (rate >= 0.0) {
+                    config.cmd_rate = rate;
+                }
+            } else if (key == "metrics_port") {
+                int port = std::stoi(value);
+                if (port >= 0 && port <= 65535) {
+                    config.metrics_port = static_cast<uint16_t>(port);
+                }
+            } else if (key == "metrics_bind") {
+                config.metrics_bind = value;
+            } else if (key == "sink_file") {
+                config.sink_file = value;
+            } else if (key == "sink_format") {
+                if (value == "json" || value == "binary") {
+                    config.sink_format = value;
+                }
+            } else if (key == "sink_rotate_mb") {
+                int mb = std::stoi(value);
+                if (mb >= 0) {
+                    config.sink_rotate_mb = mb;
+                }
+            } else if (key == "sink_keep") {
+                int keep = std::stoi(value);
+                if (keep >= 0) {
+                    config.sink_keep = keep;
+                }
+            } else if (key == "io_backend") {
+                if (value == "auto" || value == "io_uring" || value == "epoll" || value == "poll") {
+                    config.io_backend = value;
+                }
+            } else if (key == "tick_budget_us") {
+                int us = std::stoi(value);
+                if (us >= 0) {
+                    config.tick_budget_us = us;
+                }
+            } else if (key == "shm_ring") {
+                if (value.empty() || (value[0] == '/' && value.find('/', 1) == std::string::npos)) {
+                    config.shm_ring = value;
+                }
+            } else if (key == "shm_ring_kb") {
+                int kb = std::stoi(value);
+                if (kb >= 64) {
+                    config.shm_ring_kb = kb;
+                }
+            } else if (key == "status_interval_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.status_interval_ms = ms;
+                }
+            } else if (key == "reload_handoff") {
+                config.reload_handoff = (std::stoi(value) != 0);
+            } else if (key == "shutdown_drain_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.shutdown_drain_ms = ms;
+                }
+            } else if (key == "idle_timeout_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.idle_timeout_ms = ms;
+                }
+            } else if (key == "keepalive_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.keepalive_ms = ms;
+                }
+            } else if (key == "send_timeout_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.send_timeout_ms = ms;
+                }
+            } else if (key == "capture_rate") {
+                double rate = std::stod(value);
+                if (rate >= 0.0) {
+                    config.capture_rate = rate;
+                }
+            } else if (key == "capture_burst") {
+                int burst = std::stoi(value);
+                if (burst > 0) {
+                    config.capture_burst = burst;
+                }
+            } else if (key == "capture_sample") {
+                int sample = std::stoi(value);
+                if (sample >= 0) {
+                    config.capture_sample = sample;
+                }
+            } else if (key == "capture_summary_ms") {
+                int ms = std::stoi(value);
+                if (ms > 0) {
+                    config.capture_summary_ms = ms;
+                }
+            } else if (key == "repeat_window_ms") {
+                int ms = std::stoi(value);
+                if (ms >= 0) {
+                    config.repeat_window_ms = ms;
+                }
+            } else if (key == "ansi_colors") {
+                config.ansi_colors = (std::stoi(value) != 0);
+            } else if (key == "latency_debug") {
+                config.latency_debug = (std::stoi(value) != 0);
+            } else if (key == "cmd_burst") {
+                int burst = std::stoi(value);
+                if (burst > 0) {
+                    config.cmd_burst = burst;
+                }
+            }
+        } else if (currentSection.compare(0, 9, "listener.") == 0) {
+            ListenerConfig& listener = config.listeners.back();
+            if (key == "port") {
+                int port = std::stoi(value);
+                if (port > 0 && port <= 65535) {
+                    listener.port = static_cast<uint16_t>(port);
+                }
+            } else if (key == "bind") {
+                listener.bind = value;
+            } else if (key == "max_connections") {
+                int max = std::stoi(value);
+                if (max >= 0) {
+                    listener.max_connections = max;
+                }
+            } else if (key == "cmd_rate") {
+                double rate = std::stod(value);
+                if (rate >= 0.0) {
+                    listener.cmd_rate = rate;
+                }
+            } else if (key == "cmd_burst") {
+                int burst = std::stoi(value);
+                if (burst > 0) {
+                    listener.cmd_burst = burst;
+                }
+            } else if (key == "read_only") {
+                listener.read_only = (std::stoi(value) != 0);
+            } else if (key == "channels") {
+                uint32_t mask;
+                if (parseChannelMask(value, mask)) {
+                    listener.channels = value;
+                }
+            } else if (key == "max_backlog_kb") {
+                int kb = std::stoi(value);
+                if (kb >= 64) {
+                    listener.max_backlog_kb = kb;
+                }
             }
         }
     }
@@ -2,13 +2,54 @@
 #define CONFIG_HPP
 
 #include <string>
+#include <vector>
 #include <cstdint>
 
+// A [listener.NAME] section: another port with its own policy, served
+// alongside the one from [vconsole]
+struct ListenerConfig {
+    std::string name;
+    uint16_t port = 0;           // required
+    std::string bind = "127.0.0.1";
+    int max_connections = 1;     // 0 = unlimited
+    double cmd_rate = 5.0;       // 0 = unlimited
+    int cmd_burst = 10;
+    bool read_only = false;      // refuse commands and cvar queries
+    std::string channels = "all";  // comma-separated channel names
+    int max_backlog_kb = 4096;   // unsent output per client before frames are dropped
+};
+
 struct VConsoleConfig {
-    uint16_t port = 29000;
+    uint16_t port = 29000;       // 0 = only the [listener.*] sections
     std::string bind = "127.0.0.1";
     int max_connections = 1;  // 0 = unlimited
     bool logging = true;
+    double cmd_rate = 5.0;    // commands per second per client, 0 = unlimited
+    int cmd_burst = 10;       // commands a client may send back-to-back
+    bool latency_debug = false;  // append ingest timestamps to PRNT frames
+    uint16_t metrics_port = 0;   // Prometheus endpoint, 0 = disabled
+    std::string metrics_bind = "127.0.0.1";
+    std::string sink_file;       // structured log of captured output, empty = disabled
+    std::string sink_format = "json";  // "json" or "binary"
+    int sink_rotate_mb = 64;     // rotate once the file reaches this size, 0 = never
+    int sink_keep = 5;           // rotated files to keep
+    std::string io_backend = "auto";  // "auto", "io_uring", "epoll" or "poll"
+    int tick_budget_us = 0;      // plugin time per server frame, 0 = unlimited
+    std::string shm_ring;        // shared-memory ring name such as "/vconsole", empty = disabled
+    int shm_ring_kb = 1024;      // ring data size, rounded up to a power of two
+    int status_interval_ms = 1000;  // STAT push interval for subscribers, 0 = disabled
+    bool reload_handoff = true;  // keep client connections across plugin reloads
+    int shutdown_drain_ms = 1000;  // flush pending output on unload/quit for up to this long
+    int idle_timeout_ms = 0;       // close clients that sent nothing for this long, 0 = never
+    int keepalive_ms = 15000;      // PING interval for keepalive subscribers, 0 = disabled
+    int send_timeout_ms = 30000;   // close clients whose output is stuck for this long, 0 = never
+    bool ansi_colors = true;       // turn ANSI colors in captured stdout/stderr into PRNT colors
+    int repeat_window_ms = 0;      // collapse repeated lines, summarising once per window, 0 = off
+    double capture_rate = 1000.0;  // lines per second per emitter sent to clients, 0 = unlimited
+    int capture_burst = 5000;      // lines an emitter may capture back-to-back
+    int capture_sample = 100;      // over budget, let every Nth line through, 0 = drop all
+    int capture_summary_ms = 5000; // report suppressed lines per emitter this often
+    std::vector<ListenerConfig> listeners;
 };
 
 bool loadConfig(const std::string& path, VConsoleConfig& config);
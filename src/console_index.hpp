@@ -0,0 +1,274 @@
+#ifndef CONSOLE_INDEX_HPP
+#define CONSOLE_INDEX_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "vconsole_protocol.hpp"
+
+// Names of the server's cvars and commands, for completion without running
+// cvarlist/cmdlist. Entries are kept in one array sorted by lowercased name
+// (the engine matches names case-insensitively), so a prefix is a contiguous
+// range found with two binary searches. Registrations are rare and only
+// happen at startup or map change, so inserting into the array is fine.
+enum ConsoleEntryKind : uint8_t {
+    CONSOLE_CVAR = 1u << 0,
+    CONSOLE_COMMAND = 1u << 1
+};
+
+class ConsoleIndex {
+public:
+    struct Entry {
+        std::string key;    // lowercased name, the sort key
+        std::string name;
+        ConsoleEntryKind kind;
+        const void* handle; // the engine's cvar_t for cvars, so values need no lookup by name
+    };
+
+    // False if the name is already indexed
+    bool add(std::string_view name, ConsoleEntryKind kind, const void* handle = nullptr) {
+        if (name.empty()) {
+            return false;
+        }
+        std::string key = lowercase(name);
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key,
+            [](const Entry& e, const std::string& k) { return e.key < k; });
+        if (it != m_entries.end() && it->key == key) {
+            return false;
+        }
+        m_entries.insert(it, Entry{std::move(key), std::string(name), kind, handle});
+        return true;
+    }
+
+    // Appends up to maxResults entries of the given kinds whose names start
+    // with prefix, in order, and returns how many match in total
+    size_t complete(std::string_view prefix, size_t maxResults, uint8_t kinds,
+                    std::vector<const Entry*>& out) const {
+        std::string key = lowercase(prefix);
+        auto first = std::lower_bound(m_entries.begin(), m_entries.end(), key,
+            [](const Entry& e, const std::string& k) { return e.key < k; });
+        auto last = std::partition_point(first, m_entries.end(),
+            [&key](const Entry& e) { return e.key.compare(0, key.size(), key) == 0; });
+
+        size_t total = 0;
+        for (auto it = first; it != last; ++it) {
+            if (!(it->kind & kinds)) {
+                continue;
+            }
+            if (total < maxResults) {
+                out.push_back(&*it);
+            }
+            total++;
+        }
+        return total;
+    }
+
+    const Entry* find(std::string_view name) const {
+        std::string key = lowercase(name);
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key,
+            [](const Entry& e, const std::string& k) { return e.key < k; });
+        return it != m_entries.end() && it->key == key ? &*it : nullptr;
+    }
+
+    size_t size() const { return m_entries.size(); }
+    size_t count(ConsoleEntryKind kind) const {
+        return std::count_if(m_entries.begin(), m_entries.end(), [kind](const Entry& e) { return e.kind == kind; });
+    }
+
+private:
+    static std::string lowercase(std::string_view s) {
+        std::string out(s);
+        for (char& c : out) {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        return out;
+    }
+
+    std::vector<Entry> m_entries;
+};
+
+// Completion and cvar queries, big-endian like the rest of the protocol.
+// Each request carries a client-chosen u32 id that the reply echoes.
+//
+//   CMPL  u32 id, u16 max results, u8 kind mask (0 = all), prefix bytes
+//   CMPR  u32 id, u16 total matches, u16 count, count x (u8 kind, u8 len, name)
+//   CVRQ  u32 id, u16 count, count x (u8 len, name)
+//   CVRS  u32 id, u16 count, count x (u8 found, u8 len, name, u16 len, value)
+//
+// CMPR lists at most max results but reports every match in total. A reply
+// that would not fit in one frame is cut short; count says how many entries
+// it holds.
+constexpr size_t VCON_CMPL_HEADER_SIZE = 7;
+constexpr size_t VCON_CVRQ_HEADER_SIZE = 6;
+
+struct CompletionRequest {
+    uint32_t id;
+    uint16_t maxResults;
+    uint8_t kinds;
+    std::string_view prefix;
+};
+
+struct CvarValue {
+    std::string_view name;
+    const char* value;  // nullptr if there is no such cvar
+};
+
+inline void appendCMPLFrame(std::vector<uint8_t>& out, uint32_t id, std::string_view prefix, uint16_t maxResults,
+                            uint8_t kinds = 0) {
+    std::vector<uint8_t> payload;
+    appendBE32(payload, id);
+    appendBE16(payload, maxResults);
+    payload.push_back(kinds);
+    payload.insert(payload.end(), prefix.begin(), prefix.end());
+    appendFrame(out, "CMPL", payload.data(), payload.size());
+}
+
+// A trailing NUL on the prefix is accepted and dropped
+inline bool parseCMPL(const uint8_t* p, size_t len, CompletionRequest& request) {
+    if (len < VCON_CMPL_HEADER_SIZE) {
+        return false;
+    }
+    request.id = getBE32(p);
+    request.maxResults = getBE16(p + 4);
+    request.kinds = p[6] ? p[6] : (CONSOLE_CVAR | CONSOLE_COMMAND);
+    const char* prefix = reinterpret_cast<const char*>(p + VCON_CMPL_HEADER_SIZE);
+    request.prefix = std::string_view(prefix, strnlen(prefix, len - VCON_CMPL_HEADER_SIZE));
+    return true;
+}
+
+// Replaces out with one CMPR frame; out keeps its capacity between replies
+inline void encodeCMPRFrame(std::vector<uint8_t>& out, uint32_t id, size_t total,
+                            const std::vector<const ConsoleIndex::Entry*>& entries) {
+    out.resize(sizeof(VConChunk));
+    appendBE32(out, id);
+    appendBE16(out, static_cast<uint16_t>(std::min<size_t>(total, 0xFFFF)));
+    appendBE16(out, 0);
+
+    size_t count = 0;
+    for (const ConsoleIndex::Entry* entry : entries) {
+        if (out.size() + 2 + std::min<size_t>(entry->name.size(), 255) > VCON_MAX_FRAME_SIZE || count == 0xFFFF) {
+            break;
+        }
+        out.push_back(entry->kind);
+        appendString8(out, entry->name);
+        count++;
+    }
+    putBE16(out.data() + sizeof(VConChunk) + 6, static_cast<uint16_t>(count));
+    writeFrameHeader(out.data(), "CMPR", out.size() - sizeof(VConChunk));
+}
+
+inline void appendCVRQFrame(std::vector<uint8_t>& out, uint32_t id, const std::vector<std::string>& names) {
+    std::vector<uint8_t> payload;
+    appendBE32(payload, id);
+    appendBE16(payload, static_cast<uint16_t>(names.size()));
+    for (const std::string& name : names) {
+        appendString8(payload, name);
+    }
+    appendFrame(out, "CVRQ", payload.data(), payload.size());
+}
+
+// Names are views into the payload; false if it is truncated
+inline bool parseCVRQ(const uint8_t* p, size_t len, uint32_t& id, std::vector<std::string_view>& names) {
+    if (len < VCON_CVRQ_HEADER_SIZE) {
+        return false;
+    }
+    id = getBE32(p);
+    uint16_t count = getBE16(p + 4);
+    size_t pos = VCON_CVRQ_HEADER_SIZE;
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos >= len || pos + 1 + p[pos] > len) {
+            return false;
+        }
+        names.emplace_back(reinterpret_cast<const char*>(p + pos + 1), p[pos]);
+        pos += 1 + p[pos];
+    }
+    return true;
+}
+
+// Replaces out with one CVRS frame answering the values in order
+inline void encodeCVRSFrame(std::vector<uint8_t>& out, uint32_t id, const std::vector<CvarValue>& values) {
+    out.resize(sizeof(VConChunk));
+    appendBE32(out, id);
+    appendBE16(out, 0);
+
+    size_t count = 0;
+    for (const CvarValue& cvar : values) {
+        std::string_view value = cvar.value ? std::string_view(cvar.value) : std::string_view();
+        size_t valueLen = utf8SplitPoint(value.data(), value.size(), 0xFFFF);
+        if (out.size() + 4 + std::min<size_t>(cvar.name.size(), 255) + valueLen > VCON_MAX_FRAME_SIZE) {
+            break;
+        }
+        out.push_back(cvar.value ? 1 : 0);
+        appendString8(out, cvar.name);
+        appendBE16(out, static_cast<uint16_t>(valueLen));
+        out.insert(out.end(), value.data(), value.data() + valueLen);
+        count++;
+    }
+    putBE16(out.data() + sizeof(VConChunk) + 4, static_cast<uint16_t>(count));
+    writeFrameHeader(out.data(), "CVRS", out.size() - sizeof(VConChunk));
+}
+
+// Client side decoders for the replies
+
+struct CompletionMatch {
+    ConsoleEntryKind kind;
+    std::string name;
+};
+
+inline bool parseCMPR(const uint8_t* p, size_t len, uint32_t& id, uint16_t& total,
+                      std::vector<CompletionMatch>& matches) {
+    if (len < 8) {
+        return false;
+    }
+    id = getBE32(p);
+    total = getBE16(p + 4);
+    uint16_t count = getBE16(p + 6);
+    size_t pos = 8;
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos + 2 > len || pos + 2 + p[pos + 1] > len) {
+            return false;
+        }
+        matches.push_back({static_cast<ConsoleEntryKind>(p[pos]),
+                           std::string(reinterpret_cast<const char*>(p + pos + 2), p[pos + 1])});
+        pos += 2 + p[pos + 1];
+    }
+    return true;
+}
+
+struct CvarResult {
+    bool found;
+    std::string name;
+    std::string value;
+};
+
+inline bool parseCVRS(const uint8_t* p, size_t len, uint32_t& id, std::vector<CvarResult>& results) {
+    if (len < 6) {
+        return false;
+    }
+    id = getBE32(p);
+    uint16_t count = getBE16(p + 4);
+    size_t pos = 6;
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos + 2 > len || pos + 2 + p[pos + 1] + 2 > len) {
+            return false;
+        }
+        CvarResult result;
+        result.found = p[pos] != 0;
+        result.name.assign(reinterpret_cast<const char*>(p + pos + 2), p[pos + 1]);
+        pos += 2 + p[pos + 1];
+        uint16_t valueLen = getBE16(p + pos);
+        pos += 2;
+        if (pos + valueLen > len) {
+            return false;
+        }
+        result.value.assign(reinterpret_cast<const char*>(p + pos), valueLen);
+        pos += valueLen;
+        results.push_back(std::move(result));
+    }
+    return true;
+}
+
+#endif // CONSOLE_INDEX_HPP
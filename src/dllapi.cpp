@@ -3,6 +3,9 @@
 #include "vconsole_server.hpp"
 
 void dll_pfnStartFrame();
+void dll_pfnGameShutdown();
+void dll_pfnServerActivate_Post(edict_t* pEdictList, int edictCount, int clientMax);
+void indexConsoleNames();
 
 DLL_FUNCTIONS g_DllFunctionTable =
 {
@@ -81,7 +84,7 @@ DLL_FUNCTIONS g_DllFunctionTable_Post =
 	NULL,					// pfnClientPutInServer
 	NULL,					// pfnClientCommand
 	NULL,					// pfnClientUserInfoChanged
-	NULL,					// pfnServerActivate
+	dll_pfnServerActivate_Post,	// pfnServerActivate
 	NULL,					// pfnServerDeactivate
 	NULL,					// pfnPlayerPreThink
 	NULL,					// pfnPlayerPostThink
@@ -115,7 +118,7 @@ DLL_FUNCTIONS g_DllFunctionTable_Post =
 NEW_DLL_FUNCTIONS g_NewDllFunctionTable =
 {
 	NULL,					// pfnOnFreeEntPrivateData
-	NULL,					// pfnGameShutdown
+	dll_pfnGameShutdown,	// pfnGameShutdown
 	NULL,					// pfnShouldCollide
 	NULL,					// pfnCvarValue
 	NULL,					// pfnCvarValue2
@@ -135,6 +138,21 @@ void dll_pfnStartFrame() {
 	VConsoleServer::getInstance().tick();
 }
 
+// quit: the engine is about to exit, possibly without unloading plugins.
+// Clients still get what was queued, including the quit command's own
+// output, within the drain timeout.
+void dll_pfnGameShutdown() {
+	SET_META_RESULT(MRES_IGNORED);
+	VConsoleServer::getInstance().shutdown();
+}
+
+// The game and other plugins register most of their cvars by the time the
+// first map is running; pick up any the engine hooks did not see
+void dll_pfnServerActivate_Post(edict_t*, int, int) {
+	SET_META_RESULT(MRES_IGNORED);
+	indexConsoleNames();
+}
+
 C_DLLEXPORT int GetEntityAPI2(DLL_FUNCTIONS *pFunctionTable, int *interfaceVersion)
 {
 	if (!pFunctionTable) {
@@ -0,0 +1,41 @@
+#ifndef ENCODE_SCRATCH_HPP
+#define ENCODE_SCRATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "metrics.hpp"
+
+// Buffer that outgoing frames are encoded into before they are copied into
+// each client's output buffer. Nothing encoded into it outlives that copy,
+// so one buffer serves every line; it grows to the largest line seen and
+// then never touches the heap again. Each growth is counted in
+// g_metrics.pipelineHeapAllocs.
+class EncodeScratch {
+public:
+    uint8_t* get(size_t size) {
+        if (size > m_buffer.size()) {
+            m_buffer.resize(size);
+            metricAdd(g_metrics.pipelineHeapAllocs);
+        }
+        return m_buffer.data();
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+// Runs an append on a buffer that is reused across frames and counts the
+// append if it had to reallocate
+template <typename Buffer, typename Append>
+inline void appendTracked(Buffer& buffer, Append&& append) {
+    size_t capacity = buffer.capacity();
+    append();
+    if (buffer.capacity() != capacity) {
+        metricAdd(g_metrics.pipelineHeapAllocs);
+    }
+}
+
+#endif // ENCODE_SCRATCH_HPP
@@ -1,6 +1,7 @@
 #include <extdll.h>
 #include <meta_api.h>
 #include "vconsole_server.hpp"
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <string>
@@ -10,42 +11,163 @@ extern enginefuncs_t g_engfuncs;
 
 void ServerPrint_Post(const char* msg)
 {
+	VConsoleServer& server = VConsoleServer::getInstance();
+	if (!server.wantsOutput()) {
+		RETURN_META(MRES_IGNORED);
+	}
+
+	uint64_t ingestNs = monotonicNanos();
 	if (msg && msg[0] && msg[0] != '\n') {
-		std::string clean(msg);
+		std::string_view clean(msg);
 		while (!clean.empty() && (clean.back() == '\n' || clean.back() == '\r')) {
-			clean.pop_back();
+			clean.remove_suffix(1);
 		}
 		if (!clean.empty()) {
-			VConsoleServer::getInstance().broadcastPrint(clean);
+			server.captureLine(CAPTURE_PRINT, clean, 0, 0xFFFFFFFF, ingestNs);
 		}
 	}
 	RETURN_META(MRES_IGNORED);
 }
 
+// Channel for each ALERT_TYPE, in enum order
+static const ConsoleChannelId s_alertChannels[] = {
+	CHANNEL_NOTICE,		// at_notice
+	CHANNEL_DEVELOPER,	// at_console
+	CHANNEL_DEVELOPER,	// at_aiconsole
+	CHANNEL_WARNING,	// at_warning
+	CHANNEL_ERROR,		// at_error
+	CHANNEL_LOG,		// at_logged
+};
+
+// Whether the engine's own AlertMessage prints this type: at_logged goes to
+// the server log regardless, everything else only with developer set, and
+// at_aiconsole only from developer 2. Viewers see what its console shows.
+static bool alertShown(ALERT_TYPE atype)
+{
+	if (atype == at_logged) {
+		return true;
+	}
+	static cvar_t* s_developer = NULL;
+	if (!s_developer) {
+		s_developer = CVAR_GET_POINTER("developer");
+	}
+	float level = s_developer ? s_developer->value : 0.0f;
+	return atype == at_aiconsole ? level >= 2.0f : level != 0.0f;
+}
+
 void AlertMessage_Post(ALERT_TYPE atype, const char* szFmt, ...)
 {
-	if (atype != at_logged)
+	VConsoleServer& server = VConsoleServer::getInstance();
+	if (!server.wantsOutput() || !szFmt ||
+		atype < 0 || static_cast<size_t>(atype) >= sizeof(s_alertChannels) / sizeof(s_alertChannels[0]))
 	{
 		RETURN_META(MRES_IGNORED);
 	}
+	if (!alertShown(atype)) {
+		RETURN_META(MRES_IGNORED);
+	}
+
+	uint64_t ingestNs = monotonicNanos();
+	const ConsoleChannel& channel = VCON_CHANNELS[s_alertChannels[atype]];
 
-	char buffer[1024];
 	va_list args;
 	va_start(args, szFmt);
-	vsnprintf(buffer, sizeof(buffer), szFmt, args);
+	std::string_view text = server.formatCapture(szFmt, args);
 	va_end(args);
 
-	size_t len = strlen(buffer);
-	while (len > 0 && (buffer[len-1] == '\n' || buffer[len-1] == '\r')) {
-		buffer[--len] = '\0';
+	while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+		text.remove_suffix(1);
+	}
+
+	if (!text.empty()) {
+		// Budgeted per call site, which the format string tells apart
+		server.captureLine(CAPTURE_ALERT, text, channel.id, channel.color, ingestNs, {}, szFmt);
 	}
+	RETURN_META(MRES_IGNORED);
+}
 
-	if (len > 0) {
-		VConsoleServer::getInstance().broadcastPrint(buffer);
+// Cvars and commands registered through the engine API after the plugin has
+// loaded (the game DLL's, and other plugins' that go through Metamod) are
+// added to the completion index as they appear
+void CVarRegister_Post(cvar_t* pCvar)
+{
+	if (pCvar && pCvar->name) {
+		VConsoleServer::getInstance().getConsoleIndex().add(pCvar->name, CONSOLE_CVAR, pCvar);
+	}
+	RETURN_META(MRES_IGNORED);
+}
+
+void AddServerCommand_Post(char* cmd_name, void (*)(void))
+{
+	if (cmd_name) {
+		VConsoleServer::getInstance().getConsoleIndex().add(cmd_name, CONSOLE_COMMAND);
 	}
 	RETURN_META(MRES_IGNORED);
 }
 
+// Cvars the engine registers on every dedicated server, early in name
+// order. Its cvar list is singly linked with no way to reach the head, so
+// it is walked on from each of these; together they cover the engine's own
+// cvars, the rest having come through CVarRegister_Post.
+static const char* const s_engineCvars[] = {
+	"coop", "deathmatch", "developer", "edgefriction", "hostname", "mapcyclefile", "sv_gravity",
+};
+
+// Commands built into the engine, which the engine API has no way to list
+static const char* const s_engineCommands[] = {
+	"addip", "alias", "banid", "changelevel", "changelevel2", "cmd", "cmdlist", "condump", "cvarlist",
+	"echo", "edicts", "exec", "exit", "heartbeat", "kick", "listid", "listip", "localinfo", "log",
+	"logaddress", "logaddress_add", "logaddress_del", "logaddress_delall", "map", "maps", "quit",
+	"reload", "removeid", "removeip", "restart", "say", "serverinfo", "setmaster", "stats", "status",
+	"stuffcmds", "users", "version", "wait", "writeid", "writeip",
+};
+
+// Adds everything the hooks cannot have seen: engine commands and cvars
+// registered before the plugin loaded or by code calling the engine
+// directly. Run at load and again on every map start; names already indexed
+// are skipped, so the index only ever grows incrementally.
+void indexConsoleNames()
+{
+	ConsoleIndex& index = VConsoleServer::getInstance().getConsoleIndex();
+
+	for (const char* name : s_engineCommands) {
+		index.add(name, CONSOLE_COMMAND);
+	}
+
+	cvar_t* starts[sizeof(s_engineCvars) / sizeof(s_engineCvars[0])];
+	size_t startCount = 0;
+	for (const char* name : s_engineCvars) {
+		if (cvar_t* start = CVAR_GET_POINTER(name)) {
+			starts[startCount++] = start;
+		}
+	}
+
+	// Each walk stops where another one starts, so no stretch of the list is
+	// visited twice
+	cvar_t** startsEnd = starts + startCount;
+	for (cvar_t** start = starts; start != startsEnd; start++) {
+		for (cvar_t* cvar = *start; cvar; cvar = cvar->next) {
+			if (cvar != *start && std::find(starts, startsEnd, cvar) != startsEnd) {
+				break;
+			}
+			if (cvar->name) {
+				index.add(cvar->name, CONSOLE_CVAR, cvar);
+			}
+		}
+	}
+}
+
+// CVRQ values come from the cvar_t itself when it is indexed; unknown names
+// fall back to the engine's lookup so nothing is missed
+const char* readCvarValue(const ConsoleIndex::Entry* entry, const char* name)
+{
+	const cvar_t* cvar = entry ? static_cast<const cvar_t*>(entry->handle) : NULL;
+	if (!cvar) {
+		cvar = CVAR_GET_POINTER(name);
+	}
+	return cvar ? cvar->string : NULL;
+}
+
 enginefuncs_t g_EngineFunctionsTable = {
 	NULL,	// pfnPrecacheModel
 	NULL,	// pfnPrecacheSound
@@ -264,7 +386,7 @@ enginefuncs_t g_EngineFunctionsTable_Post = {
 	NULL,	// pfnWriteCoord
 	NULL,	// pfnWriteString
 	NULL,	// pfnWriteEntity
-	NULL,	// pfnCVarRegister
+	CVarRegister_Post,	// pfnCVarRegister
 	NULL,	// pfnCVarGetFloat
 	NULL,	// pfnCVarGetString
 	NULL,	// pfnCVarSetFloat
@@ -308,7 +430,7 @@ enginefuncs_t g_EngineFunctionsTable_Post = {
 	NULL,	// pfnEndSection
 	NULL,	// pfnCompareFileTime
 	NULL,	// pfnGetGameDir
-	NULL,	// pfnCvar_RegisterVariable
+	CVarRegister_Post,	// pfnCvar_RegisterVariable
 	NULL,	// pfnFadeClientVolume
 	NULL,	// pfnSetClientMaxspeed
 	NULL,	// pfnCreateFakeClient
@@ -348,7 +470,7 @@ enginefuncs_t g_EngineFunctionsTable_Post = {
 	NULL,	// pfnCvar_DirectSet
 	NULL,	// pfnForceUnmodified
 	NULL,	// pfnGetPlayerStats
-	NULL,	// pfnAddServerCommand
+	AddServerCommand_Post,	// pfnAddServerCommand
 	NULL,	// pfnVoice_GetClientListening
 	NULL,	// pfnVoice_SetClientListening
 	NULL,	// pfnGetPlayerAuthId
@@ -0,0 +1,114 @@
+#include "handoff.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void handoffName(char* name, size_t size) {
+    snprintf(name, size, "/vconsole-handoff-%ld", static_cast<long>(getpid()));
+}
+
+// Descriptor of a published blob, found by the name its unlinked object
+// still shows in /proc/self/fd, or -1
+static int findHandoffFd() {
+    char name[64];
+    handoffName(name, sizeof(name));
+    size_t nameLen = strlen(name);
+
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) {
+        return -1;
+    }
+    int found = -1;
+    while (dirent* entry = readdir(dir)) {
+        char* end = nullptr;
+        long fd = strtol(entry->d_name, &end, 10);
+        if (end == entry->d_name || *end != '\0' || fd == dirfd(dir)) {
+            continue;
+        }
+        char path[64];
+        char target[256];
+        snprintf(path, sizeof(path), "/proc/self/fd/%ld", fd);
+        ssize_t n = readlink(path, target, sizeof(target) - 1);
+        if (n <= 0) {
+            continue;
+        }
+        target[n] = '\0';
+        // "/dev/shm/vconsole-handoff-<pid> (deleted)"
+        const char* base = strrchr(target, '/');
+        if (base && strncmp(base, name, nameLen) == 0 && (base[nameLen] == '\0' || base[nameLen] == ' ')) {
+            found = static_cast<int>(fd);
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+bool publishHandoff(const std::vector<uint8_t>& blob) {
+    // A blob left behind by a reload that never completed is superseded
+    for (int stale = findHandoffFd(); stale != -1; stale = findHandoffFd()) {
+        close(stale);
+    }
+
+    char name[64];
+    handoffName(name, sizeof(name));
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    // Only the descriptor is needed from here on, so nothing is left in
+    // /dev/shm even if the process dies before the blob is taken
+    shm_unlink(name);
+
+    size_t done = 0;
+    while (done < blob.size()) {
+        ssize_t n = pwrite(fd, blob.data() + done, blob.size() - done, static_cast<off_t>(done));
+        if (n <= 0) {
+            close(fd);
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool takeHandoff(std::vector<uint8_t>& blob) {
+    int fd = findHandoffFd();
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+    if (ok) {
+        blob.resize(static_cast<size_t>(st.st_size));
+        size_t done = 0;
+        while (ok && done < blob.size()) {
+            ssize_t n = pread(fd, blob.data() + done, blob.size() - done, static_cast<off_t>(done));
+            ok = n > 0;
+            done += ok ? static_cast<size_t>(n) : 0;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+#else
+
+bool publishHandoff(const std::vector<uint8_t>&) {
+    return false;
+}
+
+bool takeHandoff(std::vector<uint8_t>&) {
+    return false;
+}
+
+#endif
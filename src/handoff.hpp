@@ -0,0 +1,330 @@
+#ifndef HANDOFF_HPP
+#define HANDOFF_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "vconsole_protocol.hpp"
+
+// What one plugin instance passes to the next on a reload, so clients keep
+// their connections. Both instances live in the same process, so sockets
+// travel as plain descriptor numbers; the blob only has to survive the old
+// module being unloaded. It is versioned so a newer build can tell a blob it
+// does not understand from a broken one and fall back to a clean start.
+//
+// Blob, big-endian:
+//   "VCHO", u32 version, u32 pid, u64 created (monotonic ns),
+//   u32 socket count, sockets x i32,
+//   u32 listener count, listeners x (str name, i32 socket (-1 = closed),
+//     u16 port, str bind address),
+//   u64 scrollback total, u32 line count, lines x (str text, i32 channel, u32 color,
+//     u32 run count, runs x (u32 offset, u32 color)),
+//   u32 client count, clients x (i32 socket, str listener name, str ip,
+//     u16 port, u32 topics, u64 commands queued, u64 commands throttled,
+//     u64 frames dropped, u64 next scrollback line, str unsent output,
+//     str unread input),
+//   u32 command count, commands x (str command, str source)
+// where str is a u32 length followed by the bytes. Everything up to the
+// socket list is the same in every version, so a blob this build cannot
+// otherwise read still tells it which descriptors to close.
+constexpr uint32_t VCON_HANDOFF_VERSION = 5;
+
+// A blob older than this is from an instance that never got replaced; its
+// sockets are closed instead of adopted
+constexpr uint64_t VCON_HANDOFF_MAX_AGE_NS = 30ull * 1000000000ull;
+
+struct HandoffLine {
+    std::string text;
+    int32_t channelId;
+    uint32_t color;
+    std::vector<ColorRun> runs;
+};
+
+// Clients are matched to the new instance's listeners by name
+struct HandoffListener {
+    std::string name;
+    int32_t socket;
+    uint16_t port;
+    std::string bindAddr;
+};
+
+struct HandoffClient {
+    int32_t socket;
+    std::string listener;
+    std::string ip;
+    uint16_t port;
+    uint32_t topics;
+    uint64_t commandsQueued;
+    uint64_t commandsThrottled;
+    uint64_t framesDropped;
+    uint64_t scrollbackNext;
+    // Whole frames not yet written to the socket, in order
+    std::vector<uint8_t> unsent;
+    // Start of a frame the client has not finished sending
+    std::vector<uint8_t> unread;
+};
+
+struct HandoffCommand {
+    std::string command;
+    std::string source;
+};
+
+struct HandoffState {
+    uint32_t pid = 0;
+    uint64_t createdNs = 0;
+    std::vector<HandoffListener> listeners;
+    uint64_t scrollbackTotal = 0;
+    std::vector<HandoffLine> scrollback;  // oldest first
+    std::vector<HandoffClient> clients;
+    std::vector<HandoffCommand> commands;
+};
+
+inline void appendBE64(std::vector<uint8_t>& out, uint64_t v) {
+    appendBE32(out, static_cast<uint32_t>(v >> 32));
+    appendBE32(out, static_cast<uint32_t>(v));
+}
+
+inline void appendString32(std::vector<uint8_t>& out, std::string_view s) {
+    appendBE32(out, static_cast<uint32_t>(s.size()));
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+inline void encodeHandoff(const HandoffState& state, std::vector<uint8_t>& out) {
+    out.assign({'V', 'C', 'H', 'O'});
+    appendBE32(out, VCON_HANDOFF_VERSION);
+    appendBE32(out, state.pid);
+    appendBE64(out, state.createdNs);
+
+    size_t countOffset = out.size();
+    appendBE32(out, 0);
+    uint32_t sockets = 0;
+    for (const HandoffListener& listener : state.listeners) {
+        if (listener.socket >= 0) {
+            appendBE32(out, static_cast<uint32_t>(listener.socket));
+            sockets++;
+        }
+    }
+    for (const HandoffClient& client : state.clients) {
+        appendBE32(out, static_cast<uint32_t>(client.socket));
+        sockets++;
+    }
+    putBE32(out.data() + countOffset, sockets);
+
+    appendBE32(out, static_cast<uint32_t>(state.listeners.size()));
+    for (const HandoffListener& listener : state.listeners) {
+        appendString32(out, listener.name);
+        appendBE32(out, static_cast<uint32_t>(listener.socket));
+        appendBE16(out, listener.port);
+        appendString32(out, listener.bindAddr);
+    }
+
+    appendBE64(out, state.scrollbackTotal);
+    appendBE32(out, static_cast<uint32_t>(state.scrollback.size()));
+    for (const HandoffLine& line : state.scrollback) {
+        appendString32(out, line.text);
+        appendBE32(out, static_cast<uint32_t>(line.channelId));
+        appendBE32(out, line.color);
+        appendBE32(out, static_cast<uint32_t>(line.runs.size()));
+        for (const ColorRun& run : line.runs) {
+            appendBE32(out, run.offset);
+            appendBE32(out, run.color);
+        }
+    }
+
+    appendBE32(out, static_cast<uint32_t>(state.clients.size()));
+    for (const HandoffClient& client : state.clients) {
+        appendBE32(out, static_cast<uint32_t>(client.socket));
+        appendString32(out, client.listener);
+        appendString32(out, client.ip);
+        appendBE16(out, client.port);
+        appendBE32(out, client.topics);
+        appendBE64(out, client.commandsQueued);
+        appendBE64(out, client.commandsThrottled);
+        appendBE64(out, client.framesDropped);
+        appendBE64(out, client.scrollbackNext);
+        appendBE32(out, static_cast<uint32_t>(client.unsent.size()));
+        out.insert(out.end(), client.unsent.begin(), client.unsent.end());
+        appendBE32(out, static_cast<uint32_t>(client.unread.size()));
+        out.insert(out.end(), client.unread.begin(), client.unread.end());
+    }
+
+    appendBE32(out, static_cast<uint32_t>(state.commands.size()));
+    for (const HandoffCommand& command : state.commands) {
+        appendString32(out, command.command);
+        appendString32(out, command.source);
+    }
+}
+
+// Bounds-checked cursor over a blob; any read past the end clears ok
+class HandoffReader {
+public:
+    HandoffReader(const uint8_t* data, size_t len) : m_p(data), m_left(len), m_ok(true) {}
+
+    bool ok() const { return m_ok; }
+    size_t left() const { return m_left; }
+
+    const uint8_t* take(size_t n) {
+        if (!m_ok || n > m_left) {
+            m_ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = m_p;
+        m_p += n;
+        m_left -= n;
+        return p;
+    }
+
+    uint16_t u16() { const uint8_t* p = take(2); return p ? getBE16(p) : 0; }
+    uint32_t u32() { const uint8_t* p = take(4); return p ? getBE32(p) : 0; }
+    uint64_t u64() {
+        uint64_t hi = u32();
+        return (hi << 32) | u32();
+    }
+    std::string str() {
+        uint32_t len = u32();
+        const uint8_t* p = take(len);
+        return p ? std::string(reinterpret_cast<const char*>(p), len) : std::string();
+    }
+    // Element counts are checked against what is left so a corrupt count
+    // cannot make the decoder reserve gigabytes
+    uint32_t count(size_t minElementSize) {
+        uint32_t n = u32();
+        if (static_cast<uint64_t>(n) * minElementSize > m_left) {
+            m_ok = false;
+            return 0;
+        }
+        return n;
+    }
+
+private:
+    const uint8_t* m_p;
+    size_t m_left;
+    bool m_ok;
+};
+
+// The version-independent start of a blob
+struct HandoffHeader {
+    uint32_t version = 0;
+    uint32_t pid = 0;
+    uint64_t createdNs = 0;
+    std::vector<int32_t> sockets;  // every descriptor the blob hands over
+};
+
+// Reads the header of a blob of any version; false if even that is broken
+inline bool decodeHandoffHeader(const uint8_t* data, size_t len, HandoffHeader& header) {
+    HandoffReader r(data, len);
+    const uint8_t* magic = r.take(4);
+    if (!magic || memcmp(magic, "VCHO", 4) != 0) {
+        return false;
+    }
+    header = HandoffHeader();
+    header.version = r.u32();
+    header.pid = r.u32();
+    header.createdNs = r.u64();
+    uint32_t sockets = r.count(4);
+    header.sockets.reserve(sockets);
+    for (uint32_t i = 0; i < sockets && r.ok(); i++) {
+        header.sockets.push_back(static_cast<int32_t>(r.u32()));
+    }
+    return r.ok();
+}
+
+enum HandoffDecodeResult {
+    HANDOFF_DECODED,
+    HANDOFF_VERSION_MISMATCH,  // valid magic, a version this build does not read
+    HANDOFF_MALFORMED
+};
+
+inline HandoffDecodeResult decodeHandoff(const uint8_t* data, size_t len, HandoffState& state) {
+    HandoffReader r(data, len);
+    const uint8_t* magic = r.take(4);
+    if (!magic || memcmp(magic, "VCHO", 4) != 0) {
+        return HANDOFF_MALFORMED;
+    }
+    if (r.u32() != VCON_HANDOFF_VERSION) {
+        return r.ok() ? HANDOFF_VERSION_MISMATCH : HANDOFF_MALFORMED;
+    }
+
+    state = HandoffState();
+    state.pid = r.u32();
+    state.createdNs = r.u64();
+    // The socket list repeats what the listeners and clients below carry
+    uint32_t sockets = r.count(4);
+    r.take(static_cast<size_t>(sockets) * 4);
+    uint32_t listeners = r.count(14);
+    for (uint32_t i = 0; i < listeners && r.ok(); i++) {
+        HandoffListener listener;
+        listener.name = r.str();
+        listener.socket = static_cast<int32_t>(r.u32());
+        listener.port = r.u16();
+        listener.bindAddr = r.str();
+        state.listeners.push_back(std::move(listener));
+    }
+
+    state.scrollbackTotal = r.u64();
+    uint32_t lines = r.count(16);
+    state.scrollback.reserve(lines);
+    for (uint32_t i = 0; i < lines && r.ok(); i++) {
+        HandoffLine line;
+        line.text = r.str();
+        line.channelId = static_cast<int32_t>(r.u32());
+        line.color = r.u32();
+        uint32_t runs = r.count(8);
+        line.runs.reserve(runs);
+        for (uint32_t j = 0; j < runs && r.ok(); j++) {
+            ColorRun run;
+            run.offset = r.u32();
+            run.color = r.u32();
+            line.runs.push_back(run);
+        }
+        state.scrollback.push_back(std::move(line));
+    }
+
+    uint32_t clients = r.count(58);
+    state.clients.reserve(clients);
+    for (uint32_t i = 0; i < clients && r.ok(); i++) {
+        HandoffClient client;
+        client.socket = static_cast<int32_t>(r.u32());
+        client.listener = r.str();
+        client.ip = r.str();
+        client.port = r.u16();
+        client.topics = r.u32();
+        client.commandsQueued = r.u64();
+        client.commandsThrottled = r.u64();
+        client.framesDropped = r.u64();
+        client.scrollbackNext = r.u64();
+        uint32_t unsentLen = r.u32();
+        if (const uint8_t* p = r.take(unsentLen)) {
+            client.unsent.assign(p, p + unsentLen);
+        }
+        uint32_t unreadLen = r.u32();
+        if (const uint8_t* p = r.take(unreadLen)) {
+            client.unread.assign(p, p + unreadLen);
+        }
+        state.clients.push_back(std::move(client));
+    }
+
+    uint32_t commands = r.count(8);
+    for (uint32_t i = 0; i < commands && r.ok(); i++) {
+        HandoffCommand command;
+        command.command = r.str();
+        command.source = r.str();
+        state.commands.push_back(std::move(command));
+    }
+
+    return r.ok() && r.left() == 0 ? HANDOFF_DECODED : HANDOFF_MALFORMED;
+}
+
+// Process-local transport: publishHandoff() stores the blob in an unlinked
+// shared-memory object and keeps its descriptor open; takeHandoff() finds
+// that descriptor again by the object's name in /proc/self/fd, reads the
+// blob and closes it. Nothing global is touched, so it is safe while other
+// threads run, and a blob nobody takes is freed when the process exits.
+// Linux only; elsewhere both fail and reloads fall back to closing every
+// connection.
+bool publishHandoff(const std::vector<uint8_t>& blob);
+bool takeHandoff(std::vector<uint8_t>& blob);
+
+#endif // HANDOFF_HPP
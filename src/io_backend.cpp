@@ -0,0 +1,247 @@
+#include "io_backend.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+static const size_t RECV_CHUNK_SIZE = 4096;
+
+static bool wouldBlock() {
+#ifdef _WIN32
+    return SOCKET_ERROR_CODE == WSAEWOULDBLOCK;
+#else
+    return SOCKET_ERROR_CODE == EWOULDBLOCK || SOCKET_ERROR_CODE == EAGAIN;
+#endif
+}
+
+static int sendNow(SOCKET socket, const uint8_t* data, size_t len) {
+    metricAdd(g_metrics.ioSyscalls);
+    int sent = ::send(socket, reinterpret_cast<const char*>(data), static_cast<int>(len), 0);
+    if (sent > 0) {
+        return sent;
+    }
+    return sent == SOCKET_ERROR && wouldBlock() ? 0 : -1;
+}
+
+// Received chunks are gathered into one buffer per poll(); pointers are only
+// filled in once it has stopped growing.
+static void resolveRecvData(std::vector<IoEvent>& events, size_t first, const std::vector<char>& buffer,
+                            const std::vector<size_t>& offsets) {
+    size_t n = 0;
+    for (size_t i = first; i < events.size(); i++) {
+        if (events[i].type == IO_EVENT_RECV) {
+            events[i].data = buffer.data() + offsets[n++];
+        }
+    }
+}
+
+// Non-blocking accept() and one recv() per client on every tick. Works
+// everywhere and is what the server always did.
+class PollBackend : public IoBackend {
+public:
+    const char* name() const override { return "poll"; }
+
+    void addListener(SOCKET socket) override { m_listeners.push_back(socket); }
+    void removeListener(SOCKET socket) override {
+        m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), socket), m_listeners.end());
+    }
+    void addClient(SOCKET socket) override { m_clients.push_back(socket); }
+    void removeClient(SOCKET socket) override {
+        m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), socket), m_clients.end());
+    }
+
+    void poll(std::vector<IoEvent>& events) override {
+        size_t first = events.size();
+        m_recvBuf.resize(m_clients.size() * RECV_CHUNK_SIZE);
+        m_offsets.clear();
+
+        for (SOCKET listener : m_listeners) {
+            IoEvent ev{};
+            socklen_t addrLen = sizeof(ev.addr);
+            metricAdd(g_metrics.ioSyscalls);
+            ev.socket = accept(listener, reinterpret_cast<sockaddr*>(&ev.addr), &addrLen);
+            if (ev.socket != INVALID_SOCKET) {
+                ev.type = IO_EVENT_ACCEPT;
+                ev.listener = listener;
+                events.push_back(ev);
+            }
+        }
+
+        size_t used = 0;
+        for (SOCKET socket : m_clients) {
+            metricAdd(g_metrics.ioSyscalls);
+            int received = recv(socket, m_recvBuf.data() + used, RECV_CHUNK_SIZE, 0);
+            IoEvent ev{};
+            ev.socket = socket;
+            if (received > 0) {
+                ev.type = IO_EVENT_RECV;
+                ev.len = received;
+                m_offsets.push_back(used);
+                used += received;
+                events.push_back(ev);
+            } else if (received == 0 || !wouldBlock()) {
+                ev.type = IO_EVENT_CLOSED;
+                events.push_back(ev);
+            }
+        }
+        resolveRecvData(events, first, m_recvBuf, m_offsets);
+    }
+
+    int send(SOCKET socket, const uint8_t* data, size_t len) override {
+        return sendNow(socket, data, len);
+    }
+
+private:
+    std::vector<SOCKET> m_listeners;
+    std::vector<SOCKET> m_clients;
+    std::vector<char> m_recvBuf;
+    std::vector<size_t> m_offsets;
+};
+
+#ifdef __linux__
+// Readiness-based: one epoll_wait() per tick, and accept()/recv() only on
+// sockets that have something for us. Sends stay direct.
+class EpollBackend : public IoBackend {
+public:
+    EpollBackend() : m_epoll(epoll_create1(EPOLL_CLOEXEC)), m_ready(64) {}
+    ~EpollBackend() override {
+        if (m_epoll != -1) {
+            close(m_epoll);
+        }
+    }
+
+    bool valid() const { return m_epoll != -1; }
+    const char* name() const override { return "epoll"; }
+
+    void addListener(SOCKET socket) override {
+        m_listeners.push_back(socket);
+        watch(EPOLL_CTL_ADD, socket, EPOLLIN);
+    }
+    void removeListener(SOCKET socket) override {
+        m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), socket), m_listeners.end());
+        watch(EPOLL_CTL_DEL, socket, 0);
+    }
+
+    void addClient(SOCKET socket) override { watch(EPOLL_CTL_ADD, socket, EPOLLIN | EPOLLRDHUP); }
+    void removeClient(SOCKET socket) override { watch(EPOLL_CTL_DEL, socket, 0); }
+
+    void poll(std::vector<IoEvent>& events) override {
+        size_t first = events.size();
+        m_recvBuf.clear();
+        m_offsets.clear();
+
+        metricAdd(g_metrics.ioSyscalls);
+        int count = epoll_wait(m_epoll, m_ready.data(), static_cast<int>(m_ready.size()), 0);
+        for (int i = 0; i < count; i++) {
+            SOCKET socket = m_ready[i].data.fd;
+            if (std::find(m_listeners.begin(), m_listeners.end(), socket) != m_listeners.end()) {
+                acceptAll(socket, events);
+            } else {
+                drain(socket, events);
+            }
+        }
+        resolveRecvData(events, first, m_recvBuf, m_offsets);
+    }
+
+    int send(SOCKET socket, const uint8_t* data, size_t len) override {
+        return sendNow(socket, data, len);
+    }
+
+private:
+    void watch(int op, SOCKET socket, uint32_t mask) {
+        epoll_event ev{};
+        ev.events = mask;
+        ev.data.fd = socket;
+        metricAdd(g_metrics.ioSyscalls);
+        epoll_ctl(m_epoll, op, socket, &ev);
+    }
+
+    void acceptAll(SOCKET listener, std::vector<IoEvent>& events) {
+        for (;;) {
+            IoEvent ev{};
+            socklen_t addrLen = sizeof(ev.addr);
+            metricAdd(g_metrics.ioSyscalls);
+            ev.socket = accept(listener, reinterpret_cast<sockaddr*>(&ev.addr), &addrLen);
+            if (ev.socket == INVALID_SOCKET) {
+                return;
+            }
+            ev.type = IO_EVENT_ACCEPT;
+            ev.listener = listener;
+            events.push_back(ev);
+        }
+    }
+
+    // Reads until the socket is empty; the level-triggered watch would
+    // report it again next tick anyway, this just saves the round trip
+    void drain(SOCKET socket, std::vector<IoEvent>& events) {
+        for (;;) {
+            size_t used = m_recvBuf.size();
+            m_recvBuf.resize(used + RECV_CHUNK_SIZE);
+            metricAdd(g_metrics.ioSyscalls);
+            int received = recv(socket, m_recvBuf.data() + used, RECV_CHUNK_SIZE, 0);
+            IoEvent ev{};
+            ev.socket = socket;
+            if (received > 0) {
+                m_recvBuf.resize(used + received);
+                ev.type = IO_EVENT_RECV;
+                ev.len = received;
+                m_offsets.push_back(used);
+                events.push_back(ev);
+                if (static_cast<size_t>(received) < RECV_CHUNK_SIZE) {
+                    return;
+                }
+                continue;
+            }
+            m_recvBuf.resize(used);
+            if (received == 0 || !wouldBlock()) {
+                ev.type = IO_EVENT_CLOSED;
+                events.push_back(ev);
+            }
+            return;
+        }
+    }
+
+    int m_epoll;
+    std::vector<SOCKET> m_listeners;
+    std::vector<epoll_event> m_ready;
+    std::vector<char> m_recvBuf;
+    std::vector<size_t> m_offsets;
+};
+#endif
+
+std::unique_ptr<IoBackend> createIoBackend(IoBackendType type) {
+#ifdef __linux__
+    if (type == IO_BACKEND_URING) {
+        std::unique_ptr<IoBackend> uring = createUringBackend();
+        if (uring) {
+            return uring;
+        }
+    }
+    if (type != IO_BACKEND_POLL) {
+        std::unique_ptr<EpollBackend> epoll(new EpollBackend());
+        if (epoll->valid()) {
+            return epoll;
+        }
+    }
+#else
+    (void)type;
+#endif
+    return std::unique_ptr<IoBackend>(new PollBackend());
+}
+
+bool parseIoBackend(const std::string& name, IoBackendType& type) {
+    if (name == "auto") {
+        type = IO_BACKEND_AUTO;
+    } else if (name == "poll") {
+        type = IO_BACKEND_POLL;
+    } else if (name == "epoll") {
+        type = IO_BACKEND_EPOLL;
+    } else if (name == "io_uring" || name == "uring") {
+        type = IO_BACKEND_URING;
+    } else {
+        return false;
+    }
+    return true;
+}
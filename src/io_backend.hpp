@@ -0,0 +1,114 @@
+#ifndef IO_BACKEND_HPP
+#define IO_BACKEND_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#define SOCKET_ERROR_CODE WSAGetLastError()
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <cstdio>
+#define SOCKET int
+#define INVALID_SOCKET -1
+#define SOCKET_ERROR -1
+#define closesocket close
+#define SOCKET_ERROR_CODE errno
+#endif
+
+enum IoBackendType {
+    IO_BACKEND_AUTO,    // epoll where available, else poll
+    IO_BACKEND_POLL,    // non-blocking accept()/recv() on every socket each tick
+    IO_BACKEND_EPOLL,   // readiness via epoll, Linux
+    IO_BACKEND_URING    // completions via io_uring, Linux 6.0+
+};
+
+enum IoEventType {
+    IO_EVENT_ACCEPT,
+    IO_EVENT_RECV,
+    IO_EVENT_CLOSED
+};
+
+struct IoEvent {
+    IoEventType type;
+    SOCKET socket;      // accepted socket for IO_EVENT_ACCEPT
+    SOCKET listener;    // IO_EVENT_ACCEPT only: the socket it arrived on
+    sockaddr_in addr;   // IO_EVENT_ACCEPT only
+    const char* data;   // IO_EVENT_RECV only, valid until the next poll()
+    size_t len;
+};
+
+// Output a backend took with send() but had not written when it let go of
+// the socket
+struct IoUnsent {
+    SOCKET socket;
+    std::vector<uint8_t> data;
+};
+
+// Socket I/O for the VConsole server. All calls come from the engine thread
+// with the client table locked. Sockets are created and closed by the
+// server; the backend only watches them between add and remove.
+class IoBackend {
+public:
+    virtual ~IoBackend() {}
+    virtual const char* name() const = 0;
+
+    // Any number of listening sockets may be watched at once; remove is
+    // called before the socket is closed
+    virtual void addListener(SOCKET socket) = 0;
+    virtual void removeListener(SOCKET socket) = 0;
+    virtual void addClient(SOCKET socket) = 0;
+    // Called before the socket is closed; abandons any queued I/O
+    virtual void removeClient(SOCKET socket) = 0;
+
+    // Collects new connections, received data and hangups without blocking
+    virtual void poll(std::vector<IoEvent>& events) = 0;
+
+    // Takes up to len bytes for the socket. Returns the number taken (the
+    // caller may discard them), 0 if the socket cannot take more right now,
+    // or -1 if the connection failed.
+    virtual int send(SOCKET socket, const uint8_t* data, size_t len) = 0;
+
+    // Hands work queued since the last call to the kernel. Batched backends
+    // do one syscall here per tick; the others have nothing to do.
+    virtual void submit() {}
+
+    // True while bytes taken by send() may not have reached the socket yet;
+    // backends that send synchronously never have any
+    virtual bool sendsInFlight() const { return false; }
+
+    // Lets go of every client without closing any, so the sockets can be
+    // handed to another server instance. Work still in the kernel is
+    // settled first: data received meanwhile comes back as events, bytes
+    // taken by send() but never written come back in unsent, and a socket
+    // whose last write cannot be accounted for is reported closed. Backends
+    // that send synchronously have nothing to settle.
+    virtual void release(std::vector<IoEvent>& events, std::vector<IoUnsent>& unsent) {
+        (void)events;
+        (void)unsent;
+    }
+};
+
+// Creates the requested backend, falling back io_uring -> epoll -> poll
+// when one is not supported by the platform or the running kernel. AUTO
+// starts at epoll; io_uring is only used when asked for.
+std::unique_ptr<IoBackend> createIoBackend(IoBackendType type);
+bool parseIoBackend(const std::string& name, IoBackendType& type);
+
+#ifdef __linux__
+std::unique_ptr<IoBackend> createUringBackend();
+#endif
+
+#endif // IO_BACKEND_HPP
@@ -0,0 +1,808 @@
+#include "io_backend.hpp"
+#include "metrics.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// Multishot recv and accept need the 6.0 uAPI; older headers build without
+#if defined(__linux__) && defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#define __NR_io_uring_enter 426
+#define __NR_io_uring_register 427
+#endif
+
+static int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    metricAdd(g_metrics.ioSyscalls);
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int uringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+static const unsigned RING_ENTRIES = 256;
+
+// Provided buffer ring for multishot recv; console commands are small
+static const unsigned RECV_BUFFERS = 64;
+static const size_t RECV_BUFFER_SIZE = 4096;
+static const uint16_t RECV_GROUP = 0;
+
+// Registered outbound slots, one per client while it is connected. Clients
+// beyond SEND_SLOTS fall back to direct send().
+static const unsigned SEND_SLOTS = 16;
+static const size_t SEND_SLOT_SIZE = 64 * 1024;
+
+// How long release() waits for cancelled operations to complete
+static const uint64_t RELEASE_TIMEOUT_NS = 200 * 1000000ull;
+
+enum UringOp : uint64_t {
+    OP_ACCEPT = 1,
+    OP_RECV,
+    OP_SEND,
+    OP_CANCEL
+};
+
+// user_data: op in the low byte, 24-bit generation, 32-bit index
+static uint64_t makeTag(UringOp op, uint32_t index, uint32_t gen) {
+    return op | (static_cast<uint64_t>(gen & 0xFFFFFF) << 8) | (static_cast<uint64_t>(index) << 32);
+}
+
+static UringOp tagOp(uint64_t tag) { return static_cast<UringOp>(tag & 0xFF); }
+static uint32_t tagGen(uint64_t tag) { return static_cast<uint32_t>(tag >> 8) & 0xFFFFFF; }
+static uint32_t tagIndex(uint64_t tag) { return static_cast<uint32_t>(tag >> 32); }
+
+// Completion-based: a multishot accept per listener and a multishot recv
+// per client stay armed in the kernel, outbound bytes are copied into a
+// registered slot and written from there, and everything queued during a
+// tick goes out in one io_uring_enter() from submit(). Reaping completions
+// needs no syscall at all.
+class UringBackend : public IoBackend {
+public:
+    UringBackend()
+        : m_fd(-1), m_ringMem(nullptr), m_ringSize(0), m_sqes(nullptr), m_sqesSize(0)
+        , m_sqTail(0), m_sqSubmitted(0)
+        , m_bufRing(nullptr), m_bufTail(0)
+        , m_sendMem(nullptr), m_sendFixed(false)
+        , m_releasing(false) {}
+
+    ~UringBackend() override {
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+        if (m_ringMem) {
+            munmap(m_ringMem, m_ringSize);
+        }
+        if (m_sqes) {
+            munmap(m_sqes, m_sqesSize);
+        }
+        if (m_bufRing) {
+            munmap(m_bufRing, RECV_BUFFERS * sizeof(io_uring_buf));
+        }
+        if (m_sendMem) {
+            munmap(m_sendMem, SEND_SLOTS * SEND_SLOT_SIZE);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    bool setup() {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+        m_fd = uringSetup(RING_ENTRIES, &params);
+        if (m_fd < 0) {
+            params = io_uring_params{};
+            m_fd = uringSetup(RING_ENTRIES, &params);
+        }
+        if (m_fd < 0 || !(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+            return false;
+        }
+
+        m_ringSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        void* ring = mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (ring == MAP_FAILED) {
+            return false;
+        }
+        m_ringMem = ring;
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        char* base = static_cast<char*>(ring);
+        m_sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+        m_sqKernelTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        m_sqEntries = params.sq_entries;
+        m_sqFlags = reinterpret_cast<unsigned*>(base + params.sq_off.flags);
+        m_sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+        m_sqTail = *m_sqKernelTail;
+        m_sqSubmitted = m_sqTail;
+
+        return probeOps() && setupRecvBuffers() && probeMultishotRecv() && setupSendSlots();
+    }
+
+    void addListener(SOCKET socket) override {
+        auto it = std::find_if(m_acceptors.begin(), m_acceptors.end(),
+            [](const Acceptor& a) { return a.socket == INVALID_SOCKET; });
+        if (it == m_acceptors.end()) {
+            it = m_acceptors.insert(m_acceptors.end(), Acceptor());
+        }
+        it->socket = socket;
+        it->armed = false;
+    }
+
+    void removeListener(SOCKET socket) override {
+        for (uint32_t i = 0; i < m_acceptors.size(); i++) {
+            Acceptor& acceptor = m_acceptors[i];
+            if (acceptor.socket != socket) {
+                continue;
+            }
+            if (acceptor.armed) {
+                cancel(makeTag(OP_ACCEPT, i, acceptor.gen));
+            }
+            // Connections the cancelled accept still completes are closed
+            acceptor.gen++;
+            acceptor.armed = false;
+            acceptor.socket = INVALID_SOCKET;
+        }
+    }
+
+    void addClient(SOCKET socket) override {
+        uint32_t index;
+        if (!m_freeConns.empty()) {
+            index = m_freeConns.back();
+            m_freeConns.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_conns.size());
+            m_conns.push_back(Conn());
+        }
+
+        Conn& conn = m_conns[index];
+        conn.socket = socket;
+        conn.active = true;
+        conn.recvArmed = false;
+        conn.failed = false;
+        conn.slot = -1;
+        if (!m_freeSlots.empty()) {
+            conn.slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            m_slots[conn.slot].owner = index;
+            m_slots[conn.slot].ownerGen = conn.gen;
+        }
+        m_bySocket[socket] = index;
+    }
+
+    void removeClient(SOCKET socket) override {
+        auto it = m_bySocket.find(socket);
+        if (it == m_bySocket.end()) {
+            return;
+        }
+        uint32_t index = it->second;
+        m_bySocket.erase(it);
+
+        Conn& conn = m_conns[index];
+        bool cancelled = false;
+        if (conn.recvArmed) {
+            cancelled |= queueCancel(makeTag(OP_RECV, index, conn.gen));
+        }
+        if (conn.slot >= 0) {
+            SendSlot& slot = m_slots[conn.slot];
+            slot.owner = -1;
+            if (slot.busy) {
+                // The kernel may still read the slot; it is freed on completion
+                cancelled |= queueCancel(slot.tag);
+            } else {
+                m_freeSlots.push_back(conn.slot);
+            }
+        }
+        conn.active = false;
+        conn.gen++;
+        m_freeConns.push_back(index);
+
+        // Cancels must reach the kernel before the server closes the socket
+        if (cancelled) {
+            submitQueued();
+        }
+    }
+
+    void poll(std::vector<IoEvent>& events) override {
+        // Buffers handed out by the previous poll() are no longer referenced
+        for (uint16_t bid : m_consumedBuffers) {
+            provideBuffer(bid);
+        }
+        if (!m_consumedBuffers.empty()) {
+            __atomic_store_n(&m_bufRing[0].resv, m_bufTail, __ATOMIC_RELEASE);
+            m_consumedBuffers.clear();
+        }
+
+        // Deferred task work or an overflowed CQ only surface through enter
+        if (__atomic_load_n(m_sqFlags, __ATOMIC_RELAXED) & (IORING_SQ_TASKRUN | IORING_SQ_CQ_OVERFLOW)) {
+            uringEnter(m_fd, 0, 0, IORING_ENTER_GETEVENTS);
+        }
+
+        reap(events);
+    }
+
+    int send(SOCKET socket, const uint8_t* data, size_t len) override {
+        auto it = m_bySocket.find(socket);
+        if (it == m_bySocket.end()) {
+            return -1;
+        }
+        Conn& conn = m_conns[it->second];
+        if (conn.failed) {
+            return -1;
+        }
+        if (conn.slot < 0) {
+            metricAdd(g_metrics.ioSyscalls);
+            int sent = ::send(socket, reinterpret_cast<const char*>(data), len, MSG_NOSIGNAL);
+            if (sent > 0) {
+                return sent;
+            }
+            return sent == SOCKET_ERROR && (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+
+        SendSlot& slot = m_slots[conn.slot];
+        if (slot.busy) {
+            return 0;
+        }
+        size_t n = std::min(len, SEND_SLOT_SIZE);
+        memcpy(slot.base, data, n);
+        slot.len = n;
+        slot.done = 0;
+        slot.busy = true;
+        slot.gen++;
+        slot.tag = makeTag(OP_SEND, conn.slot, slot.gen);
+        if (!queueSend(conn.socket, conn.slot)) {
+            slot.busy = false;
+            return 0;
+        }
+        return static_cast<int>(n);
+    }
+
+    void submit() override {
+        for (uint32_t i = 0; i < m_acceptors.size(); i++) {
+            Acceptor& acceptor = m_acceptors[i];
+            if (acceptor.socket == INVALID_SOCKET || acceptor.armed) {
+                continue;
+            }
+            if (io_uring_sqe* sqe = getSqe()) {
+                sqe->opcode = IORING_OP_ACCEPT;
+                sqe->fd = acceptor.socket;
+                sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+                sqe->accept_flags = SOCK_CLOEXEC;
+                sqe->user_data = makeTag(OP_ACCEPT, i, acceptor.gen);
+                acceptor.armed = true;
+            }
+        }
+
+        for (uint32_t i = 0; i < m_conns.size(); i++) {
+            Conn& conn = m_conns[i];
+            if (!conn.active || conn.recvArmed || conn.failed) {
+                continue;
+            }
+            if (io_uring_sqe* sqe = getSqe()) {
+                sqe->opcode = IORING_OP_RECV;
+                sqe->fd = conn.socket;
+                sqe->ioprio = IORING_RECV_MULTISHOT;
+                sqe->flags = IOSQE_BUFFER_SELECT;
+                sqe->buf_group = RECV_GROUP;
+                sqe->user_data = makeTag(OP_RECV, i, conn.gen);
+                conn.recvArmed = true;
+            }
+        }
+
+        submitQueued();
+    }
+
+    bool sendsInFlight() const override {
+        for (const Conn& conn : m_conns) {
+            if (conn.active && !conn.failed && conn.slot >= 0 && m_slots[conn.slot].busy) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Cancels every armed recv and in-flight send and waits for their
+    // completions, so it is known exactly which bytes reached the socket.
+    // Short writes are not resubmitted; their remainder goes to unsent.
+    void release(std::vector<IoEvent>& events, std::vector<IoUnsent>& unsent) override {
+        m_releasing = true;
+        for (uint32_t i = 0; i < m_conns.size(); i++) {
+            Conn& conn = m_conns[i];
+            if (!conn.active) {
+                continue;
+            }
+            if (conn.recvArmed) {
+                queueCancel(makeTag(OP_RECV, i, conn.gen));
+            }
+            if (conn.slot >= 0 && m_slots[conn.slot].busy) {
+                queueCancel(m_slots[conn.slot].tag);
+            }
+        }
+        submitQueued();
+
+        uint64_t deadline = monotonicNanos() + RELEASE_TIMEOUT_NS;
+        while (releasePending() && monotonicNanos() < deadline) {
+            uringEnter(m_fd, 0, 0, IORING_ENTER_GETEVENTS);
+            reap(events);
+            if (releasePending()) {
+                usleep(1000);
+            }
+        }
+
+        for (Conn& conn : m_conns) {
+            if (!conn.active || conn.failed) {
+                continue;
+            }
+            SendSlot* slot = conn.slot >= 0 ? &m_slots[conn.slot] : nullptr;
+            if ((slot && slot->busy) || conn.recvArmed) {
+                // The kernel may still write or read part of the stream, so
+                // it cannot be continued safely
+                fail(conn, events);
+            } else if (slot && slot->done < slot->len) {
+                unsent.push_back({conn.socket, std::vector<uint8_t>(slot->base + slot->done, slot->base + slot->len)});
+                slot->done = slot->len;
+            }
+        }
+        for (Conn& conn : m_conns) {
+            conn.active = false;
+        }
+        m_bySocket.clear();
+    }
+
+private:
+    struct Acceptor {
+        SOCKET socket = INVALID_SOCKET;
+        uint32_t gen = 0;
+        bool armed = false;
+    };
+
+    struct Conn {
+        SOCKET socket = INVALID_SOCKET;
+        uint32_t gen = 0;
+        bool active = false;
+        bool recvArmed = false;
+        bool failed = false;
+        int slot = -1;
+    };
+
+    struct SendSlot {
+        uint8_t* base = nullptr;
+        size_t len = 0;
+        size_t done = 0;
+        bool busy = false;
+        uint32_t gen = 0;
+        uint64_t tag = 0;
+        SOCKET socket = INVALID_SOCKET;
+        int owner = -1;
+        uint32_t ownerGen = 0;
+    };
+
+    bool probeOps() {
+        size_t size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<uint8_t> mem(size);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(mem.data());
+        if (uringRegister(m_fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        auto supported = [probe](unsigned op) {
+            return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        };
+        // Only the ops that are submitted; multishot support is not listed
+        // here and is checked by probeMultishotRecv()
+        return supported(IORING_OP_ACCEPT) && supported(IORING_OP_RECV) && supported(IORING_OP_SEND) &&
+               supported(IORING_OP_WRITE_FIXED) && supported(IORING_OP_ASYNC_CANCEL);
+    }
+
+    // Multishot recv (6.0, a release after multishot accept and provided
+    // buffer rings) is tried once on a socketpair: with data already waiting
+    // it must complete with IORING_CQE_F_MORE set, and end on EOF.
+    bool probeMultishotRecv() {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+            return false;
+        }
+        bool multishot = false;
+        if (write(pair[1], "x", 1) == 1) {
+            io_uring_sqe* sqe = getSqe();
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = pair[0];
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = RECV_GROUP;
+            sqe->user_data = makeTag(OP_CANCEL, 0, 0);
+            __atomic_store_n(m_sqKernelTail, m_sqTail, __ATOMIC_RELEASE);
+            int submitted = uringEnter(m_fd, m_sqTail - m_sqSubmitted, 1, IORING_ENTER_GETEVENTS);
+            m_sqSubmitted = m_sqTail;
+
+            // The EOF completion always comes once the peer is closed
+            bool received = false;
+            bool more = false;
+            if (submitted > 0 && takeProbeCqe(received, more) && more) {
+                multishot = received;
+                close(pair[1]);
+                pair[1] = -1;
+                while (more && takeProbeCqe(received, more)) {
+                }
+            }
+        }
+        close(pair[0]);
+        if (pair[1] != -1) {
+            close(pair[1]);
+        }
+        return multishot;
+    }
+
+    // Waits for one completion of probeMultishotRecv(), giving back the
+    // buffer it used; ok if it received the probe's single byte
+    bool takeProbeCqe(bool& ok, bool& more) {
+        unsigned head = *m_cqHead;
+        if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+            uringEnter(m_fd, 0, 1, IORING_ENTER_GETEVENTS);
+            if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+                return false;
+            }
+        }
+        const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+        ok = cqe.res == 1;
+        more = cqe.flags & IORING_CQE_F_MORE;
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            provideBuffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+            __atomic_store_n(&m_bufRing[0].resv, m_bufTail, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool setupRecvBuffers() {
+        void* mem = mmap(nullptr, RECV_BUFFERS * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return false;
+        }
+        m_bufRing = static_cast<io_uring_buf*>(mem);
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(m_bufRing);
+        reg.ring_entries = RECV_BUFFERS;
+        reg.bgid = RECV_GROUP;
+        if (uringRegister(m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            return false;
+        }
+
+        m_recvBuffers.resize(RECV_BUFFERS * RECV_BUFFER_SIZE);
+        for (uint16_t bid = 0; bid < RECV_BUFFERS; bid++) {
+            provideBuffer(bid);
+        }
+        __atomic_store_n(&m_bufRing[0].resv, m_bufTail, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void provideBuffer(uint16_t bid) {
+        io_uring_buf& buf = m_bufRing[m_bufTail & (RECV_BUFFERS - 1)];
+        buf.addr = reinterpret_cast<uint64_t>(m_recvBuffers.data() + bid * RECV_BUFFER_SIZE);
+        buf.len = RECV_BUFFER_SIZE;
+        buf.bid = bid;
+        m_bufTail++;
+    }
+
+    bool setupSendSlots() {
+        void* mem = mmap(nullptr, SEND_SLOTS * SEND_SLOT_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return false;
+        }
+        m_sendMem = static_cast<uint8_t*>(mem);
+
+        iovec iov[SEND_SLOTS];
+        m_slots.resize(SEND_SLOTS);
+        for (unsigned i = 0; i < SEND_SLOTS; i++) {
+            m_slots[i].base = m_sendMem + i * SEND_SLOT_SIZE;
+            iov[i].iov_base = m_slots[i].base;
+            iov[i].iov_len = SEND_SLOT_SIZE;
+            m_freeSlots.push_back(SEND_SLOTS - 1 - i);
+        }
+        if (uringRegister(m_fd, IORING_REGISTER_BUFFERS, iov, SEND_SLOTS) < 0) {
+            return false;
+        }
+
+        m_sendFixed = probeFixedSend();
+        return true;
+    }
+
+    // Registered buffers work with plain SEND (and so MSG_NOSIGNAL) only on
+    // newer kernels; elsewhere WRITE_FIXED is used, which behaves like the
+    // send(..., 0) the other backends do. Tried once on a socketpair.
+    bool probeFixedSend() {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+            return false;
+        }
+        io_uring_sqe* sqe = getSqe();
+        m_slots[0].base[0] = 0;
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = pair[0];
+        sqe->addr = reinterpret_cast<uint64_t>(m_slots[0].base);
+        sqe->len = 1;
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = 0;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = makeTag(OP_CANCEL, 0, 0);
+        __atomic_store_n(m_sqKernelTail, m_sqTail, __ATOMIC_RELEASE);
+        int submitted = uringEnter(m_fd, m_sqTail - m_sqSubmitted, 1, IORING_ENTER_GETEVENTS);
+        m_sqSubmitted = m_sqTail;
+
+        bool ok = false;
+        unsigned head = *m_cqHead;
+        if (submitted > 0 && head != __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+            ok = m_cqes[head & m_cqMask].res == 1;
+            __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+        }
+        close(pair[0]);
+        close(pair[1]);
+        return ok;
+    }
+
+    void reap(std::vector<IoEvent>& events) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            complete(cqe.user_data, cqe.res, cqe.flags, events);
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    bool releasePending() const {
+        for (const Conn& conn : m_conns) {
+            if (conn.active && !conn.failed && (conn.recvArmed || (conn.slot >= 0 && m_slots[conn.slot].busy))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    io_uring_sqe* getSqe() {
+        if (m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+            submitQueued();
+            if (m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+                return nullptr;
+            }
+        }
+        unsigned index = m_sqTail & m_sqMask;
+        io_uring_sqe* sqe = &m_sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        m_sqArray[index] = index;
+        m_sqTail++;
+        return sqe;
+    }
+
+    void submitQueued() {
+        unsigned pending = m_sqTail - m_sqSubmitted;
+        if (pending == 0) {
+            return;
+        }
+        __atomic_store_n(m_sqKernelTail, m_sqTail, __ATOMIC_RELEASE);
+        int submitted = uringEnter(m_fd, pending, 0, 0);
+        if (submitted > 0) {
+            m_sqSubmitted += submitted;
+        }
+    }
+
+    bool queueCancel(uint64_t target) {
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) {
+            return false;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = target;
+        sqe->user_data = makeTag(OP_CANCEL, 0, 0);
+        return true;
+    }
+
+    void cancel(uint64_t target) {
+        if (queueCancel(target)) {
+            submitQueued();
+        }
+    }
+
+    bool queueSend(SOCKET socket, int slotIndex) {
+        SendSlot& slot = m_slots[slotIndex];
+        slot.socket = socket;
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) {
+            return false;
+        }
+        sqe->fd = socket;
+        sqe->addr = reinterpret_cast<uint64_t>(slot.base + slot.done);
+        sqe->len = static_cast<uint32_t>(slot.len - slot.done);
+        sqe->buf_index = static_cast<uint16_t>(slotIndex);
+        if (m_sendFixed) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+            sqe->msg_flags = MSG_NOSIGNAL;
+        } else {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+        }
+        sqe->user_data = slot.tag;
+        return true;
+    }
+
+    Conn* liveConn(uint32_t index, uint32_t gen) {
+        if (index >= m_conns.size()) {
+            return nullptr;
+        }
+        Conn& conn = m_conns[index];
+        return conn.active && (conn.gen & 0xFFFFFF) == gen ? &conn : nullptr;
+    }
+
+    void fail(Conn& conn, std::vector<IoEvent>& events) {
+        if (conn.failed) {
+            return;
+        }
+        conn.failed = true;
+        IoEvent ev{};
+        ev.type = IO_EVENT_CLOSED;
+        ev.socket = conn.socket;
+        events.push_back(ev);
+    }
+
+    void complete(uint64_t tag, int res, uint32_t flags, std::vector<IoEvent>& events) {
+        uint32_t index = tagIndex(tag);
+        uint32_t gen = tagGen(tag);
+
+        switch (tagOp(tag)) {
+        case OP_ACCEPT: {
+            Acceptor* acceptor = index < m_acceptors.size() ? &m_acceptors[index] : nullptr;
+            if (!acceptor || gen != (acceptor->gen & 0xFFFFFF)) {
+                if (res >= 0) {
+                    close(res);
+                }
+                break;
+            }
+            if (res >= 0) {
+                IoEvent ev{};
+                ev.type = IO_EVENT_ACCEPT;
+                ev.socket = res;
+                ev.listener = acceptor->socket;
+                socklen_t addrLen = sizeof(ev.addr);
+                metricAdd(g_metrics.ioSyscalls);
+                getpeername(res, reinterpret_cast<sockaddr*>(&ev.addr), &addrLen);
+                events.push_back(ev);
+            }
+            if (!(flags & IORING_CQE_F_MORE)) {
+                acceptor->armed = false;
+            }
+            break;
+        }
+
+        case OP_RECV: {
+            bool hasBuffer = flags & IORING_CQE_F_BUFFER;
+            uint16_t bid = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            Conn* conn = liveConn(index, gen);
+            if (!conn) {
+                if (hasBuffer) {
+                    m_consumedBuffers.push_back(bid);
+                }
+                break;
+            }
+            if (!(flags & IORING_CQE_F_MORE)) {
+                conn->recvArmed = false;
+            }
+            if (res > 0 && hasBuffer) {
+                IoEvent ev{};
+                ev.type = IO_EVENT_RECV;
+                ev.socket = conn->socket;
+                ev.data = m_recvBuffers.data() + bid * RECV_BUFFER_SIZE;
+                ev.len = res;
+                events.push_back(ev);
+                m_consumedBuffers.push_back(bid);
+            } else if (res != -ENOBUFS && !(m_releasing && res == -ECANCELED)) {
+                // ENOBUFS only means every buffer was in use; re-armed in submit()
+                fail(*conn, events);
+            }
+            break;
+        }
+
+        case OP_SEND: {
+            if (index >= m_slots.size() || m_slots[index].tag != tag) {
+                break;
+            }
+            SendSlot& slot = m_slots[index];
+            Conn* conn = slot.owner >= 0 ? liveConn(slot.owner, slot.ownerGen & 0xFFFFFF) : nullptr;
+            if (res > 0) {
+                slot.done += res;
+            }
+            if (conn && res > 0 && slot.done < slot.len && !m_releasing && queueSend(slot.socket, index)) {
+                break;
+            }
+            slot.busy = false;
+            // While releasing, a cancelled or short write is handed over as unsent
+            if (conn && slot.done < slot.len && (!m_releasing || (res < 0 && res != -ECANCELED))) {
+                fail(*conn, events);
+            }
+            if (slot.owner < 0) {
+                m_freeSlots.push_back(index);
+            }
+            break;
+        }
+
+        case OP_CANCEL:
+            break;
+        }
+    }
+
+    int m_fd;
+    void* m_ringMem;
+    size_t m_ringSize;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+
+    unsigned* m_sqHead;
+    unsigned* m_sqKernelTail;
+    unsigned* m_sqFlags;
+    unsigned* m_sqArray;
+    unsigned m_sqMask;
+    unsigned m_sqEntries;
+    unsigned m_sqTail;
+    unsigned m_sqSubmitted;
+
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned m_cqMask;
+    io_uring_cqe* m_cqes;
+
+    io_uring_buf* m_bufRing;
+    uint16_t m_bufTail;
+    std::vector<char> m_recvBuffers;
+    std::vector<uint16_t> m_consumedBuffers;
+
+    uint8_t* m_sendMem;
+    bool m_sendFixed;
+    std::vector<SendSlot> m_slots;
+    std::vector<int> m_freeSlots;
+
+    std::vector<Acceptor> m_acceptors;
+    bool m_releasing;
+
+    std::vector<Conn> m_conns;
+    std::vector<uint32_t> m_freeConns;
+    std::unordered_map<SOCKET, uint32_t> m_bySocket;
+};
+
+std::unique_ptr<IoBackend> createUringBackend() {
+    std::unique_ptr<UringBackend> backend(new UringBackend());
+    if (!backend->setup()) {
+        return nullptr;
+    }
+    return backend;
+}
+
+#elif defined(__linux__)
+
+std::unique_ptr<IoBackend> createUringBackend() {
+    return nullptr;
+}
+
+#endif
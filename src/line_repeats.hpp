@@ -0,0 +1,137 @@
+#ifndef LINE_REPEATS_HPP
+#define LINE_REPEATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "vconsole_protocol.hpp"
+
+// A run of repeats held back: the repeated line and how many copies of it
+// were not sent since the line itself or the previous summary went out
+struct RepeatSummary {
+    std::string_view line;
+    int32_t channelId = 0;
+    uint32_t color = 0;
+    ColorRuns runs;
+    uint64_t count = 0;
+};
+
+// Collapses consecutive identical lines from one source. The first copy of
+// a line passes; further copies are counted instead, and reported as a
+// summary once per window while the run lasts and when it ends. Lines are
+// matched by a hash of their text, channel and colors against the previous
+// line only, so a line that differs costs one hash and nothing is kept but
+// the last line, whose buffers keep their capacity.
+class RepeatCollapser {
+public:
+    // 0 passes every line
+    void setWindow(uint64_t windowNs) { m_windowNs = windowNs; }
+    uint64_t window() const { return m_windowNs; }
+
+    // Whether line should go out. When it ends a run, or the run's window
+    // has passed, summary.count is set and the summary, which stays valid
+    // until the next call, should go out first.
+    bool admit(std::string_view line, int32_t channelId, uint32_t color, uint64_t nowNs, RepeatSummary& summary,
+               ColorRuns runs = {}) {
+        summary.count = 0;
+        if (m_windowNs == 0) {
+            return true;
+        }
+
+        uint64_t hash = hashLine(line) ^ (static_cast<uint64_t>(static_cast<uint32_t>(channelId)) << 32 | color);
+        if (!runs.empty()) {
+            hash ^= hashLine(std::string_view(reinterpret_cast<const char*>(runs.data), runs.size() * sizeof(ColorRun)));
+        }
+        if (m_valid && hash == m_hash && line.size() == m_line.size() &&
+            memcmp(line.data(), m_line.data(), line.size()) == 0 && runs.size() == m_runs.size() &&
+            (runs.empty() || memcmp(runs.data, m_runs.data(), runs.size() * sizeof(ColorRun)) == 0)) {
+            m_held++;
+            if (nowNs >= m_lastSentNs + m_windowNs) {
+                takeSummary(m_line, m_runs, nowNs, summary);
+            }
+            return false;
+        }
+
+        if (m_held > 0) {
+            m_line.swap(m_previous);
+            m_runs.swap(m_previousRuns);
+            takeSummary(m_previous, m_previousRuns, nowNs, summary);
+        }
+        m_line.assign(line.data(), line.size());
+        m_runs.assign(runs.begin(), runs.end());
+        m_hash = hash;
+        m_channelId = channelId;
+        m_color = color;
+        m_lastSentNs = nowNs;
+        m_valid = true;
+        return true;
+    }
+
+    // Summary of copies held back for a whole window after the last line
+    // went out, so a run that stops is still reported; with force, of any
+    // held back at all. False if there is nothing to report.
+    bool flush(uint64_t nowNs, RepeatSummary& summary, bool force = false) {
+        summary.count = 0;
+        if (m_held == 0 || (!force && nowNs < m_lastSentNs + m_windowNs)) {
+            return false;
+        }
+        takeSummary(m_line, m_runs, nowNs, summary);
+        return true;
+    }
+
+    // Forgets the previous line; whatever was held back is not reported
+    void reset() {
+        m_valid = false;
+        m_held = 0;
+    }
+
+    // 64-bit multiply-xorshift over 8-byte words
+    static uint64_t hashLine(std::string_view line) {
+        const uint64_t mul = 0x9E3779B97F4A7C15ull;
+        uint64_t h = line.size() * mul;
+        const char* p = line.data();
+        size_t n = line.size();
+        for (; n >= 8; p += 8, n -= 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            h = (h ^ w) * mul;
+            h ^= h >> 29;
+        }
+        if (n > 0) {
+            uint64_t w = 0;
+            memcpy(&w, p, n);
+            h = (h ^ w) * mul;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+private:
+    void takeSummary(const std::string& line, const std::vector<ColorRun>& runs, uint64_t nowNs,
+                     RepeatSummary& summary) {
+        summary.line = line;
+        summary.channelId = m_channelId;
+        summary.color = m_color;
+        summary.runs = runs;
+        summary.count = m_held;
+        m_held = 0;
+        m_lastSentNs = nowNs;
+    }
+
+    uint64_t m_windowNs = 0;
+    std::string m_line;
+    std::string m_previous;  // line of the run just ended, for its summary
+    std::vector<ColorRun> m_runs;
+    std::vector<ColorRun> m_previousRuns;
+    uint64_t m_hash = 0;
+    int32_t m_channelId = 0;
+    uint32_t m_color = 0;
+    uint64_t m_held = 0;
+    uint64_t m_lastSentNs = 0;
+    bool m_valid = false;
+};
+
+#endif // LINE_REPEATS_HPP
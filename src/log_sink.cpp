@@ -0,0 +1,282 @@
+#include "log_sink.hpp"
+#include <chrono>
+#include <cstring>
+
+// Batches above this size wake the writer early; beyond the hard cap new
+// records are dropped rather than letting a stalled disk grow memory.
+static const size_t WAKE_THRESHOLD = 256 * 1024;
+static const size_t PENDING_LIMIT = 16 * 1024 * 1024;
+static const size_t FILE_BUFFER_SIZE = 1024 * 1024;
+
+static void appendLE(std::vector<char>& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+LogSink::LogSink()
+    : m_format(LOG_SINK_JSON)
+    , m_rotateBytes(0)
+    , m_keepFiles(0)
+    , m_file(nullptr)
+    , m_fileBytes(0)
+    , m_stop(false)
+    , m_open(false)
+    , m_records(0)
+    , m_dropped(0)
+{
+}
+
+LogSink::~LogSink() {
+    close();
+}
+
+uint64_t LogSink::unixNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool LogSink::open(const std::string& path, LogSinkFormat format, size_t rotateBytes, int keepFiles) {
+    close();
+
+    m_path = path;
+    m_format = format;
+    m_rotateBytes = rotateBytes;
+    m_keepFiles = keepFiles;
+
+    if (!openFile()) {
+        return false;
+    }
+
+    m_stop = false;
+    m_records = 0;
+    m_dropped = 0;
+    m_open = true;
+    m_thread = std::thread(&LogSink::run, this);
+    return true;
+}
+
+void LogSink::close() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    m_open = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool LogSink::openFile() {
+    m_file = fopen(m_path.c_str(), "ab");
+    if (!m_file) {
+        return false;
+    }
+    setvbuf(m_file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+    fseek(m_file, 0, SEEK_END);
+    long size = ftell(m_file);
+    m_fileBytes = size > 0 ? static_cast<size_t>(size) : 0;
+
+    if (m_format == LOG_SINK_BINARY && m_fileBytes == 0) {
+        std::vector<char> header(LOG_SINK_MAGIC, LOG_SINK_MAGIC + 4);
+        appendLE(header, LOG_SINK_VERSION, 4);
+        fwrite(header.data(), 1, header.size(), m_file);
+        m_fileBytes = header.size();
+    }
+    return true;
+}
+
+void LogSink::rotate() {
+    fclose(m_file);
+    m_file = nullptr;
+
+    if (m_keepFiles > 0) {
+        std::string oldest = m_path + "." + std::to_string(m_keepFiles);
+        ::remove(oldest.c_str());
+        for (int i = m_keepFiles - 1; i >= 1; i--) {
+            std::string from = m_path + "." + std::to_string(i);
+            std::string to = m_path + "." + std::to_string(i + 1);
+            ::rename(from.c_str(), to.c_str());
+        }
+        std::string first = m_path + ".1";
+        ::rename(m_path.c_str(), first.c_str());
+    } else {
+        ::remove(m_path.c_str());
+    }
+
+    openFile();
+}
+
+void LogSink::run() {
+    std::vector<char> batch;
+    batch.reserve(WAKE_THRESHOLD);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait_for(lock, std::chrono::milliseconds(250),
+                          [this] { return m_stop || m_pending.size() >= WAKE_THRESHOLD; });
+            batch.swap(m_pending);
+            if (batch.empty() && m_stop) {
+                break;
+            }
+        }
+
+        if (!batch.empty() && m_file) {
+            fwrite(batch.data(), 1, batch.size(), m_file);
+            fflush(m_file);
+            m_fileBytes += batch.size();
+            if (m_rotateBytes > 0 && m_fileBytes >= m_rotateBytes) {
+                rotate();
+            }
+        }
+        batch.clear();
+    }
+}
+
+void LogSink::write(CaptureSource source, int32_t channelId, uint32_t color, uint64_t unixNanos, std::string_view line) {
+    if (!isOpen()) {
+        return;
+    }
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.size() > PENDING_LIMIT) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (m_format == LOG_SINK_BINARY) {
+            encodeBinary(m_pending, source, channelId, color, unixNanos, line);
+        } else {
+            encodeJSON(m_pending, source, channelId, unixNanos, line);
+        }
+        wake = m_pending.size() >= WAKE_THRESHOLD;
+    }
+    m_records.fetch_add(1, std::memory_order_relaxed);
+
+    if (wake) {
+        m_cv.notify_one();
+    }
+}
+
+void LogSink::encodeBinary(std::vector<char>& out, CaptureSource source, int32_t channelId, uint32_t color,
+                           uint64_t unixNanos, std::string_view line) {
+    appendLE(out, LOG_SINK_RECORD_HEADER - 4 + line.size(), 4);
+    appendLE(out, unixNanos, 8);
+    appendLE(out, static_cast<uint8_t>(source), 1);
+    appendLE(out, static_cast<uint32_t>(channelId), 4);
+    appendLE(out, color, 4);
+    out.insert(out.end(), line.begin(), line.end());
+}
+
+void LogSink::encodeJSON(std::vector<char>& out, CaptureSource source, int32_t channelId, uint64_t unixNanos,
+                         std::string_view line) {
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+
+    char head[128];
+    int n = snprintf(head, sizeof(head), "{\"ts\":%llu.%06llu,\"source\":\"%s\",\"channel\":%d,\"msg\":\"",
+                     static_cast<unsigned long long>(unixNanos / 1000000000ull),
+                     static_cast<unsigned long long>((unixNanos % 1000000000ull) / 1000),
+                     captureSourceName(source), channelId);
+    out.insert(out.end(), head, head + n);
+
+    static const char hex[] = "0123456789abcdef";
+    for (char ch : line) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        switch (c) {
+            case '"': out.push_back('\\'); out.push_back('"'); break;
+            case '\\': out.push_back('\\'); out.push_back('\\'); break;
+            case '\n': out.push_back('\\'); out.push_back('n'); break;
+            case '\r': out.push_back('\\'); out.push_back('r'); break;
+            case '\t': out.push_back('\\'); out.push_back('t'); break;
+            default:
+                if (c < 0x20) {
+                    const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.insert(out.end(), esc, esc + 6);
+                } else {
+                    out.push_back(ch);
+                }
+                break;
+        }
+    }
+
+    static const char tail[] = "\"}\n";
+    out.insert(out.end(), tail, tail + 3);
+}
+
+static uint64_t readLE(const unsigned char* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+LogSinkReader::LogSinkReader()
+    : m_file(nullptr)
+{
+}
+
+LogSinkReader::~LogSinkReader() {
+    close();
+}
+
+bool LogSinkReader::open(const std::string& path) {
+    close();
+
+    m_file = fopen(path.c_str(), "rb");
+    if (!m_file) {
+        return false;
+    }
+    setvbuf(m_file, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+    unsigned char header[8];
+    if (fread(header, 1, sizeof(header), m_file) != sizeof(header) ||
+        memcmp(header, LOG_SINK_MAGIC, 4) != 0 || readLE(header + 4, 4) != LOG_SINK_VERSION) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LogSinkReader::close() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool LogSinkReader::next(LogRecord& record) {
+    if (!m_file) {
+        return false;
+    }
+
+    unsigned char header[LOG_SINK_RECORD_HEADER];
+    if (fread(header, 1, sizeof(header), m_file) != sizeof(header)) {
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(readLE(header, 4));
+    if (length < LOG_SINK_RECORD_HEADER - 4 || header[12] >= CAPTURE_SOURCE_COUNT) {
+        return false;
+    }
+
+    record.unixNanos = readLE(header + 4, 8);
+    record.source = static_cast<CaptureSource>(header[12]);
+    record.channelId = static_cast<int32_t>(readLE(header + 13, 4));
+    record.color = static_cast<uint32_t>(readLE(header + 17, 4));
+    record.line.resize(length - (LOG_SINK_RECORD_HEADER - 4));
+    return record.line.empty() || fread(&record.line[0], 1, record.line.size(), m_file) == record.line.size();
+}
@@ -0,0 +1,106 @@
+#ifndef LOG_SINK_HPP
+#define LOG_SINK_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include "metrics.hpp"
+
+enum LogSinkFormat {
+    LOG_SINK_JSON,
+    LOG_SINK_BINARY
+};
+
+// Binary format, all integers little-endian:
+//   file header: "VCLG" magic, uint32 version
+//   record:      uint32 length of the rest of the record, uint64 unix time
+//                in nanoseconds, uint8 CaptureSource, int32 channel,
+//                uint32 color, then the raw line bytes
+constexpr char LOG_SINK_MAGIC[4] = {'V', 'C', 'L', 'G'};
+constexpr uint32_t LOG_SINK_VERSION = 1;
+constexpr size_t LOG_SINK_RECORD_HEADER = 4 + 8 + 1 + 4 + 4;
+
+// Appends captured lines to a file from a background thread. write() only
+// encodes into an in-memory batch under a short lock; the writer thread does
+// all file I/O, buffered, and rotates the file once it exceeds rotateBytes.
+class LogSink {
+public:
+    LogSink();
+    ~LogSink();
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    // rotateBytes 0 disables rotation; keepFiles is the number of rotated
+    // files (path.1 .. path.N) kept besides the active one
+    bool open(const std::string& path, LogSinkFormat format, size_t rotateBytes = 0, int keepFiles = 0);
+    void close();
+    bool isOpen() const { return m_open.load(std::memory_order_relaxed); }
+    const std::string& getPath() const { return m_path; }
+
+    void write(CaptureSource source, int32_t channelId, uint32_t color, uint64_t unixNanos, std::string_view line);
+
+    uint64_t getRecords() const { return m_records.load(std::memory_order_relaxed); }
+    uint64_t getDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static uint64_t unixNanos();
+
+private:
+    void run();
+    bool openFile();
+    void rotate();
+    void encodeJSON(std::vector<char>& out, CaptureSource source, int32_t channelId, uint64_t unixNanos, std::string_view line);
+    void encodeBinary(std::vector<char>& out, CaptureSource source, int32_t channelId, uint32_t color, uint64_t unixNanos, std::string_view line);
+
+    std::string m_path;
+    LogSinkFormat m_format;
+    size_t m_rotateBytes;
+    int m_keepFiles;
+
+    FILE* m_file;
+    size_t m_fileBytes;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<char> m_pending;
+    std::thread m_thread;
+    bool m_stop;
+
+    std::atomic<bool> m_open;
+    std::atomic<uint64_t> m_records;
+    std::atomic<uint64_t> m_dropped;
+};
+
+struct LogRecord {
+    uint64_t unixNanos;
+    CaptureSource source;
+    int32_t channelId;
+    uint32_t color;
+    std::string line;
+};
+
+// Sequential reader for binary sink files, used to replay recordings
+class LogSinkReader {
+public:
+    LogSinkReader();
+    ~LogSinkReader();
+    LogSinkReader(const LogSinkReader&) = delete;
+    LogSinkReader& operator=(const LogSinkReader&) = delete;
+
+    // Fails if the file is missing or does not start with a v1 binary header
+    bool open(const std::string& path);
+    void close();
+
+    // False at end of file or on a truncated or malformed record
+    bool next(LogRecord& record);
+
+private:
+    FILE* m_file;
+};
+
+#endif // LOG_SINK_HPP
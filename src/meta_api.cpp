@@ -2,6 +2,10 @@
 #include <meta_api.h>
 #include "vconsole_server.hpp"
 #include "config.hpp"
+#include "metrics_server.hpp"
+#include "server_status.hpp"
+#include <cstring>
+#include <cstdlib>
 
 #define METAMOD_VCONSOLE_VERSION "0.1.0"
 
@@ -30,6 +34,11 @@ extern DLL_FUNCTIONS g_DllFunctionTable_Post;
 extern enginefuncs_t g_EngineFunctionsTable;
 extern enginefuncs_t g_EngineFunctionsTable_Post;
 
+void collectServerStatus(ServerStatus& status);
+void countPlayers(uint8_t& players, uint8_t& maxPlayers);
+void indexConsoleNames();
+const char* readCvarValue(const ConsoleIndex::Entry* entry, const char* name);
+
 void executeServerCommand(const std::string& cmd) {
 	if (cmd.empty()) {
 		return;
@@ -42,6 +51,102 @@ void executeServerCommand(const std::string& cmd) {
 	g_engfuncs.pfnServerExecute();
 }
 
+static void cmdStats() {
+	VConsoleServer::getInstance().printStats();
+}
+
+static void cmdRecord() {
+	VConsoleServer& server = VConsoleServer::getInstance();
+	const char* arg = CMD_ARGC() > 1 ? CMD_ARGV(1) : "";
+	char msg[256];
+
+	if (!*arg) {
+		const LogSink& recorder = server.getRecorder();
+		if (recorder.isOpen()) {
+			snprintf(msg, sizeof(msg), "[VConsole] Recording to %s (%llu lines)\n", recorder.getPath().c_str(),
+			         static_cast<unsigned long long>(recorder.getRecords()));
+		} else {
+			snprintf(msg, sizeof(msg), "[VConsole] Not recording. Usage: vcon_record <file> | stop\n");
+		}
+	} else if (!strcmp(arg, "stop")) {
+		const LogSink& recorder = server.getRecorder();
+		if (recorder.isOpen()) {
+			std::string path = recorder.getPath();
+			unsigned long long records = recorder.getRecords();
+			server.stopRecording();
+			snprintf(msg, sizeof(msg), "[VConsole] Recording stopped: %llu lines in %s\n", records, path.c_str());
+		} else {
+			snprintf(msg, sizeof(msg), "[VConsole] Not recording\n");
+		}
+	} else {
+		std::string path = arg;
+		if (path[0] != '/') {
+			path = getPluginDirectory() + path;
+		}
+		if (server.startRecording(path)) {
+			snprintf(msg, sizeof(msg), "[VConsole] Recording captured output to %s\n", path.c_str());
+		} else {
+			snprintf(msg, sizeof(msg), "[VConsole] Failed to open recording %s\n", path.c_str());
+		}
+	}
+	g_engfuncs.pfnServerPrint(msg);
+}
+
+static void cmdLatency() {
+	VConsoleServer& server = VConsoleServer::getInstance();
+	const char* arg = CMD_ARGC() > 1 ? CMD_ARGV(1) : "";
+
+	if (!strcmp(arg, "reset")) {
+		server.resetLatency();
+		g_engfuncs.pfnServerPrint("[VConsole] Latency histograms reset\n");
+	} else if (!strcmp(arg, "debug")) {
+		if (CMD_ARGC() > 2) {
+			server.setLatencyDebug(atoi(CMD_ARGV(2)) != 0);
+		}
+		char msg[128];
+		snprintf(msg, sizeof(msg), "[VConsole] PRNT latency trailer is %s\n", server.getLatencyDebug() ? "on" : "off");
+		g_engfuncs.pfnServerPrint(msg);
+	} else {
+		server.printLatency();
+	}
+}
+
+static void cmdRepeat() {
+	VConsoleServer& server = VConsoleServer::getInstance();
+	if (CMD_ARGC() > 1) {
+		int ms = atoi(CMD_ARGV(1));
+		if (ms >= 0) {
+			server.setRepeatWindow(static_cast<uint32_t>(ms));
+		}
+	}
+
+	char msg[160];
+	if (server.getRepeatWindowMs() > 0) {
+		snprintf(msg, sizeof(msg), "[VConsole] Repeated lines are collapsed, with a summary every %ums. "
+		         "Usage: vcon_repeat <ms> | 0 for raw output\n", server.getRepeatWindowMs());
+	} else {
+		snprintf(msg, sizeof(msg), "[VConsole] Raw output: every line is sent. Usage: vcon_repeat <ms>\n");
+	}
+	g_engfuncs.pfnServerPrint(msg);
+}
+
+// pfnAddServerCommand takes a non-const name and keeps the pointer, so the
+// names live in writable static storage rather than string literals
+static char s_vconStats[] = "vcon_stats";
+static char s_vconLatency[] = "vcon_latency";
+static char s_vconRecord[] = "vcon_record";
+static char s_vconRepeat[] = "vcon_repeat";
+
+static const struct {
+	char* name;
+	void (*handler)(void);
+} s_commands[] = {
+	{ s_vconStats, cmdStats },
+	{ s_vconLatency, cmdLatency },
+	{ s_vconRecord, cmdRecord },
+	{ s_vconRepeat, cmdRepeat },
+};
+
 C_DLLEXPORT int Meta_Query(char *interfaceVersion, plugin_info_t **plinfo, mutil_funcs_t *pMetaUtilFuncs)
 {
 	*plinfo = &Plugin_info;
@@ -83,13 +188,68 @@ C_DLLEXPORT int Meta_Attach(PLUG_LOADTIME now, META_FUNCTIONS *pFunctionTable, m
 
 	VConsoleServer::getInstance().setMaxConnections(g_config.max_connections);
 	VConsoleServer::getInstance().setLogging(g_config.logging);
+	VConsoleServer::getInstance().setCommandRateLimit(g_config.cmd_rate, g_config.cmd_burst);
+
+	VConsoleServer::getInstance().setLatencyDebug(g_config.latency_debug);
+	VConsoleServer::getInstance().setAnsiColors(g_config.ansi_colors);
+	VConsoleServer::getInstance().setRepeatWindow(static_cast<uint32_t>(g_config.repeat_window_ms));
+	VConsoleServer::getInstance().setCaptureBudget(g_config.capture_rate, g_config.capture_burst,
+		static_cast<uint32_t>(g_config.capture_sample), static_cast<uint32_t>(g_config.capture_summary_ms));
+	VConsoleServer::getInstance().setShutdownDrain(static_cast<uint32_t>(g_config.shutdown_drain_ms));
+	VConsoleServer::getInstance().setTimeouts(static_cast<uint32_t>(g_config.idle_timeout_ms),
+		static_cast<uint32_t>(g_config.keepalive_ms), static_cast<uint32_t>(g_config.send_timeout_ms));
+
+	IoBackendType ioBackend = IO_BACKEND_AUTO;
+	parseIoBackend(g_config.io_backend, ioBackend);
+	VConsoleServer::getInstance().setIoBackend(ioBackend);
+	VConsoleServer::getInstance().setTickBudget(static_cast<uint32_t>(g_config.tick_budget_us));
+	if (g_config.status_interval_ms > 0) {
+		VConsoleServer::getInstance().setStatusSource(collectServerStatus, static_cast<uint32_t>(g_config.status_interval_ms));
+	}
+	VConsoleServer::getInstance().setPlayerCounter(countPlayers);
+
+	for (const ListenerConfig& lc : g_config.listeners) {
+		ListenerOptions options;
+		options.name = lc.name;
+		options.port = lc.port;
+		options.bindAddr = lc.bind;
+		options.maxConnections = lc.max_connections;
+		options.cmdRate = lc.cmd_rate;
+		options.cmdBurst = lc.cmd_burst;
+		options.readOnly = lc.read_only;
+		parseChannelMask(lc.channels, options.channels);
+		options.maxBacklog = static_cast<size_t>(lc.max_backlog_kb) * 1024;
+		if (lc.port == 0 || !VConsoleServer::getInstance().addListener(options)) {
+			char msg[128];
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Ignoring listener.%s (needs a port and a unique name)\n",
+			         lc.name.c_str());
+			g_engfuncs.pfnServerPrint(msg);
+		}
+	}
+
+	// Our own commands go straight to the engine, past the index hooks
+	ConsoleIndex& consoleIndex = VConsoleServer::getInstance().getConsoleIndex();
+	for (const auto& command : s_commands) {
+		REG_SVR_COMMAND(command.name, command.handler);
+		consoleIndex.add(command.name, CONSOLE_COMMAND);
+	}
+	indexConsoleNames();
+	VConsoleServer::getInstance().setCvarReader(readCvarValue);
 
 	if (VConsoleServer::getInstance().initialize(g_config.port, g_config.bind)) {
-		char msg[128];
-		snprintf(msg, sizeof(msg), "MetamodVConsole: VConsole server listening on %s:%d (max %d conn)\n",
-		         g_config.bind.c_str(), VConsoleServer::getInstance().getPort(),
-		         g_config.max_connections > 0 ? g_config.max_connections : -1);
-		g_engfuncs.pfnServerPrint(msg);
+		for (const Listener& listener : VConsoleServer::getInstance().getListeners()) {
+			const ListenerOptions& o = listener.options;
+			char msg[192];
+			if (listener.socket != INVALID_SOCKET || listener.clients > 0) {
+				snprintf(msg, sizeof(msg), "MetamodVConsole: VConsole %s listener on %s:%d (max %d conn%s, %s I/O)\n",
+				         o.name.c_str(), o.bindAddr.c_str(), o.port, o.maxConnections > 0 ? o.maxConnections : -1,
+				         o.readOnly ? ", read-only" : "", VConsoleServer::getInstance().getIoBackendName());
+			} else {
+				snprintf(msg, sizeof(msg), "MetamodVConsole: Failed to open VConsole %s listener on %s:%d!\n",
+				         o.name.c_str(), o.bindAddr.c_str(), o.port);
+			}
+			g_engfuncs.pfnServerPrint(msg);
+		}
 	} else {
 		char msg[128];
 		snprintf(msg, sizeof(msg), "MetamodVConsole: Failed to start VConsole server on %s:%d!\n",
@@ -97,12 +257,62 @@ C_DLLEXPORT int Meta_Attach(PLUG_LOADTIME now, META_FUNCTIONS *pFunctionTable, m
 		g_engfuncs.pfnServerPrint(msg);
 	}
 
+	if (!g_config.sink_file.empty()) {
+		std::string sinkPath = g_config.sink_file;
+		if (sinkPath[0] != '/') {
+			sinkPath = pluginDir + sinkPath;
+		}
+
+		LogSinkFormat format = g_config.sink_format == "binary" ? LOG_SINK_BINARY : LOG_SINK_JSON;
+		size_t rotateBytes = static_cast<size_t>(g_config.sink_rotate_mb) * 1024 * 1024;
+
+		char msg[256];
+		if (VConsoleServer::getInstance().openLogSink(sinkPath, format, rotateBytes, g_config.sink_keep)) {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Writing %s log to %s\n", g_config.sink_format.c_str(), sinkPath.c_str());
+		} else {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Failed to open log sink %s!\n", sinkPath.c_str());
+		}
+		g_engfuncs.pfnServerPrint(msg);
+	}
+
+	if (!g_config.shm_ring.empty()) {
+		char msg[256];
+		if (VConsoleServer::getInstance().openShmRing(g_config.shm_ring, static_cast<size_t>(g_config.shm_ring_kb) * 1024)) {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Publishing to shared memory ring %s (%zu KB)\n",
+			         g_config.shm_ring.c_str(), VConsoleServer::getInstance().getShmRing().getCapacity() / 1024);
+		} else {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Failed to create shared memory ring %s!\n", g_config.shm_ring.c_str());
+		}
+		g_engfuncs.pfnServerPrint(msg);
+	}
+
+	if (g_config.metrics_port != 0) {
+		char msg[128];
+		if (MetricsServer::getInstance().start(g_config.metrics_port, g_config.metrics_bind)) {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Metrics endpoint on http://%s:%d/metrics\n",
+			         g_config.metrics_bind.c_str(), g_config.metrics_port);
+		} else {
+			snprintf(msg, sizeof(msg), "MetamodVConsole: Failed to start metrics endpoint on %s:%d!\n",
+			         g_config.metrics_bind.c_str(), g_config.metrics_port);
+		}
+		g_engfuncs.pfnServerPrint(msg);
+	}
+
 	memcpy(pFunctionTable, &gMetaFunctionTable, sizeof(META_FUNCTIONS));
 	return TRUE;
 }
 
 C_DLLEXPORT int Meta_Detach(PLUG_LOADTIME now, PL_UNLOAD_REASON reason)
 {
+	MetricsServer::getInstance().stop();
+
+	// Reloads keep clients connected; a plain unload drains and closes everything
+	bool reloading = reason == PNL_FILE_NEWER || reason == PNL_RELOAD;
+	if (reloading && g_config.reload_handoff && VConsoleServer::getInstance().handOff()) {
+		g_engfuncs.pfnServerPrint("MetamodVConsole: Handed connections over for reload\n");
+		return TRUE;
+	}
+
 	g_engfuncs.pfnServerPrint("MetamodVConsole: Shutting down...\n");
 	VConsoleServer::getInstance().shutdown();
 	return TRUE;
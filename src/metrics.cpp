@@ -0,0 +1,181 @@
+#include "metrics.hpp"
+#include <cstdarg>
+#include <cstring>
+
+VConsoleMetrics g_metrics;
+
+const char* captureSourceName(CaptureSource source) {
+    switch (source) {
+        case CAPTURE_STDOUT: return "stdout";
+        case CAPTURE_STDERR: return "stderr";
+        case CAPTURE_PRINT: return "print";
+        case CAPTURE_ALERT: return "alert";
+        default: return "unknown";
+    }
+}
+
+ListenerMetrics* claimListenerMetrics(const char* name) {
+    for (ListenerMetrics& slot : g_metrics.listeners) {
+        if (slot.active.load(std::memory_order_acquire) && strncmp(slot.name, name, sizeof(slot.name) - 1) == 0) {
+            return &slot;
+        }
+    }
+    for (ListenerMetrics& slot : g_metrics.listeners) {
+        if (!slot.active.load(std::memory_order_relaxed)) {
+            snprintf(slot.name, sizeof(slot.name), "%s", name);
+            // The name is complete before a scrape can see the slot
+            slot.active.store(true, std::memory_order_release);
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+static void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void appendf(std::string& out, const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out.append(buf, static_cast<size_t>(n) < sizeof(buf) ? n : sizeof(buf) - 1);
+    }
+}
+
+static void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void appendValue(std::string& out, const char* name, const char* type, const char* help,
+                        const std::atomic<uint64_t>& value) {
+    appendHeader(out, name, type, help);
+    appendf(out, "%s %llu\n", name, static_cast<unsigned long long>(value.load(std::memory_order_relaxed)));
+}
+
+// One sample per claimed listener slot
+static void appendListenerValues(std::string& out, const char* name, const char* type, const char* help,
+                                 std::atomic<uint64_t> ListenerMetrics::*member) {
+    appendHeader(out, name, type, help);
+    for (const ListenerMetrics& slot : g_metrics.listeners) {
+        if (slot.active.load(std::memory_order_acquire)) {
+            appendf(out, "%s{listener=\"%s\"} %llu\n", name, slot.name,
+                    static_cast<unsigned long long>((slot.*member).load(std::memory_order_relaxed)));
+        }
+    }
+}
+
+// Histograms are exported in seconds with the power-of-two bucket limits.
+// Buckets are read one by one, so a scrape racing a writer may be off by a
+// sample; Prometheus tolerates that.
+static void appendHistogram(std::string& out, const char* name, const char* labels, const LatencyHistogram& hist) {
+    const char* sep = labels[0] ? "," : "";
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+        cumulative += hist.bucket(i);
+        appendf(out, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels, sep,
+                LatencyHistogram::bucketLimitMicros(i) / 1e6, static_cast<unsigned long long>(cumulative));
+    }
+    appendf(out, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, static_cast<unsigned long long>(cumulative));
+    if (labels[0]) {
+        appendf(out, "%s_sum{%s} %.9f\n", name, labels, hist.sumNanos() / 1e9);
+        appendf(out, "%s_count{%s} %llu\n", name, labels, static_cast<unsigned long long>(cumulative));
+    } else {
+        appendf(out, "%s_sum %.9f\n", name, hist.sumNanos() / 1e9);
+        appendf(out, "%s_count %llu\n", name, static_cast<unsigned long long>(cumulative));
+    }
+}
+
+std::string formatPrometheus() {
+    const VConsoleMetrics& m = g_metrics;
+    std::string out;
+    out.reserve(16384);
+
+    appendValue(out, "vconsole_clients_connected", "gauge", "Connected VConsole clients.", m.clientsConnected);
+    appendValue(out, "vconsole_clients_accepted_total", "counter", "Client connections accepted.", m.clientsAccepted);
+    appendValue(out, "vconsole_clients_timed_out_total", "counter",
+                "Clients closed by the idle or send timeout.", m.clientsTimedOut);
+    appendValue(out, "vconsole_bytes_sent_total", "counter", "Bytes written to client sockets.", m.bytesSent);
+    appendValue(out, "vconsole_frames_sent_total", "counter", "Frames queued for delivery to clients.", m.framesSent);
+    appendValue(out, "vconsole_frames_dropped_total", "counter", "Frames dropped because a client's backlog was full.", m.framesDropped);
+    appendValue(out, "vconsole_output_queue_bytes", "gauge", "Bytes waiting in client output buffers.", m.outputQueueBytes);
+    appendValue(out, "vconsole_pending_commands", "gauge", "Client commands waiting to be executed.", m.pendingCommands);
+
+    appendValue(out, "vconsole_pipeline_heap_allocs_total", "counter",
+                "Heap allocations made by the capture/broadcast pipeline (arena blocks and buffer growth).",
+                m.pipelineHeapAllocs);
+    appendValue(out, "vconsole_io_syscalls_total", "counter",
+                "Socket and io_uring syscalls made by the I/O backend.", m.ioSyscalls);
+    appendValue(out, "vconsole_tick_overruns_total", "counter",
+                "Server frames in which the plugin exceeded tick_budget_us.", m.tickOverruns);
+    appendValue(out, "vconsole_tick_deferred_total", "counter",
+                "Scheduled work units rolled over to a later frame.", m.tickDeferred);
+    appendValue(out, "vconsole_status_subscribers", "gauge",
+                "Clients subscribed to status snapshots.", m.statusSubscribers);
+    appendValue(out, "vconsole_status_frames_total", "counter",
+                "STAT frames queued for subscribers (full snapshots and deltas).", m.statusFrames);
+    appendValue(out, "vconsole_completion_requests_total", "counter",
+                "CMPL name completion requests answered.", m.completionRequests);
+    appendValue(out, "vconsole_cvar_queries_total", "counter",
+                "CVRQ batched cvar queries answered.", m.cvarQueries);
+    appendValue(out, "vconsole_telemetry_frames_total", "counter",
+                "TELE frame-timing windows queued for subscribers.", m.telemetryFrames);
+
+    appendHeader(out, "vconsole_lines_captured_total", "counter", "Console lines captured, by source.");
+    for (int i = 0; i < CAPTURE_SOURCE_COUNT; i++) {
+        appendf(out, "vconsole_lines_captured_total{source=\"%s\"} %llu\n",
+                captureSourceName(static_cast<CaptureSource>(i)),
+                static_cast<unsigned long long>(m.linesCaptured[i].load(std::memory_order_relaxed)));
+    }
+
+    appendHeader(out, "vconsole_lines_collapsed_total", "counter",
+                 "Repeated console lines held back from clients and counted in a summary, by source.");
+    for (int i = 0; i < CAPTURE_SOURCE_COUNT; i++) {
+        appendf(out, "vconsole_lines_collapsed_total{source=\"%s\"} %llu\n",
+                captureSourceName(static_cast<CaptureSource>(i)),
+                static_cast<unsigned long long>(m.linesCollapsed[i].load(std::memory_order_relaxed)));
+    }
+
+    appendHeader(out, "vconsole_lines_suppressed_total", "counter",
+                 "Captured lines dropped for exceeding their emitter's budget, by source.");
+    for (int i = 0; i < CAPTURE_SOURCE_COUNT; i++) {
+        appendf(out, "vconsole_lines_suppressed_total{source=\"%s\"} %llu\n",
+                captureSourceName(static_cast<CaptureSource>(i)),
+                static_cast<unsigned long long>(m.linesSuppressed[i].load(std::memory_order_relaxed)));
+    }
+
+    appendHeader(out, "vconsole_commands_total", "counter", "Client commands, by result.");
+    appendf(out, "vconsole_commands_total{result=\"queued\"} %llu\n",
+            static_cast<unsigned long long>(m.commandsQueued.load(std::memory_order_relaxed)));
+    appendf(out, "vconsole_commands_total{result=\"throttled\"} %llu\n",
+            static_cast<unsigned long long>(m.commandsThrottled.load(std::memory_order_relaxed)));
+
+    appendListenerValues(out, "vconsole_listener_clients_connected", "gauge",
+                         "Connected clients, by listener.", &ListenerMetrics::clientsConnected);
+    appendListenerValues(out, "vconsole_listener_clients_accepted_total", "counter",
+                         "Client connections accepted, by listener.", &ListenerMetrics::clientsAccepted);
+    appendListenerValues(out, "vconsole_listener_clients_rejected_total", "counter",
+                         "Connections closed because the listener was at max_connections.", &ListenerMetrics::clientsRejected);
+    appendListenerValues(out, "vconsole_listener_bytes_sent_total", "counter",
+                         "Bytes written to client sockets, by listener.", &ListenerMetrics::bytesSent);
+    appendListenerValues(out, "vconsole_listener_frames_sent_total", "counter",
+                         "Frames queued for delivery, by listener.", &ListenerMetrics::framesSent);
+    appendListenerValues(out, "vconsole_listener_frames_dropped_total", "counter",
+                         "Frames dropped because a client's backlog was full, by listener.", &ListenerMetrics::framesDropped);
+    appendListenerValues(out, "vconsole_listener_commands_queued_total", "counter",
+                         "Client commands queued for execution, by listener.", &ListenerMetrics::commandsQueued);
+    appendListenerValues(out, "vconsole_listener_commands_rejected_total", "counter",
+                         "Commands and cvar queries refused by a read-only listener.", &ListenerMetrics::commandsRejected);
+
+    appendHeader(out, "vconsole_tick_seconds", "histogram", "Time spent in the plugin per server frame.");
+    appendHistogram(out, "vconsole_tick_seconds", "", m.tickCost);
+
+    appendHeader(out, "vconsole_output_latency_seconds", "histogram", "Output latency per pipeline stage.");
+    appendHistogram(out, "vconsole_output_latency_seconds", "stage=\"queue_wait\"", m.latency.queueWait);
+    appendHistogram(out, "vconsole_output_latency_seconds", "stage=\"encode\"", m.latency.encode);
+    appendHistogram(out, "vconsole_output_latency_seconds", "stage=\"socket_buffer\"", m.latency.socketBuffer);
+    appendHistogram(out, "vconsole_output_latency_seconds", "stage=\"end_to_end\"", m.latency.endToEnd);
+
+    return out;
+}
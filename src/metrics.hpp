@@ -0,0 +1,186 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+inline uint64_t monotonicNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Power-of-two bucketed histogram of microsecond durations. Bucket 0 holds
+// samples under 1us, bucket i holds [2^(i-1), 2^i) us. Updates are relaxed
+// atomics so any thread may record or read without locking.
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS = 32;
+
+    void record(uint64_t nanos) {
+        uint64_t us = nanos / 1000;
+        int bucket = 0;
+        while (us > 0 && bucket < BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumNanos.fetch_add(nanos, std::memory_order_relaxed);
+
+        uint64_t prev = m_maxNanos.load(std::memory_order_relaxed);
+        while (nanos > prev && !m_maxNanos.compare_exchange_weak(prev, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto& b : m_buckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_sumNanos.store(0, std::memory_order_relaxed);
+        m_maxNanos.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sumNanos() const { return m_sumNanos.load(std::memory_order_relaxed); }
+    uint64_t maxNanos() const { return m_maxNanos.load(std::memory_order_relaxed); }
+    uint64_t bucket(int i) const { return m_buckets[i].load(std::memory_order_relaxed); }
+
+    // Upper bound in microseconds of bucket i
+    static uint64_t bucketLimitMicros(int i) { return i == 0 ? 1 : (1ull << i); }
+
+    // Upper bound of the bucket holding the given percentile, in microseconds
+    uint64_t percentileMicros(double pct) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(total * pct / 100.0);
+        if (target >= total) {
+            target = total - 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += bucket(i);
+            if (seen > target) {
+                return bucketLimitMicros(i);
+            }
+        }
+        return bucketLimitMicros(BUCKETS - 1);
+    }
+
+    int format(char* buf, size_t size, const char* name) const {
+        uint64_t n = count();
+        return snprintf(buf, size, "%-14s n=%-10llu avg=%8.1fus p50<=%lluus p90<=%lluus p99<=%lluus max=%.1fus\n",
+                        name, static_cast<unsigned long long>(n),
+                        n ? sumNanos() / 1000.0 / n : 0.0,
+                        static_cast<unsigned long long>(percentileMicros(50)),
+                        static_cast<unsigned long long>(percentileMicros(90)),
+                        static_cast<unsigned long long>(percentileMicros(99)),
+                        maxNanos() / 1000.0);
+    }
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sumNanos{0};
+    std::atomic<uint64_t> m_maxNanos{0};
+};
+
+// Per-stage output latency, from the moment a line is captured until its
+// last byte is accepted by send()
+struct OutputLatency {
+    LatencyHistogram queueWait;     // capture -> encode start
+    LatencyHistogram encode;        // frame encoding
+    LatencyHistogram socketBuffer;  // queued for a client -> sent
+    LatencyHistogram endToEnd;      // capture -> sent
+
+    void reset() {
+        queueWait.reset();
+        encode.reset();
+        socketBuffer.reset();
+        endToEnd.reset();
+    }
+};
+
+enum CaptureSource {
+    CAPTURE_STDOUT,
+    CAPTURE_STDERR,
+    CAPTURE_PRINT,
+    CAPTURE_ALERT,
+    CAPTURE_SOURCE_COUNT
+};
+
+const char* captureSourceName(CaptureSource source);
+
+constexpr size_t VCON_MAX_LISTENERS = 8;
+
+// Counters for one listener, exported with a listener="name" label. A slot
+// is claimed by name and keeps its counters if the listener is recreated.
+struct ListenerMetrics {
+    char name[32] = {};
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> clientsConnected{0};
+    std::atomic<uint64_t> clientsAccepted{0};
+    std::atomic<uint64_t> clientsRejected{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> framesSent{0};
+    std::atomic<uint64_t> framesDropped{0};
+    std::atomic<uint64_t> commandsQueued{0};
+    std::atomic<uint64_t> commandsRejected{0};
+};
+
+// Process-wide counters. Writers only do relaxed atomic updates, so the
+// engine thread never blocks on the metrics endpoint reading them.
+struct VConsoleMetrics {
+    std::atomic<uint64_t> clientsConnected{0};
+    std::atomic<uint64_t> clientsAccepted{0};
+    std::atomic<uint64_t> clientsTimedOut{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> framesSent{0};
+    std::atomic<uint64_t> framesDropped{0};
+    std::atomic<uint64_t> linesCaptured[CAPTURE_SOURCE_COUNT] = {};
+    std::atomic<uint64_t> linesCollapsed[CAPTURE_SOURCE_COUNT] = {};
+    std::atomic<uint64_t> linesSuppressed[CAPTURE_SOURCE_COUNT] = {};
+    std::atomic<uint64_t> outputQueueBytes{0};
+    std::atomic<uint64_t> pendingCommands{0};
+    std::atomic<uint64_t> commandsQueued{0};
+    std::atomic<uint64_t> commandsThrottled{0};
+    std::atomic<uint64_t> pipelineHeapAllocs{0};
+    std::atomic<uint64_t> ioSyscalls{0};
+    std::atomic<uint64_t> tickOverruns{0};
+    std::atomic<uint64_t> tickDeferred{0};
+    std::atomic<uint64_t> statusSubscribers{0};
+    std::atomic<uint64_t> statusFrames{0};
+    std::atomic<uint64_t> completionRequests{0};
+    std::atomic<uint64_t> cvarQueries{0};
+    std::atomic<uint64_t> telemetryFrames{0};
+    ListenerMetrics listeners[VCON_MAX_LISTENERS];
+
+    LatencyHistogram tickCost;
+    OutputLatency latency;
+};
+
+extern VConsoleMetrics g_metrics;
+
+template <typename T>
+inline void metricAdd(std::atomic<T>& counter, T n = 1) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline void metricSet(std::atomic<T>& gauge, T value) {
+    gauge.store(value, std::memory_order_relaxed);
+}
+
+// Slot for the named listener, claiming a free one the first time; nullptr
+// once all VCON_MAX_LISTENERS are taken. Engine thread only.
+ListenerMetrics* claimListenerMetrics(const char* name);
+
+// Renders every metric in the Prometheus text exposition format
+std::string formatPrometheus();
+
+#endif // METRICS_HPP
@@ -0,0 +1,140 @@
+#include "metrics_server.hpp"
+#include "metrics.hpp"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cstring>
+
+MetricsServer& MetricsServer::getInstance() {
+    static MetricsServer instance;
+    return instance;
+}
+
+MetricsServer::MetricsServer()
+    : m_listenSocket(-1)
+    , m_stop(false)
+{
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(uint16_t port, const std::string& bindAddr) {
+    if (isRunning()) {
+        return true;
+    }
+
+    m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_listenSocket == -1) {
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    if (bindAddr == "0.0.0.0" || bindAddr.empty()) {
+        addr.sin_addr.s_addr = INADDR_ANY;
+    } else {
+        inet_pton(AF_INET, bindAddr.c_str(), &addr.sin_addr);
+    }
+    addr.sin_port = htons(port);
+
+    if (bind(m_listenSocket, (sockaddr*)&addr, sizeof(addr)) == -1 || listen(m_listenSocket, 16) == -1) {
+        close(m_listenSocket);
+        m_listenSocket = -1;
+        return false;
+    }
+
+    m_stop = false;
+    m_thread = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    m_stop = true;
+    m_thread.join();
+
+    close(m_listenSocket);
+    m_listenSocket = -1;
+}
+
+void MetricsServer::run() {
+    while (!m_stop) {
+        pollfd pfd{m_listenSocket, POLLIN, 0};
+        if (poll(&pfd, 1, 250) <= 0) {
+            continue;
+        }
+
+        int client = accept(m_listenSocket, nullptr, nullptr);
+        if (client == -1) {
+            continue;
+        }
+        serveClient(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serveClient(int socket) {
+    // Wait briefly for the request line; its content does not matter
+    char request[2048];
+    size_t received = 0;
+    while (received < sizeof(request)) {
+        pollfd pfd{socket, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) {
+            return;
+        }
+        ssize_t n = recv(socket, request + received, sizeof(request) - received, 0);
+        if (n <= 0) {
+            return;
+        }
+        received += n;
+        if (memmem(request, received, "\r\n\r\n", 4) || memmem(request, received, "\n\n", 2)) {
+            break;
+        }
+    }
+
+    std::string body = formatPrometheus();
+    char header[160];
+    int headerLen = snprintf(header, sizeof(header),
+                             "HTTP/1.0 200 OK\r\n"
+                             "Content-Type: text/plain; version=0.0.4\r\n"
+                             "Content-Length: %zu\r\n"
+                             "Connection: close\r\n\r\n", body.size());
+
+    std::string response(header, headerLen);
+    response += body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(socket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += n;
+    }
+}
+#else
+MetricsServer& MetricsServer::getInstance() {
+    static MetricsServer instance;
+    return instance;
+}
+
+MetricsServer::MetricsServer() : m_listenSocket(-1), m_stop(false) {}
+MetricsServer::~MetricsServer() {}
+bool MetricsServer::start(uint16_t, const std::string&) { return false; }
+void MetricsServer::stop() {}
+void MetricsServer::run() {}
+void MetricsServer::serveClient(int) {}
+#endif
@@ -0,0 +1,33 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Minimal HTTP/1.0 listener serving formatPrometheus() on any request path.
+// Runs on its own thread so scrapes never cost the engine thread time.
+class MetricsServer {
+public:
+    static MetricsServer& getInstance();
+
+    bool start(uint16_t port, const std::string& bindAddr);
+    void stop();
+    bool isRunning() const { return m_thread.joinable(); }
+
+private:
+    MetricsServer();
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void run();
+    void serveClient(int socket);
+
+    int m_listenSocket;
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+};
+
+#endif // METRICS_SERVER_HPP
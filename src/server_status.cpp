@@ -0,0 +1,70 @@
+#include "server_status.hpp"
+#include <extdll.h>
+#include <meta_api.h>
+
+extern enginefuncs_t g_engfuncs;
+extern globalvars_t* gpGlobals;
+
+// Reads the snapshot straight from the engine: the same data `status` prints,
+// without formatting it as text. Runs on the engine thread from tick().
+void collectServerStatus(ServerStatus& status) {
+    status.clear();
+    if (!gpGlobals) {
+        return;
+    }
+
+    status.map = g_engfuncs.pfnSzFromIndex(gpGlobals->mapname);
+    int maxClients = gpGlobals->maxClients;
+    if (maxClients > 255) {
+        maxClients = 255;
+    }
+    status.maxPlayers = static_cast<uint8_t>(maxClients > 0 ? maxClients : 0);
+
+    for (int i = 1; i <= maxClients; i++) {
+        edict_t* edict = g_engfuncs.pfnPEntityOfEntIndex(i);
+        if (!edict || edict->free) {
+            continue;
+        }
+        // Free slots have no user id; connecting players already have one
+        int userId = g_engfuncs.pfnGetPlayerUserId(edict);
+        if (userId <= 0) {
+            continue;
+        }
+
+        int ping = 0;
+        int loss = 0;
+        g_engfuncs.pfnGetPlayerStats(edict, &ping, &loss);
+        const char* name = g_engfuncs.pfnSzFromIndex(edict->v.netname);
+        const char* authId = g_engfuncs.pfnGetPlayerAuthId(edict);
+
+        StatusPlayer player;
+        player.slot = static_cast<uint8_t>(i);
+        player.userId = userId;
+        player.ping = static_cast<uint16_t>(ping < 0 ? 0 : (ping > 0xFFFF ? 0xFFFF : ping));
+        player.frags = static_cast<int32_t>(edict->v.frags);
+        player.name = name ? name : "";
+        player.authId = authId ? authId : "";
+        status.players.push_back(std::move(player));
+    }
+}
+
+// Same rule as collectServerStatus, for TELE frames: only the count is needed
+void countPlayers(uint8_t& players, uint8_t& maxPlayers) {
+    players = 0;
+    maxPlayers = 0;
+    if (!gpGlobals) {
+        return;
+    }
+
+    int maxClients = gpGlobals->maxClients;
+    if (maxClients > 255) {
+        maxClients = 255;
+    }
+    maxPlayers = static_cast<uint8_t>(maxClients > 0 ? maxClients : 0);
+    for (int i = 1; i <= maxClients; i++) {
+        edict_t* edict = g_engfuncs.pfnPEntityOfEntIndex(i);
+        if (edict && !edict->free && g_engfuncs.pfnGetPlayerUserId(edict) > 0) {
+            players++;
+        }
+    }
+}
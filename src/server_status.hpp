@@ -0,0 +1,267 @@
+#ifndef SERVER_STATUS_HPP
+#define SERVER_STATUS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vconsole_protocol.hpp"
+
+// Structured replacement for parsing `status` text. A client opts in by
+// subscribing to VCON_TOPIC_STATUS; the server then pushes STAT frames to
+// it at status_interval_ms. The first STAT after subscribing is a
+// full snapshot, every later one a delta against the snapshot before it.
+// Deltas are only sent when something changed.
+//
+// STAT payload, big-endian:
+//   u8 version, u8 kind (full/delta), u32 seq, u8 flags
+//   [u8 len + map name]           if flags has STATUS_HAS_MAP
+//   u8 max players, u8 player count, u8 entry count
+//   entries: u8 slot, u8 field mask, then the fields in mask order:
+//     name (u8 len + bytes), userid (i32), ping (u16), frags (i32),
+//     auth id (u8 len + bytes)
+//   An entry with STATUS_FIELD_REMOVED carries no fields.
+//
+// A delta's seq is the previous seq + 1; a client that sees a gap sends SUBS
+// again to get a fresh full snapshot.
+constexpr uint8_t VCON_STATUS_VERSION = 1;
+
+enum StatusKind : uint8_t {
+    STATUS_FULL,
+    STATUS_DELTA
+};
+
+constexpr uint8_t STATUS_HAS_MAP = 1u << 0;
+
+constexpr uint8_t STATUS_FIELD_NAME = 1u << 0;
+constexpr uint8_t STATUS_FIELD_USERID = 1u << 1;
+constexpr uint8_t STATUS_FIELD_PING = 1u << 2;
+constexpr uint8_t STATUS_FIELD_FRAGS = 1u << 3;
+constexpr uint8_t STATUS_FIELD_AUTHID = 1u << 4;
+constexpr uint8_t STATUS_FIELD_ALL = 0x1F;
+constexpr uint8_t STATUS_FIELD_REMOVED = 1u << 7;
+
+struct StatusPlayer {
+    uint8_t slot;       // 1-based entity index
+    int32_t userId;
+    uint16_t ping;
+    int32_t frags;
+    std::string name;
+    std::string authId;
+};
+
+struct ServerStatus {
+    std::string map;
+    uint8_t maxPlayers = 0;
+    std::vector<StatusPlayer> players;  // ordered by slot
+
+    void clear() {
+        map.clear();
+        maxPlayers = 0;
+        players.clear();
+    }
+};
+
+namespace status_detail {
+
+inline void putPlayer(std::vector<uint8_t>& out, const StatusPlayer& player, uint8_t fields) {
+    out.push_back(player.slot);
+    out.push_back(fields);
+    if (fields & STATUS_FIELD_NAME) appendString8(out, player.name);
+    if (fields & STATUS_FIELD_USERID) appendBE32(out, static_cast<uint32_t>(player.userId));
+    if (fields & STATUS_FIELD_PING) appendBE16(out, player.ping);
+    if (fields & STATUS_FIELD_FRAGS) appendBE32(out, static_cast<uint32_t>(player.frags));
+    if (fields & STATUS_FIELD_AUTHID) appendString8(out, player.authId);
+}
+
+// Writes the frame header and the fixed part of the payload; returns the
+// offset of the entry count so it can be filled in afterwards
+inline size_t beginFrame(std::vector<uint8_t>& out, StatusKind kind, uint32_t seq, const std::string* map,
+                         const ServerStatus& status) {
+    out.resize(sizeof(VConChunk));
+    out.push_back(VCON_STATUS_VERSION);
+    out.push_back(kind);
+    appendBE32(out, seq);
+    out.push_back(map ? STATUS_HAS_MAP : 0);
+    if (map) {
+        appendString8(out, *map);
+    }
+    out.push_back(status.maxPlayers);
+    out.push_back(static_cast<uint8_t>(status.players.size()));
+    out.push_back(0);
+    return out.size() - 1;
+}
+
+inline bool endFrame(std::vector<uint8_t>& out, size_t countOffset, size_t entries) {
+    out[countOffset] = static_cast<uint8_t>(entries);
+    size_t payloadLen = out.size() - sizeof(VConChunk);
+    if (payloadLen > VCON_MAX_PAYLOAD_SIZE) {
+        out.clear();
+        return false;
+    }
+    writeFrameHeader(out.data(), "STAT", payloadLen);
+    return true;
+}
+
+inline uint8_t changedFields(const StatusPlayer& a, const StatusPlayer& b) {
+    if (a.userId != b.userId) {
+        return STATUS_FIELD_ALL;    // someone else took the slot
+    }
+    uint8_t fields = 0;
+    if (a.name != b.name) fields |= STATUS_FIELD_NAME;
+    if (a.ping != b.ping) fields |= STATUS_FIELD_PING;
+    if (a.frags != b.frags) fields |= STATUS_FIELD_FRAGS;
+    if (a.authId != b.authId) fields |= STATUS_FIELD_AUTHID;
+    return fields;
+}
+
+}  // namespace status_detail
+
+// Replaces out with one STAT frame holding the whole snapshot. out keeps its
+// capacity, so a reused buffer stops allocating. False if it cannot fit.
+inline bool encodeStatusFull(std::vector<uint8_t>& out, const ServerStatus& status, uint32_t seq) {
+    using namespace status_detail;
+    size_t countOffset = beginFrame(out, STATUS_FULL, seq, &status.map, status);
+    for (const StatusPlayer& player : status.players) {
+        putPlayer(out, player, STATUS_FIELD_ALL);
+    }
+    return endFrame(out, countOffset, status.players.size());
+}
+
+// Replaces out with a STAT frame turning prev into cur. Returns false and
+// leaves out empty when nothing changed.
+inline bool encodeStatusDelta(std::vector<uint8_t>& out, const ServerStatus& prev, const ServerStatus& cur,
+                              uint32_t seq) {
+    using namespace status_detail;
+    bool mapChanged = prev.map != cur.map;
+    size_t countOffset = beginFrame(out, STATUS_DELTA, seq, mapChanged ? &cur.map : nullptr, cur);
+
+    // Both lists are ordered by slot, so one merge pass finds every change
+    size_t entries = 0;
+    size_t i = 0, j = 0;
+    while (i < prev.players.size() || j < cur.players.size()) {
+        if (j == cur.players.size() || (i < prev.players.size() && prev.players[i].slot < cur.players[j].slot)) {
+            out.push_back(prev.players[i].slot);
+            out.push_back(STATUS_FIELD_REMOVED);
+            entries++;
+            i++;
+        } else if (i == prev.players.size() || cur.players[j].slot < prev.players[i].slot) {
+            putPlayer(out, cur.players[j], STATUS_FIELD_ALL);
+            entries++;
+            j++;
+        } else {
+            uint8_t fields = changedFields(prev.players[i], cur.players[j]);
+            if (fields) {
+                putPlayer(out, cur.players[j], fields);
+                entries++;
+            }
+            i++;
+            j++;
+        }
+    }
+
+    if (!mapChanged && entries == 0 && prev.maxPlayers == cur.maxPlayers) {
+        out.clear();
+        return false;
+    }
+    return endFrame(out, countOffset, entries);
+}
+
+enum StatusApplyResult {
+    STATUS_APPLIED,
+    STATUS_GAP,         // delta does not follow the last seq; resubscribe
+    STATUS_MALFORMED
+};
+
+// Client side: applies a STAT payload (without the frame header) to status.
+// seq is the last applied sequence number and is updated on success.
+inline StatusApplyResult applyStatusPayload(const uint8_t* p, size_t len, ServerStatus& status, uint32_t& seq) {
+    const uint8_t* end = p + len;
+    auto need = [&](size_t n) { return static_cast<size_t>(end - p) >= n; };
+    auto readString = [&](std::string& s) {
+        if (!need(1) || !need(1 + static_cast<size_t>(p[0]))) {
+            return false;
+        }
+        s.assign(reinterpret_cast<const char*>(p + 1), p[0]);
+        p += 1 + p[0];
+        return true;
+    };
+
+    if (!need(7) || p[0] != VCON_STATUS_VERSION || p[1] > STATUS_DELTA) {
+        return STATUS_MALFORMED;
+    }
+    StatusKind kind = static_cast<StatusKind>(p[1]);
+    uint32_t frameSeq = getBE32(p + 2);
+    uint8_t flags = p[6];
+    p += 7;
+
+    if (kind == STATUS_DELTA && frameSeq != seq + 1) {
+        return STATUS_GAP;
+    }
+
+    ServerStatus next = kind == STATUS_FULL ? ServerStatus() : status;
+    if ((flags & STATUS_HAS_MAP) && !readString(next.map)) {
+        return STATUS_MALFORMED;
+    }
+    if (!need(3)) {
+        return STATUS_MALFORMED;
+    }
+    next.maxPlayers = p[0];
+    uint8_t playerCount = p[1];
+    uint8_t entries = p[2];
+    p += 3;
+
+    for (uint8_t e = 0; e < entries; e++) {
+        if (!need(2)) {
+            return STATUS_MALFORMED;
+        }
+        uint8_t slot = p[0];
+        uint8_t fields = p[1];
+        p += 2;
+
+        auto it = next.players.begin();
+        while (it != next.players.end() && it->slot < slot) {
+            ++it;
+        }
+        if (fields & STATUS_FIELD_REMOVED) {
+            if (it != next.players.end() && it->slot == slot) {
+                next.players.erase(it);
+            }
+            continue;
+        }
+        if (it == next.players.end() || it->slot != slot) {
+            it = next.players.insert(it, StatusPlayer{slot, 0, 0, 0, std::string(), std::string()});
+        }
+
+        StatusPlayer& player = *it;
+        if ((fields & STATUS_FIELD_NAME) && !readString(player.name)) {
+            return STATUS_MALFORMED;
+        }
+        if (fields & STATUS_FIELD_USERID) {
+            if (!need(4)) return STATUS_MALFORMED;
+            player.userId = static_cast<int32_t>(getBE32(p));
+            p += 4;
+        }
+        if (fields & STATUS_FIELD_PING) {
+            if (!need(2)) return STATUS_MALFORMED;
+            player.ping = getBE16(p);
+            p += 2;
+        }
+        if (fields & STATUS_FIELD_FRAGS) {
+            if (!need(4)) return STATUS_MALFORMED;
+            player.frags = static_cast<int32_t>(getBE32(p));
+            p += 4;
+        }
+        if ((fields & STATUS_FIELD_AUTHID) && !readString(player.authId)) {
+            return STATUS_MALFORMED;
+        }
+    }
+
+    if (next.players.size() != playerCount) {
+        return STATUS_MALFORMED;
+    }
+    status = std::move(next);
+    seq = frameSeq;
+    return STATUS_APPLIED;
+}
+
+#endif // SERVER_STATUS_HPP
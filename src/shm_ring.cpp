@@ -0,0 +1,355 @@
+#include "shm_ring.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+
+static size_t alignRecord(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+static long futexCall(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    // Shared (not FUTEX_PRIVATE_FLAG) so the wait and wake match across processes
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+ShmRingWriter::ShmRingWriter()
+    : m_header(nullptr)
+    , m_data(nullptr)
+    , m_capacity(0)
+    , m_mappedSize(0)
+    , m_writePos(0)
+    , m_tailPos(0)
+    , m_nextSeq(1)
+    , m_pending(false)
+    , m_records(0)
+    , m_wakeups(0) {
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    close();
+}
+
+bool ShmRingWriter::open(const std::string& name, size_t capacity) {
+    close();
+
+    size_t cap = SHM_RING_MIN_CAPACITY;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (fd == -1) {
+        return false;
+    }
+
+    size_t size = SHM_RING_HEADER_SIZE + cap;
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // The segment is fresh from ftruncate, so everything starts zeroed;
+    // readers refuse it until the magic is in place
+    ShmRingHeader* header = new (mapping) ShmRingHeader;
+    if (!header->writePos.is_lock_free() || !header->doorbell.is_lock_free()) {
+        munmap(mapping, size);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    header->version = SHM_RING_VERSION;
+    header->capacity = cap;
+    header->writePos.store(0, std::memory_order_relaxed);
+    header->tailPos.store(0, std::memory_order_relaxed);
+    header->nextSeq.store(1, std::memory_order_relaxed);
+    header->doorbell.store(0, std::memory_order_relaxed);
+    header->waiters.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, SHM_RING_MAGIC, sizeof(SHM_RING_MAGIC));
+
+    m_name = name;
+    m_header = header;
+    m_data = static_cast<uint8_t*>(mapping) + SHM_RING_HEADER_SIZE;
+    m_capacity = cap;
+    m_mappedSize = size;
+    m_writePos = 0;
+    m_tailPos = 0;
+    m_nextSeq = 1;
+    m_pending = false;
+    m_records = 0;
+    m_wakeups = 0;
+    return true;
+}
+
+void ShmRingWriter::close() {
+    if (!m_header) {
+        return;
+    }
+    // Unlink first so woken readers looking for a new segment cannot find
+    // this one again, then wake them so they notice the writer is gone
+    shm_unlink(m_name.c_str());
+    m_header->closed.store(1, std::memory_order_release);
+    m_pending = true;
+    notify();
+    munmap(m_header, m_mappedSize);
+    m_header = nullptr;
+    m_data = nullptr;
+}
+
+void ShmRingWriter::write(CaptureSource source, int32_t channelId, uint32_t color, uint64_t unixNanos,
+                          std::string_view line) {
+    if (!m_header) {
+        return;
+    }
+
+    size_t textLen = std::min(line.size(), m_capacity / 4 - sizeof(ShmRingRecord));
+    size_t recordSize = alignRecord(sizeof(ShmRingRecord) + textLen);
+    uint64_t pos = m_writePos;
+    size_t offset = pos & (m_capacity - 1);
+    size_t padding = m_capacity - offset < recordSize ? m_capacity - offset : 0;
+    uint64_t end = pos + padding + recordSize;
+
+    // Reclaim whole records until the new one fits, and publish the new tail
+    // before touching their bytes so a reader copying them sees the overrun.
+    // A size that cannot be a record means someone else wrote to the ring;
+    // everything before the new record is given up then.
+    uint64_t tail = m_tailPos;
+    if (end - tail > m_capacity) {
+        while (end - tail > m_capacity) {
+            size_t tailOffset = tail & (m_capacity - 1);
+            uint32_t size = reinterpret_cast<const ShmRingRecord*>(m_data + tailOffset)->size;
+            if (size == 0 || size % 8 != 0 || size > m_capacity - tailOffset) {
+                tail = pos;
+                break;
+            }
+            tail += size;
+        }
+        m_tailPos = tail;
+        m_header->tailPos.store(tail, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    if (padding > 0) {
+        ShmRingRecord* filler = reinterpret_cast<ShmRingRecord*>(m_data + offset);
+        filler->size = static_cast<uint32_t>(padding);
+        filler->textLen = SHM_RING_PADDING;
+        offset = 0;
+    }
+
+    uint64_t seq = m_nextSeq++;
+    ShmRingRecord* record = reinterpret_cast<ShmRingRecord*>(m_data + offset);
+    record->size = static_cast<uint32_t>(recordSize);
+    record->textLen = static_cast<uint32_t>(textLen);
+    record->channelId = channelId;
+    record->color = color;
+    record->source = source;
+    record->reserved = 0;
+    record->seq = seq;
+    record->unixNanos = unixNanos;
+    memcpy(record + 1, line.data(), textLen);
+
+    m_writePos = end;
+    m_header->nextSeq.store(m_nextSeq, std::memory_order_relaxed);
+    m_header->writePos.store(end, std::memory_order_release);
+    m_pending = true;
+    m_records++;
+}
+
+void ShmRingWriter::notify() {
+    if (!m_header || !m_pending) {
+        return;
+    }
+    m_pending = false;
+    m_header->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    if (m_header->waiters.load(std::memory_order_seq_cst) > 0) {
+        futexCall(&m_header->doorbell, FUTEX_WAKE, INT_MAX, nullptr);
+        m_wakeups++;
+    }
+}
+
+ShmRingReader::ShmRingReader()
+    : m_header(nullptr)
+    , m_data(nullptr)
+    , m_capacity(0)
+    , m_pos(0)
+    , m_nextSeq(0)
+    , m_lost(0) {
+}
+
+ShmRingReader::~ShmRingReader() {
+    close();
+}
+
+bool ShmRingReader::open(const std::string& name, bool fromStart) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    void* header = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > SHM_RING_HEADER_SIZE) {
+        header = mmap(nullptr, SHM_RING_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (header == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    ShmRingHeader* h = static_cast<ShmRingHeader*>(header);
+    bool valid = memcmp(h->magic, SHM_RING_MAGIC, sizeof(SHM_RING_MAGIC)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t cap = static_cast<size_t>(h->capacity);
+    valid = valid && h->closed.load(std::memory_order_relaxed) == 0 && h->version == SHM_RING_VERSION && cap >= SHM_RING_MIN_CAPACITY && (cap & (cap - 1)) == 0 &&
+            static_cast<size_t>(st.st_size) == SHM_RING_HEADER_SIZE + cap;
+
+    // The data area is mapped read-only; the header page stays writable
+    // only for the waiter count
+    void* data = MAP_FAILED;
+    if (valid) {
+        data = mmap(nullptr, cap, PROT_READ, MAP_SHARED, fd, SHM_RING_HEADER_SIZE);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        munmap(header, SHM_RING_HEADER_SIZE);
+        return false;
+    }
+
+    m_header = h;
+    m_data = static_cast<const uint8_t*>(data);
+    m_capacity = cap;
+    m_pos = fromStart ? h->tailPos.load(std::memory_order_acquire) : h->writePos.load(std::memory_order_acquire);
+    m_nextSeq = 0;
+    m_lost = 0;
+    return true;
+}
+
+void ShmRingReader::close() {
+    if (!m_header) {
+        return;
+    }
+    munmap(const_cast<uint8_t*>(m_data), m_capacity);
+    munmap(m_header, SHM_RING_HEADER_SIZE);
+    m_header = nullptr;
+    m_data = nullptr;
+}
+
+// Jumps to the newest line; the lines skipped are counted from the sequence
+// number of the next record read
+void ShmRingReader::resync() {
+    m_pos = m_header->writePos.load(std::memory_order_acquire);
+}
+
+ShmReadResult ShmRingReader::next(ShmRingLine& line) {
+    if (!m_header) {
+        return SHM_READ_EMPTY;
+    }
+
+    for (;;) {
+        if (m_pos == m_header->writePos.load(std::memory_order_acquire)) {
+            return SHM_READ_EMPTY;
+        }
+        if (m_pos < m_header->tailPos.load(std::memory_order_acquire)) {
+            resync();
+            return SHM_READ_OVERRUN;
+        }
+
+        size_t offset = m_pos & (m_capacity - 1);
+        ShmRingRecord record;
+        memcpy(&record, m_data + offset, sizeof(record));
+
+        bool padding = record.textLen == SHM_RING_PADDING;
+        bool valid = record.size >= (padding ? sizeof(uint64_t) : sizeof(ShmRingRecord)) &&
+                     record.size % 8 == 0 && offset + record.size <= m_capacity &&
+                     (padding || sizeof(ShmRingRecord) + record.textLen <= record.size);
+        if (valid && !padding) {
+            line.text.assign(reinterpret_cast<const char*>(m_data + offset + sizeof(ShmRingRecord)), record.textLen);
+        }
+
+        // Anything copied above is only trustworthy if the writer had not
+        // started reclaiming this record by the time the copy finished
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_pos < m_header->tailPos.load(std::memory_order_relaxed) || !valid) {
+            resync();
+            return SHM_READ_OVERRUN;
+        }
+
+        m_pos += record.size;
+        if (padding) {
+            continue;
+        }
+
+        if (m_nextSeq != 0 && record.seq > m_nextSeq) {
+            m_lost += record.seq - m_nextSeq;
+        }
+        m_nextSeq = record.seq + 1;
+
+        line.seq = record.seq;
+        line.unixNanos = record.unixNanos;
+        line.source = record.source < CAPTURE_SOURCE_COUNT ? static_cast<CaptureSource>(record.source) : CAPTURE_PRINT;
+        line.channelId = record.channelId;
+        line.color = record.color;
+        return SHM_READ_LINE;
+    }
+}
+
+bool ShmRingReader::wait(int timeoutMs) {
+    if (!m_header) {
+        return false;
+    }
+
+    uint32_t bell = m_header->doorbell.load(std::memory_order_seq_cst);
+    if (m_pos != m_header->writePos.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000;
+
+    m_header->waiters.fetch_add(1, std::memory_order_seq_cst);
+    futexCall(&m_header->doorbell, FUTEX_WAIT, bell, timeoutMs < 0 ? nullptr : &timeout);
+    m_header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    return m_pos != m_header->writePos.load(std::memory_order_acquire);
+}
+
+#else
+
+ShmRingWriter::ShmRingWriter()
+    : m_header(nullptr), m_data(nullptr), m_capacity(0), m_mappedSize(0), m_pending(false), m_records(0),
+      m_wakeups(0) {}
+ShmRingWriter::~ShmRingWriter() {}
+bool ShmRingWriter::open(const std::string&, size_t) { return false; }
+void ShmRingWriter::close() {}
+void ShmRingWriter::write(CaptureSource, int32_t, uint32_t, uint64_t, std::string_view) {}
+void ShmRingWriter::notify() {}
+
+ShmRingReader::ShmRingReader()
+    : m_header(nullptr), m_data(nullptr), m_capacity(0), m_pos(0), m_nextSeq(0), m_lost(0) {}
+ShmRingReader::~ShmRingReader() {}
+bool ShmRingReader::open(const std::string&, bool) { return false; }
+void ShmRingReader::close() {}
+void ShmRingReader::resync() {}
+ShmReadResult ShmRingReader::next(ShmRingLine&) { return SHM_READ_EMPTY; }
+bool ShmRingReader::wait(int) { return false; }
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "metrics.hpp"
+
+// Shared-memory console ring for readers on the same host (Linux only).
+//
+// The segment is a POSIX shm object: one page of header followed by a
+// power-of-two data area. The plugin is the only writer; any number of
+// readers map the data area read-only and only ever write the waiter count
+// in the header, and the writer never waits for a reader. Readers could
+// still write the rest, so the writer keeps its positions to itself and
+// only stores them into the header, and checks every record it reclaims:
+// a reader that scribbles on the segment can confuse other readers, but
+// never stall the writer.
+//
+// Records are 8-byte aligned and never wrap: when one does not fit before
+// the end of the data area, a padding record fills the rest. Positions are
+// byte offsets that only grow; a position maps to pos & (capacity - 1).
+//
+// Before overwriting old records the writer advances tailPos past them, and
+// only publishes writePos once the new record is complete. A reader copies
+// a record and then re-checks tailPos: if it has moved past the record, the
+// copy may be torn and the reader was overrun.
+//
+// The doorbell is a futex word bumped once per server frame with new lines;
+// the wake syscall is only made while a reader is blocked on it.
+constexpr char SHM_RING_MAGIC[4] = {'V', 'C', 'S', 'R'};
+constexpr uint32_t SHM_RING_VERSION = 1;
+constexpr size_t SHM_RING_HEADER_SIZE = 4096;
+constexpr size_t SHM_RING_MIN_CAPACITY = 64 * 1024;
+constexpr uint32_t SHM_RING_PADDING = 0xFFFFFFFF;
+
+struct ShmRingHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;
+    // Writer-owned positions, on their own cache line
+    alignas(64) std::atomic<uint64_t> writePos;
+    std::atomic<uint64_t> tailPos;
+    std::atomic<uint64_t> nextSeq;
+    // Reader-touched wakeup state, kept off the writer's line
+    alignas(64) std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> closed;   // set once the writer has unlinked the segment
+};
+
+static_assert(sizeof(ShmRingHeader) <= SHM_RING_HEADER_SIZE, "shm ring header must fit its page");
+
+// Record header; textLen SHM_RING_PADDING marks the filler at the end of the
+// data area. size covers header, text and alignment.
+struct ShmRingRecord {
+    uint32_t size;
+    uint32_t textLen;
+    int32_t channelId;
+    uint32_t color;
+    uint32_t source;
+    uint32_t reserved;
+    uint64_t seq;
+    uint64_t unixNanos;
+};
+
+static_assert(sizeof(ShmRingRecord) == 40, "shm ring record header is part of the format");
+
+// Publishes lines into a new shm segment. Only the engine thread writes.
+class ShmRingWriter {
+public:
+    ShmRingWriter();
+    ~ShmRingWriter();
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // name is a shm object name such as "/vconsole"; capacity is rounded up
+    // to a power of two. Replaces any stale segment of the same name.
+    bool open(const std::string& name, size_t capacity);
+    // Unlinks the segment; mapped readers keep their view until they close
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& getName() const { return m_name; }
+    size_t getCapacity() const { return m_capacity; }
+
+    // Lines longer than a quarter of the ring are truncated
+    void write(CaptureSource source, int32_t channelId, uint32_t color, uint64_t unixNanos, std::string_view line);
+    // Rings the doorbell if anything was written since the last call
+    void notify();
+
+    uint64_t getRecords() const { return m_records; }
+    uint64_t getWakeups() const { return m_wakeups; }
+
+private:
+    std::string m_name;
+    ShmRingHeader* m_header;
+    uint8_t* m_data;
+    size_t m_capacity;
+    size_t m_mappedSize;
+    // Published to the header's fields of the same names, never read back
+    uint64_t m_writePos;
+    uint64_t m_tailPos;
+    uint64_t m_nextSeq;
+    bool m_pending;
+    uint64_t m_records;
+    uint64_t m_wakeups;
+};
+
+struct ShmRingLine {
+    uint64_t seq;
+    uint64_t unixNanos;
+    CaptureSource source;
+    int32_t channelId;
+    uint32_t color;
+    std::string text;   // keeps its capacity across next() calls
+};
+
+enum ShmReadResult {
+    SHM_READ_LINE,
+    SHM_READ_EMPTY,
+    SHM_READ_OVERRUN    // lines were lost; the reader now continues at the newest line
+};
+
+// Reader side, usable from any process. Reading is plain memory access;
+// only wait() makes a syscall, and only when the ring is empty.
+class ShmRingReader {
+public:
+    ShmRingReader();
+    ~ShmRingReader();
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Starts at the newest line, or at the oldest one still held with fromStart
+    bool open(const std::string& name, bool fromStart = false);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    ShmReadResult next(ShmRingLine& line);
+    // Blocks until the writer rings the doorbell or timeoutMs passes (-1
+    // waits forever). Returns false on timeout.
+    bool wait(int timeoutMs);
+
+    uint64_t getLost() const { return m_lost; }
+    // True once the writer has gone; a new segment may exist under the name
+    bool isWriterClosed() const { return m_header && m_header->closed.load(std::memory_order_acquire) != 0; }
+
+private:
+    void resync();
+
+    ShmRingHeader* m_header;
+    const uint8_t* m_data;
+    size_t m_capacity;
+    uint64_t m_pos;
+    uint64_t m_nextSeq;
+    uint64_t m_lost;
+};
+
+#endif // SHM_RING_HPP
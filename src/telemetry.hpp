@@ -0,0 +1,309 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "vconsole_protocol.hpp"
+
+// Server frame telemetry, sampled once per StartFrame: the interval since the
+// previous frame, the jitter between consecutive intervals and the plugin's
+// own tick cost. Samples go into fixed 1s and 10s windows; each closed window
+// is summarised with min/avg/max and p50/p95/p99 and pushed as a TELE frame
+// to clients subscribed to VCON_TOPIC_TELEMETRY.
+//
+// TELE payload, big-endian:
+//   u8 version, u8 window (0 = 1s, 1 = 10s), u32 seq (per window),
+//   u32 end unix ms high, u32 end unix ms low, u32 duration ms, u32 frames,
+//   u32 tick rate in 1/100 Hz, u8 players, u8 max players,
+//   then interval, jitter and tick cost, each as u32 min, avg, max, p50,
+//   p95, p99 in nanoseconds (saturating at ~4.29 s)
+constexpr uint8_t VCON_TELEMETRY_VERSION = 1;
+constexpr size_t VCON_TELE_PAYLOAD_SIZE = 28 + 3 * 6 * 4;
+
+enum TelemetryWindowId : uint8_t {
+    TELEMETRY_1S,
+    TELEMETRY_10S,
+    TELEMETRY_WINDOW_COUNT
+};
+
+constexpr uint64_t TELEMETRY_WINDOW_NANOS[TELEMETRY_WINDOW_COUNT] = {1000000000ull, 10000000000ull};
+
+struct TelemetryStats {
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+};
+
+struct TelemetrySummary {
+    uint8_t window;
+    uint32_t seq;
+    uint64_t endUnixMs;
+    uint32_t durationMs;
+    uint32_t frames;
+    uint32_t tickRateCentiHz;
+    uint8_t players;
+    uint8_t maxPlayers;
+    TelemetryStats interval;
+    TelemetryStats jitter;
+    TelemetryStats cost;
+};
+
+// Log-linear histogram of nanosecond samples: 16 buckets per power of two,
+// so a percentile is within ~6% of the true value. Fixed size, no
+// allocation, O(1) per sample; only the engine thread uses it.
+class FrameStat {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (32 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    FrameStat() { reset(); }
+
+    void add(uint64_t nanos) {
+        uint32_t v = nanos > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(nanos);
+        m_buckets[bucketOf(v)]++;
+        m_count++;
+        m_sum += v;
+        if (v < m_min) m_min = v;
+        if (v > m_max) m_max = v;
+    }
+
+    void reset() {
+        memset(m_buckets, 0, sizeof(m_buckets));
+        m_count = 0;
+        m_sum = 0;
+        m_min = UINT32_MAX;
+        m_max = 0;
+    }
+
+    uint32_t count() const { return m_count; }
+
+    TelemetryStats summarize() const {
+        if (m_count == 0) {
+            return TelemetryStats{0, 0, 0, 0, 0, 0};
+        }
+        return TelemetryStats{m_min, static_cast<uint32_t>(m_sum / m_count), m_max,
+                              percentile(50), percentile(95), percentile(99)};
+    }
+
+    static int bucketOf(uint32_t v) {
+        if (v < SUB_BUCKETS) {
+            return static_cast<int>(v);
+        }
+        int exp = 31 - __builtin_clz(v);
+        return ((exp - SUB_BITS + 1) << SUB_BITS) | static_cast<int>((v >> (exp - SUB_BITS)) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t bucketLower(int i) {
+        if (i < SUB_BUCKETS) {
+            return static_cast<uint64_t>(i);
+        }
+        int exp = (i >> SUB_BITS) + SUB_BITS - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS | (i & (SUB_BUCKETS - 1))) << (exp - SUB_BITS);
+    }
+
+private:
+    // Midpoint of the bucket holding the nearest-rank percentile, kept
+    // within the exact min and max
+    uint32_t percentile(int pct) const {
+        uint64_t rank = (static_cast<uint64_t>(m_count) * pct + 99) / 100;
+        if (rank == 0) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                uint64_t mid = (bucketLower(i) + bucketLower(i + 1) - 1) / 2;
+                if (mid < m_min) mid = m_min;
+                if (mid > m_max) mid = m_max;
+                return static_cast<uint32_t>(mid);
+            }
+        }
+        return m_max;
+    }
+
+    uint32_t m_buckets[BUCKETS];
+    uint32_t m_count;
+    uint64_t m_sum;
+    uint32_t m_min;
+    uint32_t m_max;
+};
+
+// Feeds every window from one stream of frames. A window closes at the
+// first frame at or past its length, so a hitch shows up as a long
+// interval in the window it ends, and the window's real duration is what
+// the tick rate is computed from.
+class FrameTelemetry {
+public:
+    FrameTelemetry() : m_lastStart(0), m_lastInterval(0), m_readyCount(0) {
+        for (int i = 0; i < TELEMETRY_WINDOW_COUNT; i++) {
+            m_windows[i].start = 0;
+            m_windows[i].frames = 0;
+            m_windows[i].seq = 0;
+        }
+    }
+
+    // startNs is the monotonic time the frame's tick began, costNs what
+    // the plugin spent in it
+    void frame(uint64_t startNs, uint64_t costNs) {
+        for (int i = 0; i < TELEMETRY_WINDOW_COUNT; i++) {
+            Window& w = m_windows[i];
+            if (w.start == 0) {
+                w.start = startNs;
+            } else if (startNs - w.start >= TELEMETRY_WINDOW_NANOS[i]) {
+                close(static_cast<TelemetryWindowId>(i), startNs);
+            }
+        }
+
+        uint64_t interval = m_lastStart ? startNs - m_lastStart : 0;
+        for (Window& w : m_windows) {
+            w.frames++;
+            w.cost.add(costNs);
+            if (m_lastStart) {
+                w.interval.add(interval);
+            }
+            if (m_lastInterval) {
+                w.jitter.add(interval > m_lastInterval ? interval - m_lastInterval : m_lastInterval - interval);
+            }
+        }
+        m_lastInterval = interval;
+        m_lastStart = startNs;
+    }
+
+    // Hands out closed windows oldest first; players are left for the caller
+    bool takeReady(TelemetrySummary& out) {
+        if (m_readyCount == 0) {
+            return false;
+        }
+        out = m_ready[0];
+        for (size_t i = 1; i < m_readyCount; i++) {
+            m_ready[i - 1] = m_ready[i];
+        }
+        m_readyCount--;
+        return true;
+    }
+
+    // The most recently closed window of each length, for vcon_stats
+    const TelemetrySummary* last(TelemetryWindowId window) const {
+        return m_hasLast[window] ? &m_last[window] : nullptr;
+    }
+
+private:
+    struct Window {
+        uint64_t start;
+        uint32_t frames;
+        uint32_t seq;
+        FrameStat interval;
+        FrameStat jitter;
+        FrameStat cost;
+    };
+
+    void close(TelemetryWindowId id, uint64_t endNs) {
+        Window& w = m_windows[id];
+        uint64_t duration = endNs - w.start;
+
+        TelemetrySummary s;
+        s.window = id;
+        s.seq = ++w.seq;
+        s.endUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        s.durationMs = static_cast<uint32_t>(duration / 1000000);
+        s.frames = w.frames;
+        s.tickRateCentiHz = duration ? static_cast<uint32_t>(w.frames * 100000000000ull / duration) : 0;
+        s.players = 0;
+        s.maxPlayers = 0;
+        s.interval = w.interval.summarize();
+        s.jitter = w.jitter.summarize();
+        s.cost = w.cost.summarize();
+
+        m_last[id] = s;
+        m_hasLast[id] = true;
+        // Nobody draining the queue only loses the oldest summaries
+        if (m_readyCount == MAX_READY) {
+            takeReady(m_ready[0]);
+        }
+        m_ready[m_readyCount++] = s;
+
+        w.start = endNs;
+        w.frames = 0;
+        w.interval.reset();
+        w.jitter.reset();
+        w.cost.reset();
+    }
+
+    static constexpr size_t MAX_READY = 8;
+
+    Window m_windows[TELEMETRY_WINDOW_COUNT];
+    uint64_t m_lastStart;
+    uint64_t m_lastInterval;
+    TelemetrySummary m_ready[MAX_READY];
+    size_t m_readyCount;
+    TelemetrySummary m_last[TELEMETRY_WINDOW_COUNT];
+    bool m_hasLast[TELEMETRY_WINDOW_COUNT] = {};
+};
+
+inline uint8_t* putTelemetryStats(uint8_t* p, const TelemetryStats& s) {
+    p = putBE32(p, s.min);
+    p = putBE32(p, s.avg);
+    p = putBE32(p, s.max);
+    p = putBE32(p, s.p50);
+    p = putBE32(p, s.p95);
+    return putBE32(p, s.p99);
+}
+
+// Writes one TELE frame into out, which must hold
+// sizeof(VConChunk) + VCON_TELE_PAYLOAD_SIZE bytes
+inline size_t encodeTELEFrame(uint8_t* out, const TelemetrySummary& s) {
+    uint8_t* p = writeFrameHeader(out, "TELE", VCON_TELE_PAYLOAD_SIZE);
+    *p++ = VCON_TELEMETRY_VERSION;
+    *p++ = s.window;
+    p = putBE32(p, s.seq);
+    p = putBE32(p, static_cast<uint32_t>(s.endUnixMs >> 32));
+    p = putBE32(p, static_cast<uint32_t>(s.endUnixMs));
+    p = putBE32(p, s.durationMs);
+    p = putBE32(p, s.frames);
+    p = putBE32(p, s.tickRateCentiHz);
+    *p++ = s.players;
+    *p++ = s.maxPlayers;
+    p = putTelemetryStats(p, s.interval);
+    p = putTelemetryStats(p, s.jitter);
+    p = putTelemetryStats(p, s.cost);
+    return p - out;
+}
+
+inline const uint8_t* getTelemetryStats(const uint8_t* p, TelemetryStats& s) {
+    s.min = getBE32(p);
+    s.avg = getBE32(p + 4);
+    s.max = getBE32(p + 8);
+    s.p50 = getBE32(p + 12);
+    s.p95 = getBE32(p + 16);
+    s.p99 = getBE32(p + 20);
+    return p + 24;
+}
+
+// Client side; false for a short payload or an unknown version. Longer
+// payloads are accepted so later versions can append fields.
+inline bool parseTELE(const uint8_t* p, size_t len, TelemetrySummary& s) {
+    if (len < VCON_TELE_PAYLOAD_SIZE || p[0] != VCON_TELEMETRY_VERSION) {
+        return false;
+    }
+    s.window = p[1];
+    s.seq = getBE32(p + 2);
+    s.endUnixMs = (static_cast<uint64_t>(getBE32(p + 6)) << 32) | getBE32(p + 10);
+    s.durationMs = getBE32(p + 14);
+    s.frames = getBE32(p + 18);
+    s.tickRateCentiHz = getBE32(p + 22);
+    s.players = p[26];
+    s.maxPlayers = p[27];
+    p = getTelemetryStats(p + 28, s.interval);
+    p = getTelemetryStats(p, s.jitter);
+    getTelemetryStats(p, s.cost);
+    return true;
+}
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,113 @@
+#ifndef TICK_SCHEDULER_HPP
+#define TICK_SCHEDULER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "metrics.hpp"
+
+enum TickPriority {
+    TICK_CRITICAL,  // runs every frame regardless of the budget
+    TICK_NORMAL,    // skipped once the budget is spent
+    TICK_BULK       // only runs on what is left of the budget
+};
+
+// Frames a deferrable unit may be skipped in a row before it runs anyway,
+// so a frame budget eaten by critical work cannot starve it forever
+constexpr uint32_t TICK_MAX_DEFERRED_FRAMES = 8;
+
+// Splits the plugin's per-frame work into units run in priority order
+// against a time budget. A unit gets the frame deadline and returns false
+// if it stopped early with work left; that work, and every unit skipped
+// outright, rolls over to the next frame. A budget of 0 runs everything.
+//
+// Critical units always run, so the budget is a target rather than a hard
+// cap: frames that still exceed it are counted as overruns.
+class TickScheduler {
+public:
+    using Work = std::function<bool(uint64_t deadlineNs)>;
+
+    struct Unit {
+        const char* name;
+        TickPriority priority;
+        Work work;
+        uint32_t deferredFrames;
+        uint64_t runs;
+        uint64_t rollovers;     // frames the unit was skipped or stopped early
+        uint64_t totalNanos;
+        uint64_t maxNanos;
+    };
+
+    TickScheduler() : m_budgetNs(0), m_frames(0), m_overruns(0), m_maxOverrunNs(0) {}
+
+    // Units keep the order they are added in within the same priority
+    void add(const char* name, TickPriority priority, Work work) {
+        Unit unit{name, priority, std::move(work), 0, 0, 0, 0, 0};
+        auto it = m_units.begin();
+        while (it != m_units.end() && it->priority <= priority) {
+            ++it;
+        }
+        m_units.insert(it, std::move(unit));
+    }
+
+    void setBudgetMicros(uint32_t us) { m_budgetNs = static_cast<uint64_t>(us) * 1000; }
+    uint32_t getBudgetMicros() const { return static_cast<uint32_t>(m_budgetNs / 1000); }
+
+    void run() {
+        uint64_t start = monotonicNanos();
+        uint64_t deadline = m_budgetNs ? start + m_budgetNs : UINT64_MAX;
+        uint64_t now = start;
+
+        for (Unit& unit : m_units) {
+            if (unit.priority != TICK_CRITICAL && now >= deadline &&
+                unit.deferredFrames < TICK_MAX_DEFERRED_FRAMES) {
+                unit.deferredFrames++;
+                unit.rollovers++;
+                metricAdd(g_metrics.tickDeferred);
+                continue;
+            }
+
+            bool finished = unit.work(deadline);
+            uint64_t end = monotonicNanos();
+            uint64_t spent = end - now;
+            now = end;
+
+            unit.runs++;
+            unit.totalNanos += spent;
+            if (spent > unit.maxNanos) {
+                unit.maxNanos = spent;
+            }
+            if (finished) {
+                unit.deferredFrames = 0;
+            } else {
+                unit.deferredFrames++;
+                unit.rollovers++;
+                metricAdd(g_metrics.tickDeferred);
+            }
+        }
+
+        m_frames++;
+        if (m_budgetNs && now - start > m_budgetNs) {
+            uint64_t over = now - start - m_budgetNs;
+            m_overruns++;
+            if (over > m_maxOverrunNs) {
+                m_maxOverrunNs = over;
+            }
+            metricAdd(g_metrics.tickOverruns);
+        }
+    }
+
+    const std::vector<Unit>& getUnits() const { return m_units; }
+    uint64_t getFrames() const { return m_frames; }
+    uint64_t getOverruns() const { return m_overruns; }
+    uint64_t getMaxOverrunNanos() const { return m_maxOverrunNs; }
+
+private:
+    std::vector<Unit> m_units;
+    uint64_t m_budgetNs;
+    uint64_t m_frames;
+    uint64_t m_overruns;
+    uint64_t m_maxOverrunNs;
+};
+
+#endif // TICK_SCHEDULER_HPP
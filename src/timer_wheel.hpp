@@ -0,0 +1,206 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Handle to an armed timer; 0 never names one. Handles carry a generation,
+// so cancelling a timer that already fired, or whose node was reused since,
+// does nothing.
+using TimerId = uint64_t;
+
+// A timer that came due: what it was armed with
+struct TimerEvent {
+    uint32_t kind;
+    uint64_t key;
+};
+
+// Hierarchical timing wheel with 1ms ticks: four levels of 64 slots, each
+// slot of a level spanning a whole turn of the level below, which covers
+// about 4.6 hours; later deadlines wait in the top level and are placed
+// again as it turns. Arming and cancelling are O(1) whatever the number of
+// timers. advance() visits each elapsed tick once, skips straight ahead
+// while nothing is armed, and moves a timer down at most three times before
+// it fires.
+//
+// Timers never fire early: a deadline is rounded up to the next tick, and
+// one already in the past fires on the next advance(). Nodes live in one
+// vector and are recycled through a free list, so a steady state of arming
+// and cancelling does not allocate.
+class TimerWheel {
+public:
+    static constexpr uint64_t TICK_NS = 1000000;
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint64_t HORIZON_TICKS = 1ull << (SLOT_BITS * LEVELS);
+
+    explicit TimerWheel(uint64_t nowNs = 0) { reset(nowNs); }
+
+    // Drops every timer and restarts the clock at nowNs
+    void reset(uint64_t nowNs) {
+        m_nodes.clear();
+        m_free = NIL;
+        m_armed = 0;
+        m_tick = nowNs / TICK_NS + 1;
+        for (uint32_t& head : m_heads) {
+            head = NIL;
+        }
+    }
+
+    TimerId schedule(uint64_t deadlineNs, uint32_t kind, uint64_t key) {
+        uint32_t index = m_free;
+        if (index != NIL) {
+            m_free = m_nodes[index].next;
+        } else {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.push_back(Node());
+        }
+
+        Node& node = m_nodes[index];
+        node.expires = (deadlineNs + TICK_NS - 1) / TICK_NS;
+        if (node.expires < m_tick) {
+            node.expires = m_tick;
+        }
+        node.kind = kind;
+        node.key = key;
+        link(index);
+        m_armed++;
+        return (static_cast<uint64_t>(node.gen) << 32) | (index + 1);
+    }
+
+    // False if the timer already fired or was cancelled
+    bool cancel(TimerId id) {
+        uint32_t index = find(id);
+        if (index == NIL) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    bool armed(TimerId id) const { return find(id) != NIL; }
+    size_t size() const { return m_armed; }
+
+    // Fires every timer due at or before nowNs, appending them to out in
+    // tick order. Fired handles are dead by the time they are returned.
+    void advance(uint64_t nowNs, std::vector<TimerEvent>& out) {
+        uint64_t target = nowNs / TICK_NS;
+        while (m_tick <= target) {
+            if (m_armed == 0) {
+                m_tick = target + 1;
+                return;
+            }
+
+            // Each time a level completes a turn, the next slot of the
+            // level above is spread over the levels below
+            uint32_t index = static_cast<uint32_t>(m_tick & (SLOTS - 1));
+            for (int level = 1; level < LEVELS && index == 0; level++) {
+                index = static_cast<uint32_t>((m_tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+                cascade(level * SLOTS + index);
+            }
+
+            uint32_t& head = m_heads[m_tick & (SLOTS - 1)];
+            uint32_t i = head;
+            head = NIL;
+            while (i != NIL) {
+                uint32_t next = m_nodes[i].next;
+                if (m_nodes[i].expires <= m_tick) {
+                    out.push_back({m_nodes[i].kind, m_nodes[i].key});
+                    release(i);
+                } else {
+                    link(i);
+                }
+                i = next;
+            }
+            m_tick++;
+        }
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint64_t expires = 0;  // absolute tick
+        uint64_t key = 0;
+        uint32_t kind = 0;
+        uint32_t gen = 1;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;  // free list link while released
+        uint32_t slot = NIL;  // index into m_heads, NIL while released
+    };
+
+    uint32_t find(TimerId id) const {
+        uint32_t index = static_cast<uint32_t>(id) - 1;
+        if (id == 0 || index >= m_nodes.size()) {
+            return NIL;
+        }
+        const Node& node = m_nodes[index];
+        return node.gen == static_cast<uint32_t>(id >> 32) && node.slot != NIL ? index : NIL;
+    }
+
+    // Files the node under the level its distance from now falls in
+    void link(uint32_t index) {
+        Node& node = m_nodes[index];
+        uint64_t delta = node.expires - m_tick;
+        uint64_t placed = node.expires;
+        if (delta >= HORIZON_TICKS) {
+            placed = m_tick + HORIZON_TICKS - 1;
+            delta = HORIZON_TICKS - 1;
+        }
+        int level = 0;
+        while (delta >= (1ull << (SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+
+        uint32_t slot = level * SLOTS + static_cast<uint32_t>((placed >> (SLOT_BITS * level)) & (SLOTS - 1));
+        node.slot = slot;
+        node.prev = NIL;
+        node.next = m_heads[slot];
+        if (node.next != NIL) {
+            m_nodes[node.next].prev = index;
+        }
+        m_heads[slot] = index;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = m_nodes[index];
+        if (node.prev != NIL) {
+            m_nodes[node.prev].next = node.next;
+        } else {
+            m_heads[node.slot] = node.next;
+        }
+        if (node.next != NIL) {
+            m_nodes[node.next].prev = node.prev;
+        }
+    }
+
+    void release(uint32_t index) {
+        Node& node = m_nodes[index];
+        node.slot = NIL;
+        node.gen++;
+        node.next = m_free;
+        m_free = index;
+        m_armed--;
+    }
+
+    void cascade(uint32_t slot) {
+        uint32_t i = m_heads[slot];
+        m_heads[slot] = NIL;
+        while (i != NIL) {
+            uint32_t next = m_nodes[i].next;
+            link(i);
+            i = next;
+        }
+    }
+
+    std::vector<Node> m_nodes;
+    uint32_t m_heads[LEVELS * SLOTS];
+    uint32_t m_free;
+    size_t m_armed;
+    uint64_t m_tick;  // next tick to process; everything before it has fired
+};
+
+#endif // TIMER_WHEEL_HPP
@@ -0,0 +1,47 @@
+#ifndef TOKEN_BUCKET_HPP
+#define TOKEN_BUCKET_HPP
+
+#include <chrono>
+#include <algorithm>
+
+// Classic token bucket: refills at `rate` tokens per second up to `burst`.
+// A rate of zero disables limiting entirely.
+struct TokenBucket {
+    using Clock = std::chrono::steady_clock;
+
+    double rate = 0.0;
+    double burst = 0.0;
+    double tokens = 0.0;
+    Clock::time_point last;
+
+    void configure(double r, double b) {
+        rate = r;
+        burst = std::max(b, 1.0);
+        tokens = burst;
+        last = Clock::now();
+    }
+
+    bool enabled() const { return rate > 0.0; }
+
+    void refill(Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last).count();
+        last = now;
+        if (elapsed > 0.0) {
+            tokens = std::min(burst, tokens + elapsed * rate);
+        }
+    }
+
+    bool consume(Clock::time_point now = Clock::now()) {
+        if (!enabled()) {
+            return true;
+        }
+        refill(now);
+        if (tokens < 1.0) {
+            return false;
+        }
+        tokens -= 1.0;
+        return true;
+    }
+};
+
+#endif // TOKEN_BUCKET_HPP
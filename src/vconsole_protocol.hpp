@@ -0,0 +1,488 @@
+#ifndef VCONSOLE_PROTOCOL_HPP
+#define VCONSOLE_PROTOCOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+#pragma pack(push, 1)
+struct VConChunk {
+    char type[4];
+    uint32_t version;
+    uint16_t length;
+    uint16_t handle;
+};
+#pragma pack(pop)
+
+constexpr uint32_t VCON_PROTOCOL_VERSION = 0x000000D4;
+
+// VConChunk::length is 16 bits and covers the header itself
+constexpr size_t VCON_MAX_FRAME_SIZE = 0xFFFF;
+constexpr size_t VCON_MAX_PAYLOAD_SIZE = VCON_MAX_FRAME_SIZE - sizeof(VConChunk);
+
+// PRNT payload: channel id, 8 unknown bytes, color at offset 12, 12 more
+// unknown bytes, then the null-terminated message at offset 28
+constexpr size_t VCON_PRNT_HEADER_SIZE = 28;
+constexpr size_t VCON_MAX_PRNT_TEXT = VCON_MAX_PAYLOAD_SIZE - VCON_PRNT_HEADER_SIZE - 1;
+
+// Optional latency trailer placed after the message terminator: the magic
+// "VLAT" followed by the big-endian monotonic ingest time in nanoseconds.
+// Clients that read the message as a C string never see it.
+constexpr char VCON_TRACE_MAGIC[4] = {'V', 'L', 'A', 'T'};
+constexpr size_t VCON_TRACE_TRAILER_SIZE = 12;
+
+// Largest prefix of [data, data + len) that is at most maxLen bytes and does
+// not end inside a UTF-8 multi-byte sequence. Malformed input (no lead byte
+// within the last 4 bytes) is cut at maxLen.
+inline size_t utf8SplitPoint(const char* data, size_t len, size_t maxLen) {
+    if (len <= maxLen) {
+        return len;
+    }
+
+    size_t cut = maxLen;
+    for (size_t back = 0; back < 4 && cut > 0; back++) {
+        if ((static_cast<unsigned char>(data[cut]) & 0xC0) != 0x80) {
+            return cut;
+        }
+        cut--;
+    }
+    return maxLen;
+}
+
+// Big-endian field writers. They are constexpr so fixed frames can be laid
+// out at compile time; each returns the position after the field.
+constexpr uint8_t* putBE16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+    return p + 2;
+}
+
+constexpr uint8_t* putBE32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+    return p + 4;
+}
+
+constexpr uint16_t getBE16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+constexpr uint32_t getBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Appending variants for payloads built up field by field
+inline void appendBE16(std::vector<uint8_t>& out, uint16_t v) {
+    uint8_t b[2];
+    putBE16(b, v);
+    out.insert(out.end(), b, b + 2);
+}
+
+inline void appendBE32(std::vector<uint8_t>& out, uint32_t v) {
+    uint8_t b[4];
+    putBE32(b, v);
+    out.insert(out.end(), b, b + 4);
+}
+
+// u8 length followed by the bytes, cut to 255 on a UTF-8 boundary
+inline void appendString8(std::vector<uint8_t>& out, std::string_view s) {
+    size_t len = utf8SplitPoint(s.data(), s.size(), 255);
+    out.push_back(static_cast<uint8_t>(len));
+    out.insert(out.end(), s.data(), s.data() + len);
+}
+
+constexpr uint8_t* writeFrameHeader(uint8_t* out, const char* type, size_t payloadLen) {
+    for (size_t i = 0; i < 4; i++) {
+        out[i] = static_cast<uint8_t>(type[i]);
+    }
+    out = putBE32(out + 4, VCON_PROTOCOL_VERSION);
+    out = putBE16(out, static_cast<uint16_t>(sizeof(VConChunk) + payloadLen));
+    return putBE16(out, 0);
+}
+
+// Incoming frame header with the length field already in host order
+struct VConFrameHeader {
+    char type[4];
+    uint16_t length;
+
+    bool is(const char* t) const { return memcmp(type, t, 4) == 0; }
+};
+
+// Reads the header at the front of data; false if fewer than 12 bytes are
+// available or the length field is smaller than the header itself
+inline bool readFrameHeader(const uint8_t* data, size_t len, VConFrameHeader& header) {
+    if (len < sizeof(VConChunk)) {
+        return false;
+    }
+    memcpy(header.type, data, 4);
+    header.length = getBE16(data + offsetof(VConChunk, length));
+    return header.length >= sizeof(VConChunk);
+}
+
+// Hands every complete frame to onFrame(frame, header), carrying on from
+// the unfinished frame an earlier call left in partial and leaving this
+// call's there in turn, so frames can arrive several to a read or split
+// across reads. Frames are read in place unless one spans reads. False on
+// a length field too short to be a frame, after which the stream cannot
+// be resynced.
+template <typename OnFrame>
+inline bool splitFrames(std::vector<uint8_t>& partial, const uint8_t* data, size_t len, OnFrame&& onFrame) {
+    if (!partial.empty()) {
+        partial.insert(partial.end(), data, data + len);
+        data = partial.data();
+        len = partial.size();
+    }
+
+    size_t offset = 0;
+    VConFrameHeader header;
+    while (len - offset >= sizeof(VConChunk)) {
+        if (!readFrameHeader(data + offset, len - offset, header)) {
+            partial.clear();
+            return false;
+        }
+        if (header.length > len - offset) {
+            break;
+        }
+        onFrame(data + offset, header);
+        offset += header.length;
+    }
+
+    if (!partial.empty()) {
+        partial.erase(partial.begin(), partial.begin() + offset);
+    } else {
+        partial.assign(data + offset, data + len);
+    }
+    return true;
+}
+
+// Appends one frame; payloads above VCON_MAX_PAYLOAD_SIZE are rejected since
+// they cannot be represented in the length field.
+inline bool appendFrame(std::vector<uint8_t>& out, const char* type, const uint8_t* payload, size_t payloadLen) {
+    if (payloadLen > VCON_MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    size_t offset = out.size();
+    out.resize(offset + sizeof(VConChunk) + payloadLen);
+    uint8_t* p = writeFrameHeader(out.data() + offset, type, payloadLen);
+    if (payloadLen > 0) {
+        memcpy(p, payload, payloadLen);
+    }
+    return true;
+}
+
+// SUBS payload: a big-endian u32 mask of the topics the client wants pushed
+// to it; each SUBS replaces the previous mask and 0 unsubscribes from all
+constexpr uint32_t VCON_TOPIC_STATUS = 1u << 0;     // STAT, see server_status.hpp
+constexpr uint32_t VCON_TOPIC_TELEMETRY = 1u << 1;  // TELE, see telemetry.hpp
+constexpr uint32_t VCON_TOPIC_KEEPALIVE = 1u << 2;  // PING, see VCON_PING_FRAME
+constexpr uint32_t VCON_TOPICS_KNOWN = VCON_TOPIC_STATUS | VCON_TOPIC_TELEMETRY | VCON_TOPIC_KEEPALIVE;
+
+inline void appendSUBSFrame(std::vector<uint8_t>& out, uint32_t topics) {
+    uint8_t payload[4];
+    putBE32(payload, topics);
+    appendFrame(out, "SUBS", payload, sizeof(payload));
+}
+
+// Upper bound on the bytes encodePRNTFrames() writes for a message. A UTF-8
+// cut backs off at most 3 bytes, which bounds the number of frames.
+inline size_t prntFramesBound(size_t textLen, bool traced) {
+    size_t trailer = traced ? VCON_TRACE_TRAILER_SIZE : 0;
+    size_t perFrame = VCON_MAX_PRNT_TEXT - trailer - 3;
+    size_t frames = textLen == 0 ? 1 : (textLen + perFrame - 1) / perFrame;
+    return textLen + frames * (sizeof(VConChunk) + VCON_PRNT_HEADER_SIZE + 1 + trailer);
+}
+
+// Encodes the message as one or more consecutive PRNT frames into out, which
+// must hold prntFramesBound() bytes. Each frame stays within the 16-bit
+// length limit and is split on a UTF-8 character boundary. Text is copied
+// once, straight from the message. A non-zero traceNanos adds the latency
+// trailer to every frame. Returns the number of bytes written.
+inline size_t encodePRNTFrames(uint8_t* out, std::string_view message, int32_t channelId, uint32_t color,
+                               uint64_t traceNanos = 0, size_t* frameCount = nullptr) {
+    uint8_t* p = out;
+    size_t frames = 0;
+    const char* data = message.data();
+    size_t remaining = message.size();
+    size_t trailer = traceNanos ? VCON_TRACE_TRAILER_SIZE : 0;
+
+    do {
+        size_t chunk = utf8SplitPoint(data, remaining, VCON_MAX_PRNT_TEXT - trailer);
+        size_t payloadLen = VCON_PRNT_HEADER_SIZE + chunk + 1 + trailer;
+
+        p = writeFrameHeader(p, "PRNT", payloadLen);
+
+        memset(p, 0, VCON_PRNT_HEADER_SIZE);
+        putBE32(p, static_cast<uint32_t>(channelId));
+        putBE32(p + 12, color);
+        p += VCON_PRNT_HEADER_SIZE;
+
+        memcpy(p, data, chunk);
+        p[chunk] = 0;
+        p += chunk + 1;
+
+        if (trailer) {
+            memcpy(p, VCON_TRACE_MAGIC, 4);
+            putBE32(p + 4, static_cast<uint32_t>(traceNanos >> 32));
+            putBE32(p + 8, static_cast<uint32_t>(traceNanos));
+            p += trailer;
+        }
+
+        data += chunk;
+        remaining -= chunk;
+        frames++;
+    } while (remaining > 0);
+
+    if (frameCount) {
+        *frameCount = frames;
+    }
+    return p - out;
+}
+
+// Where a line changes color: from offset on, text is in color. A line's
+// runs come after the color it starts in, ascending, inside the line.
+struct ColorRun {
+    uint32_t offset;
+    uint32_t color;
+};
+
+// The color changes of one line, borrowed from whoever captured it
+struct ColorRuns {
+    const ColorRun* data = nullptr;
+    size_t count = 0;
+
+    ColorRuns() = default;
+    ColorRuns(const ColorRun* d, size_t n) : data(d), count(n) {}
+    ColorRuns(const std::vector<ColorRun>& runs) : data(runs.data()), count(runs.size()) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    const ColorRun* begin() const { return data; }
+    const ColorRun* end() const { return data + count; }
+};
+
+// Upper bound on what encodePRNTRuns() writes: each run starts a stretch
+// that costs at most one frame more than the text alone
+inline size_t prntRunsBound(size_t textLen, size_t runCount, bool traced) {
+    size_t trailer = traced ? VCON_TRACE_TRAILER_SIZE : 0;
+    return prntFramesBound(textLen, traced) + runCount * (sizeof(VConChunk) + VCON_PRNT_HEADER_SIZE + 1 + trailer);
+}
+
+// A line in several colors: PRNT has one color per frame, so every stretch
+// in one color is encoded as frames of its own, in order
+inline size_t encodePRNTRuns(uint8_t* out, std::string_view message, int32_t channelId, uint32_t color,
+                             ColorRuns runs, uint64_t traceNanos = 0, size_t* frameCount = nullptr) {
+    size_t written = 0;
+    size_t frames = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= runs.size(); i++) {
+        size_t end = i < runs.size() ? std::min<size_t>(std::max<size_t>(runs.data[i].offset, start), message.size())
+                                     : message.size();
+        if (end > start || (i == runs.size() && frames == 0)) {
+            size_t stretchFrames = 0;
+            written += encodePRNTFrames(out + written, message.substr(start, end - start), channelId, color,
+                                        traceNanos, &stretchFrames);
+            frames += stretchFrames;
+        }
+        if (i < runs.size()) {
+            color = runs.data[i].color;
+            start = end;
+        }
+    }
+    if (frameCount) {
+        *frameCount = frames;
+    }
+    return written;
+}
+
+// Appends the message's PRNT frames to out; returns the number of frames
+inline size_t appendPRNTFrames(std::vector<uint8_t>& out, std::string_view message, int32_t channelId, uint32_t color,
+                               uint64_t traceNanos = 0) {
+    size_t offset = out.size();
+    size_t frames = 0;
+    out.resize(offset + prntFramesBound(message.size(), traceNanos != 0));
+    size_t written = encodePRNTFrames(out.data() + offset, message, channelId, color, traceNanos, &frames);
+    out.resize(offset + written);
+    return frames;
+}
+
+enum ConsoleChannelId {
+    CHANNEL_CONSOLE,
+    CHANNEL_NOTICE,     // at_notice
+    CHANNEL_DEVELOPER,  // at_console, at_aiconsole
+    CHANNEL_WARNING,    // at_warning
+    CHANNEL_ERROR,      // at_error
+    CHANNEL_LOG,        // at_logged
+    CHANNEL_COUNT
+};
+
+struct ConsoleChannel {
+    int32_t id;
+    const char* name;
+    uint32_t color;
+};
+
+// Channels advertised in CHAN, indexed by ConsoleChannelId
+inline constexpr ConsoleChannel VCON_CHANNELS[CHANNEL_COUNT] = {
+    { CHANNEL_CONSOLE,   "Console",   0xFFFFFFFF },
+    { CHANNEL_NOTICE,    "Notice",    0xFF80C0FF },
+    { CHANNEL_DEVELOPER, "Developer", 0xFFA0A0A0 },
+    { CHANNEL_WARNING,   "Warning",   0xFFFFFF00 },
+    { CHANNEL_ERROR,     "Error",     0xFFFF0000 },
+    { CHANNEL_LOG,       "Log",       0xFFFFFFFF },
+};
+
+// One bit per ConsoleChannelId
+constexpr uint32_t VCON_CHANNELS_ALL = (1u << CHANNEL_COUNT) - 1;
+
+// Lines on ids outside the channel table are never filtered
+inline bool channelAllowed(uint32_t mask, int32_t channelId) {
+    return channelId < 0 || channelId >= CHANNEL_COUNT || (mask & (1u << channelId)) != 0;
+}
+
+// Parses "all" or a comma-separated list of channel names such as
+// "console,warning,error", ignoring case and spaces. False if a name is
+// unknown or the list is empty.
+inline bool parseChannelMask(std::string_view list, uint32_t& mask) {
+    auto equalsIgnoreCase = [](std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = (a[i] >= 'A' && a[i] <= 'Z') ? a[i] - 'A' + 'a' : a[i];
+            char y = (b[i] >= 'A' && b[i] <= 'Z') ? b[i] - 'A' + 'a' : b[i];
+            if (x != y) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    uint32_t result = 0;
+    for (bool more = true; more;) {
+        size_t comma = list.find(',');
+        more = comma != std::string_view::npos;
+        std::string_view name = list.substr(0, comma);
+        list = more ? list.substr(comma + 1) : std::string_view();
+        while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) {
+            name.remove_prefix(1);
+        }
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) {
+            name.remove_suffix(1);
+        }
+
+        if (equalsIgnoreCase(name, "all")) {
+            result = VCON_CHANNELS_ALL;
+            continue;
+        }
+        bool found = false;
+        for (const ConsoleChannel& channel : VCON_CHANNELS) {
+            if (equalsIgnoreCase(name, channel.name)) {
+                result |= 1u << channel.id;
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    if (result == 0) {
+        return false;
+    }
+    mask = result;
+    return true;
+}
+
+// AINF payload: 77 bytes of unknown meaning, sent as zeros
+constexpr size_t VCON_AINF_PAYLOAD_SIZE = 77;
+
+// ADON payload: u16 unknown, u16 name length, then the unterminated name
+constexpr size_t VCON_ADON_HEADER_SIZE = 4;
+
+// CHAN payload: u16 count, then per channel the id, two unknown u32s, the
+// default and current verbosity, the color and a 34-byte padded name
+constexpr size_t VCON_CHAN_NAME_SIZE = 34;
+constexpr size_t VCON_CHAN_ENTRY_SIZE = 6 * 4 + VCON_CHAN_NAME_SIZE;
+
+template <size_t N>
+using VConFrame = std::array<uint8_t, N>;
+
+constexpr size_t adonFrameSize(size_t nameLen) {
+    return sizeof(VConChunk) + VCON_ADON_HEADER_SIZE + nameLen;
+}
+
+constexpr size_t chanFrameSize(size_t channelCount) {
+    return sizeof(VConChunk) + 2 + channelCount * VCON_CHAN_ENTRY_SIZE;
+}
+
+constexpr VConFrame<sizeof(VConChunk) + VCON_AINF_PAYLOAD_SIZE> makeAINFFrame() {
+    VConFrame<sizeof(VConChunk) + VCON_AINF_PAYLOAD_SIZE> frame{};
+    writeFrameHeader(frame.data(), "AINF", VCON_AINF_PAYLOAD_SIZE);
+    return frame;
+}
+
+template <size_t N>
+constexpr VConFrame<chanFrameSize(N)> makeCHANFrame(const ConsoleChannel (&channels)[N]) {
+    VConFrame<chanFrameSize(N)> frame{};
+    uint8_t* p = writeFrameHeader(frame.data(), "CHAN", chanFrameSize(N) - sizeof(VConChunk));
+    p = putBE16(p, static_cast<uint16_t>(N));
+    for (const ConsoleChannel& channel : channels) {
+        p = putBE32(p, static_cast<uint32_t>(channel.id));
+        p = putBE32(p, 0);
+        p = putBE32(p, 0);
+        p = putBE32(p, 1);
+        p = putBE32(p, 1);
+        p = putBE32(p, channel.color);
+        // Name stays NUL-terminated within the field, like strncpy(size - 1)
+        for (size_t i = 0; i < VCON_CHAN_NAME_SIZE - 1 && channel.name[i]; i++) {
+            p[i] = static_cast<uint8_t>(channel.name[i]);
+        }
+        p += VCON_CHAN_NAME_SIZE;
+    }
+    return frame;
+}
+
+// Frames that never change are built once, at compile time
+inline constexpr auto VCON_AINF_FRAME = makeAINFFrame();
+inline constexpr auto VCON_CHAN_FRAME = makeCHANFrame(VCON_CHANNELS);
+
+// Keepalive: a client subscribed to VCON_TOPIC_KEEPALIVE is sent an empty
+// PING whenever nothing else went to it for the keepalive interval, and
+// answers with an empty PONG. Any frame a client sends resets its idle
+// timeout, so a listen-only client stays connected by answering PINGs.
+constexpr VConFrame<sizeof(VConChunk)> makeEmptyFrame(const char* type) {
+    VConFrame<sizeof(VConChunk)> frame{};
+    writeFrameHeader(frame.data(), type, 0);
+    return frame;
+}
+
+inline constexpr auto VCON_PING_FRAME = makeEmptyFrame("PING");
+inline constexpr auto VCON_PONG_FRAME = makeEmptyFrame("PONG");
+
+// Encodes an ADON frame into out, which must hold adonFrameSize(name.size())
+// bytes. Returns the bytes written, or 0 if the name does not fit a frame.
+inline size_t encodeADONFrame(uint8_t* out, std::string_view name) {
+    if (name.size() > VCON_MAX_PAYLOAD_SIZE - VCON_ADON_HEADER_SIZE) {
+        return 0;
+    }
+    uint8_t* p = writeFrameHeader(out, "ADON", VCON_ADON_HEADER_SIZE + name.size());
+    p = putBE16(p, 0);
+    p = putBE16(p, static_cast<uint16_t>(name.size()));
+    memcpy(p, name.data(), name.size());
+    return adonFrameSize(name.size());
+}
+
+#endif // VCONSOLE_PROTOCOL_HPP
@@ -1,6 +1,11 @@
 #include "vconsole_server.hpp"
+#include "handoff.hpp"
 #include <cstring>
+#include <cctype>
 #include <algorithm>
+#include <cstdarg>
+#include <chrono>
+#include <thread>
 #include <extdll.h>
 #include <meta_api.h>
 
@@ -10,25 +15,76 @@
 
 extern enginefuncs_t g_engfuncs;
 
+// What a client timer in m_timers is for; the key is the client's ClientId
+enum ClientTimerKind : uint32_t {
+    TIMER_IDLE,
+    TIMER_KEEPALIVE,
+    TIMER_SEND_STALL
+};
+
 VConsoleServer& VConsoleServer::getInstance() {
     static VConsoleServer instance;
     return instance;
 }
 
 VConsoleServer::VConsoleServer()
-    : m_listenSocket(INVALID_SOCKET)
-    , m_port(0)
-    , m_running(false)
+    : m_running(false)
     , m_maxConnections(1)
     , m_logging(true)
+    , m_cmdRate(0.0)
+    , m_cmdBurst(1)
+    , m_totalThrottled(0)
+    , m_latencyDebug(false)
+    , m_drainNs(0)
+    , m_idleTimeoutNs(0)
+    , m_keepaliveNs(0)
+    , m_sendTimeoutNs(0)
+    , m_frameNs(0)
+    , m_budgetSummaryNs(0)
+    , m_outputCapture(true)
+    , m_ansiColors(true)
+    , m_ioType(IO_BACKEND_AUTO)
+    , m_scrollbackLimit(0)
+    , m_scrollbackHead(0)
+    , m_scrollbackTotal(0)
+    , m_statusProvider(nullptr)
+    , m_statusIntervalNs(0)
+    , m_nextStatusNs(0)
+    , m_statusSeq(0)
+    , m_statusValid(false)
+    , m_cvarReader(nullptr)
+    , m_playerCounter(nullptr)
+    , m_flushCursor(0)
+    , m_wantsOutput(false)
 #ifndef _WIN32
     , m_stdoutPipe{-1, -1}
     , m_stderrPipe{-1, -1}
     , m_origStdout(-1)
     , m_origStderr(-1)
     , m_captureActive(false)
+    , m_partialLineNs(0)
+    , m_partialColor(0xFFFFFFFF)
+    , m_stdoutAnsi(0xFFFFFFFF)
+    , m_stderrAnsi(0xFFFF0000)
 #endif
 {
+    // Capture first so the pipes never fill, then the commands clients sent
+    // last frame; socket work and scrollback replay get what is left
+#ifndef _WIN32
+    m_scheduler.add("capture", TICK_CRITICAL, [this](uint64_t) { readCapturedOutput(); return true; });
+#endif
+    m_scheduler.add("repeats", TICK_CRITICAL, [this](uint64_t) { flushRepeats(m_frameNs, false); return true; });
+    m_scheduler.add("budget", TICK_CRITICAL, [this](uint64_t) {
+        reportSuppressed(m_frameNs, m_budgetSummaryNs);
+        return true;
+    });
+    m_scheduler.add("commands", TICK_CRITICAL, [this](uint64_t) { executePendingCommands(); return true; });
+    m_scheduler.add("receive", TICK_NORMAL, [this](uint64_t) { receiveClients(); return true; });
+    m_scheduler.add("timers", TICK_NORMAL, [this](uint64_t) { runTimers(); return true; });
+    m_scheduler.add("send", TICK_NORMAL, [this](uint64_t deadline) { return flushClients(deadline); });
+    m_scheduler.add("status", TICK_BULK, [this](uint64_t) { publishStatus(); return true; });
+    m_scheduler.add("telemetry", TICK_BULK, [this](uint64_t) { publishTelemetry(); return true; });
+    m_scheduler.add("scrollback", TICK_BULK, [this](uint64_t deadline) { return replayScrollback(deadline); });
 }
 
 VConsoleServer::~VConsoleServer() {
@@ -59,67 +115,153 @@ bool VConsoleServer::initialize(uint16_t port, const std::string& bindAddr) {
     }
 #endif
 
-    m_port = port;
-    m_bindAddr = bindAddr;
-    m_running = true;
+    if (port != 0) {
+        Listener listener{};
+        listener.options.name = "default";
+        listener.options.port = port;
+        listener.options.bindAddr = bindAddr;
+        listener.options.maxConnections = m_maxConnections;
+        listener.options.cmdRate = m_cmdRate;
+        listener.options.cmdBurst = m_cmdBurst;
+        m_listeners.insert(m_listeners.begin(), listener);
+    }
+    static ListenerMetrics s_spareMetrics;
+    for (Listener& listener : m_listeners) {
+        listener.socket = INVALID_SOCKET;
+        listener.clients = 0;
+        listener.metrics = claimListenerMetrics(listener.options.name.c_str());
+        if (!listener.metrics) {
+            listener.metrics = &s_spareMetrics;
+        }
+    }
 
-    startListening();
+    m_running = true;
+    m_io = createIoBackend(m_ioType);
+    m_frameNs = monotonicNanos();
+    m_timers.reset(m_frameNs);
+
+    // Clients handed over by the instance this one replaces count against
+    // their listener's connection cap like any other
+    bool adopted = adoptHandoff();
+    bool listening = false;
+    for (Listener& listener : m_listeners) {
+        if (atCapacity(listener)) {
+            stopListening(listener);
+        } else {
+            startListening(listener);
+        }
+        listening = listening || listener.socket != INVALID_SOCKET;
+    }
 
-    if (m_listenSocket == INVALID_SOCKET) {
+    if (!listening && !adopted) {
         m_running = false;
+        m_io.reset();
+        m_listeners.clear();
         return false;
     }
 
 #ifndef _WIN32
-    setupOutputCapture();
+    if (m_outputCapture) {
+        setupOutputCapture();
+    }
 #endif
 
+    updateOutputInterest();
+    return true;
+}
+
+bool VConsoleServer::addListener(const ListenerOptions& options) {
+    if (m_running || m_listeners.size() >= VCON_MAX_LISTENERS || options.name.empty() ||
+        options.name.size() >= sizeof(ListenerMetrics::name) || options.name == "default") {
+        return false;
+    }
+    for (char c : options.name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+    for (const Listener& listener : m_listeners) {
+        if (listener.options.name == options.name) {
+            return false;
+        }
+    }
+
+    Listener listener{};
+    listener.options = options;
+    listener.socket = INVALID_SOCKET;
+    m_listeners.push_back(listener);
     return true;
 }
 
-void VConsoleServer::stopListening() {
-    if (m_listenSocket != INVALID_SOCKET) {
-        ::shutdown(m_listenSocket, SHUT_RDWR);
-        closesocket(m_listenSocket);
-        m_listenSocket = INVALID_SOCKET;
+void VConsoleServer::setTimeouts(uint32_t idleMs, uint32_t keepaliveMs, uint32_t sendMs) {
+    m_idleTimeoutNs = static_cast<uint64_t>(idleMs) * 1000000;
+    m_keepaliveNs = static_cast<uint64_t>(keepaliveMs) * 1000000;
+    m_sendTimeoutNs = static_cast<uint64_t>(sendMs) * 1000000;
+}
+
+void VConsoleServer::setCaptureBudget(double rate, double burst, uint32_t sampleEvery, uint32_t summaryMs) {
+    reportSuppressed(monotonicNanos(), 0);
+    m_captureLimiter.configure(rate, burst, sampleEvery);
+    m_budgetSummaryNs = static_cast<uint64_t>(summaryMs) * 1000000;
+}
+
+void VConsoleServer::setRepeatWindow(uint32_t windowMs) {
+    // Runs held back under the old window are reported before it changes
+    flushRepeats(monotonicNanos(), true);
+    for (RepeatCollapser& repeats : m_repeats) {
+        repeats.setWindow(static_cast<uint64_t>(windowMs) * 1000000);
+    }
+}
+
+bool VConsoleServer::atCapacity(const Listener& listener) const {
+    return listener.options.maxConnections > 0 && static_cast<int>(listener.clients) >= listener.options.maxConnections;
+}
+
+void VConsoleServer::stopListening(Listener& listener) {
+    if (listener.socket != INVALID_SOCKET) {
+        m_io->removeListener(listener.socket);
+        ::shutdown(listener.socket, SHUT_RDWR);
+        closesocket(listener.socket);
+        listener.socket = INVALID_SOCKET;
     }
 }
 
-void VConsoleServer::startListening() {
-    if (m_listenSocket != INVALID_SOCKET || !m_running) {
+void VConsoleServer::startListening(Listener& listener) {
+    if (listener.socket != INVALID_SOCKET || !m_running) {
         return;
     }
 
-    m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (m_listenSocket == INVALID_SOCKET) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) {
         return;
     }
 
     int opt = 1;
-    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
 
+    const std::string& bindAddr = listener.options.bindAddr;
     sockaddr_in serverAddr{};
     serverAddr.sin_family = AF_INET;
-    if (m_bindAddr == "0.0.0.0" || m_bindAddr.empty()) {
+    if (bindAddr == "0.0.0.0" || bindAddr.empty()) {
         serverAddr.sin_addr.s_addr = INADDR_ANY;
     } else {
-        inet_pton(AF_INET, m_bindAddr.c_str(), &serverAddr.sin_addr);
+        inet_pton(AF_INET, bindAddr.c_str(), &serverAddr.sin_addr);
     }
-    serverAddr.sin_port = htons(m_port);
+    serverAddr.sin_port = htons(listener.options.port);
 
-    if (bind(m_listenSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        closesocket(m_listenSocket);
-        m_listenSocket = INVALID_SOCKET;
+    if (bind(s, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+        closesocket(s);
         return;
     }
 
-    if (listen(m_listenSocket, SOMAXCONN) == SOCKET_ERROR) {
-        closesocket(m_listenSocket);
-        m_listenSocket = INVALID_SOCKET;
+    if (listen(s, SOMAXCONN) == SOCKET_ERROR) {
+        closesocket(s);
         return;
     }
 
-    setNonBlocking(m_listenSocket);
+    setNonBlocking(s);
+    listener.socket = s;
+    m_io->addListener(s);
 }
 
 void VConsoleServer::shutdown() {
@@ -127,149 +269,704 @@ void VConsoleServer::shutdown() {
         return;
     }
 
+    if (m_drainNs > 0) {
+        drainClients();
+    }
+
 #ifndef _WIN32
     cleanupOutputCapture();
 #endif
 
     m_running = false;
+    m_logSink.close();
+    m_recorder.close();
+    m_shmRing.close();
 
     std::lock_guard<std::mutex> lock(m_clientsMutex);
     for (auto& client : m_clients) {
+        m_io->removeClient(client.socket);
         ::shutdown(client.socket, SHUT_RDWR);
         closesocket(client.socket);
     }
     m_clients.clear();
-
-    stopListening();
+    m_timers.reset(0);
+    updateOutputInterest();
+    metricSet(g_metrics.clientsConnected, uint64_t(0));
+    metricSet(g_metrics.outputQueueBytes, uint64_t(0));
+
+    for (Listener& listener : m_listeners) {
+        stopListening(listener);
+        metricSet(listener.metrics->clientsConnected, uint64_t(0));
+    }
+    m_listeners.clear();
+    m_io.reset();
 
 #ifdef _WIN32
     WSACleanup();
 #endif
 }
 
-void VConsoleServer::tick() {
-    if (!m_running) {
-        return;
+// Bounded last delivery before the sockets are closed: no new connections or
+// commands are taken, whatever is still in the capture pipes is broadcast,
+// every client gets a final notice, and output is flushed until it is all
+// written or m_drainNs has passed. Input is read and discarded so closing
+// does not reset connections with unread data.
+void VConsoleServer::drainClients() {
+    uint64_t start = monotonicNanos();
+    uint64_t deadline = start + m_drainNs;
+
+    {
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (Listener& listener : m_listeners) {
+            stopListening(listener);
+        }
     }
 
 #ifndef _WIN32
     readCapturedOutput();
+    if (m_captureActive) {
+        flushPartialLine(CAPTURE_STDOUT);
+    }
 #endif
+    reportSuppressed(monotonicNanos(), 0);
+    flushRepeats(monotonicNanos(), true);
+
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    for (auto& client : m_clients) {
+        sendPrint(client, "[VConsole] Server shutting down, closing connection\n", 0, 0xFFFF0000);
+    }
 
-    acceptClients();
-    processClients();
+    size_t drained = 0;
+    uint64_t unsent = 0;
+    for (;;) {
+        drained = 0;
+        unsent = 0;
+        for (auto& client : m_clients) {
+            if (client.closing || !flushClient(client)) {
+                continue;
+            }
+            if (client.pendingBytes() == 0) {
+                drained++;
+            }
+            unsent += client.pendingBytes();
+        }
+        m_io->submit();
+        if ((unsent == 0 && !m_io->sendsInFlight()) || monotonicNanos() >= deadline) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        m_ioEvents.clear();
+        m_io->poll(m_ioEvents);
+        for (const IoEvent& ev : m_ioEvents) {
+            if (ev.type == IO_EVENT_ACCEPT) {
+                closesocket(ev.socket);
+            } else if (ev.type == IO_EVENT_CLOSED) {
+                if (ClientInfo* client = m_clients.find(ev.socket)) {
+                    client->closing = true;
+                }
+            }
+        }
+    }
+
+    if (!m_clients.empty()) {
+        char logMsg[160];
+        snprintf(logMsg, sizeof(logMsg), "[VConsole] Drained %zu of %zu client(s) in %.1fms, %llu bytes left unsent\n",
+                 drained, m_clients.size(), (monotonicNanos() - start) / 1e6, static_cast<unsigned long long>(unsent));
+        logLocal(logMsg);
+    }
 }
 
-void VConsoleServer::acceptClients() {
-    if (m_listenSocket == INVALID_SOCKET) {
-        return;
+bool VConsoleServer::handOff() {
+#ifdef _WIN32
+    return false;
+#else
+    if (!m_running) {
+        return false;
     }
 
-    sockaddr_in clientAddr;
-    socklen_t clientAddrLen = sizeof(clientAddr);
-    SOCKET clientSocket = accept(m_listenSocket, (sockaddr*)&clientAddr, &clientAddrLen);
+    // Whatever is still in the capture pipes goes out with everything else,
+    // an unterminated last line included
+    readCapturedOutput();
+    if (m_captureActive) {
+        flushPartialLine(CAPTURE_STDOUT);
+    }
+    cleanupOutputCapture();
+    reportSuppressed(monotonicNanos(), 0);
+    flushRepeats(monotonicNanos(), true);
+
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    for (auto& client : m_clients) {
+        if (!client.closing) {
+            flushClient(client);
+        }
+    }
+    m_io->submit();
+
+    // Settle the backend; input that was already read is handled now so
+    // commands and replies travel in the blob too
+    std::vector<IoUnsent> unsent;
+    for (const Listener& listener : m_listeners) {
+        if (listener.socket != INVALID_SOCKET) {
+            m_io->removeListener(listener.socket);
+        }
+    }
+    m_ioEvents.clear();
+    m_io->release(m_ioEvents, unsent);
+    for (const IoEvent& ev : m_ioEvents) {
+        ClientInfo* client = m_clients.find(ev.socket);
+        if (!client) {
+            continue;
+        }
+        if (ev.type == IO_EVENT_RECV) {
+            handleClientMessage(*client, ev.data, ev.len);
+        } else if (ev.type == IO_EVENT_CLOSED) {
+            client->closing = true;
+        }
+    }
+    for (IoUnsent& u : unsent) {
+        if (ClientInfo* client = m_clients.find(u.socket)) {
+            client->outBuf.insert(client->outBuf.begin() + client->outOffset, u.data.begin(), u.data.end());
+        }
+    }
 
-    if (clientSocket == INVALID_SOCKET) {
+    HandoffState state;
+    state.pid = static_cast<uint32_t>(getpid());
+    state.createdNs = monotonicNanos();
+    for (const Listener& listener : m_listeners) {
+        state.listeners.push_back({listener.options.name, listener.socket, listener.options.port,
+                                   listener.options.bindAddr});
+    }
+    state.scrollbackTotal = m_scrollbackTotal;
+    for (size_t i = 0; i < m_scrollback.size(); i++) {
+        const ScrollbackLine& line = m_scrollback[(m_scrollbackHead + i) % m_scrollback.size()];
+        state.scrollback.push_back({line.text, line.channelId, line.color, line.runs});
+    }
+    for (const auto& client : m_clients) {
+        if (client.closing) {
+            continue;
+        }
+        HandoffClient h;
+        h.socket = client.socket;
+        h.listener = m_listeners[client.listener].options.name;
+        h.ip = client.ip;
+        h.port = client.port;
+        h.topics = client.topics;
+        h.commandsQueued = client.commandsQueued;
+        h.commandsThrottled = client.commandsThrottled;
+        h.framesDropped = client.framesDropped;
+        h.scrollbackNext = client.scrollbackNext;
+        h.unsent.assign(client.outBuf.begin() + client.outOffset, client.outBuf.end());
+        h.unread = client.inPartial;
+        state.clients.push_back(std::move(h));
+    }
+    for (const auto& pending : m_pendingCommands) {
+        state.commands.push_back({pending.command, pending.source});
+    }
+
+    std::vector<uint8_t> blob;
+    encodeHandoff(state, blob);
+    if (!publishHandoff(blob)) {
+        logLocal("[VConsole] Could not publish reload handoff, closing connections\n");
+        return false;
+    }
+
+    char logMsg[128];
+    snprintf(logMsg, sizeof(logMsg), "[VConsole] Handing %zu client(s) and %zu bytes of state to the next instance\n",
+             state.clients.size(), blob.size());
+    logLocal(logMsg);
+
+    // From here on the sockets belong to the next instance; only the ones
+    // that were closing anyway are closed
+    for (auto& client : m_clients) {
+        if (client.closing) {
+            ::shutdown(client.socket, SHUT_RDWR);
+            closesocket(client.socket);
+        }
+    }
+    m_clients.clear();
+    m_timers.reset(0);
+    m_pendingCommands.clear();
+    for (const Listener& listener : m_listeners) {
+        metricSet(listener.metrics->clientsConnected, uint64_t(0));
+    }
+    m_listeners.clear();
+    m_io.reset();
+    m_running = false;
+    m_logSink.close();
+    m_recorder.close();
+    m_shmRing.close();
+    updateOutputInterest();
+    metricSet(g_metrics.clientsConnected, uint64_t(0));
+    metricSet(g_metrics.outputQueueBytes, uint64_t(0));
+    metricSet(g_metrics.pendingCommands, uint64_t(0));
+    return true;
+#endif
+}
+
+// Takes over what the previous instance handed off, if anything. A blob
+// from another process, a stale one or one this build cannot read is
+// dropped with its sockets closed, and the server starts fresh.
+bool VConsoleServer::adoptHandoff() {
+#ifdef _WIN32
+    return false;
+#else
+    std::vector<uint8_t> blob;
+    if (!takeHandoff(blob)) {
+        return false;
+    }
+
+    auto isSocket = [](int32_t fd) {
+        if (fd < 0) {
+            return false;
+        }
+        int type = 0;
+        socklen_t len = sizeof(type);
+        return getsockopt(fd, SOL_SOCKET, SO_TYPE, reinterpret_cast<char*>(&type), &len) == 0 && type == SOCK_STREAM;
+    };
+
+    // A blob that is not adopted still holds the previous instance's
+    // sockets, which nothing else will ever close. Its header lists them in
+    // every version; they are only trusted if it came from this process.
+    HandoffState state;
+    HandoffDecodeResult result = decodeHandoff(blob.data(), blob.size(), state);
+    bool stale = result == HANDOFF_DECODED && monotonicNanos() - state.createdNs > VCON_HANDOFF_MAX_AGE_NS;
+    if (result != HANDOFF_DECODED || stale || state.pid != static_cast<uint32_t>(getpid())) {
+        logLocal(result == HANDOFF_VERSION_MISMATCH ? "[VConsole] Ignoring reload handoff from an incompatible version\n"
+                 : result == HANDOFF_MALFORMED      ? "[VConsole] Ignoring malformed reload handoff\n"
+                                                    : "[VConsole] Discarding stale reload handoff\n");
+        HandoffHeader header;
+        if (decodeHandoffHeader(blob.data(), blob.size(), header) && header.pid == static_cast<uint32_t>(getpid())) {
+            for (int32_t fd : header.sockets) {
+                if (isSocket(fd)) {
+                    ::shutdown(fd, SHUT_RDWR);
+                    closesocket(fd);
+                }
+            }
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+
+    // A listening socket is only kept if its listener still exists with the
+    // same address in the config
+    size_t listenersAdopted = 0;
+    for (const HandoffListener& h : state.listeners) {
+        if (!isSocket(h.socket)) {
+            continue;
+        }
+        auto it = std::find_if(m_listeners.begin(), m_listeners.end(),
+            [&h](const Listener& l) { return l.options.name == h.name; });
+        if (it != m_listeners.end() && it->socket == INVALID_SOCKET &&
+            it->options.port == h.port && it->options.bindAddr == h.bindAddr) {
+            it->socket = h.socket;
+            m_io->addListener(it->socket);
+            listenersAdopted++;
+        } else {
+            closesocket(h.socket);
+        }
+    }
+
+    size_t keep = std::min(state.scrollback.size(), m_scrollbackLimit);
+    for (size_t i = state.scrollback.size() - keep; i < state.scrollback.size(); i++) {
+        HandoffLine& line = state.scrollback[i];
+        m_scrollback.push_back({std::move(line.text), line.channelId, line.color, std::move(line.runs)});
+    }
+    m_scrollbackHead = 0;
+    m_scrollbackTotal = state.scrollbackTotal;
+
+    size_t dropped = 0;
+    for (HandoffClient& h : state.clients) {
+        if (!isSocket(h.socket)) {
+            continue;
+        }
+        // Clients of a listener that was removed from the config have no
+        // policy left to run under
+        auto it = std::find_if(m_listeners.begin(), m_listeners.end(),
+            [&h](const Listener& l) { return l.options.name == h.listener; });
+        if (it == m_listeners.end()) {
+            ::shutdown(h.socket, SHUT_RDWR);
+            closesocket(h.socket);
+            dropped++;
+            continue;
+        }
+        Listener& listener = *it;
+        ClientInfo* added = m_clients.emplace(h.socket, h.socket, h.ip, h.port, static_cast<size_t>(it - m_listeners.begin()));
+        if (!added) {
+            continue;
+        }
+        ClientInfo& client = *added;
+        m_io->addClient(client.socket);
+        listener.clients++;
+        metricSet(listener.metrics->clientsConnected, static_cast<uint64_t>(listener.clients));
+        client.cmdBucket.configure(listener.options.cmdRate, listener.options.cmdBurst);
+        client.commandsQueued = h.commandsQueued;
+        client.commandsThrottled = h.commandsThrottled;
+        client.framesDropped = h.framesDropped;
+        client.scrollbackNext = h.scrollbackNext;
+        // Status seq restarts here, so subscribers get a fresh full snapshot
+        client.topics = h.topics;
+        client.outBuf = std::move(h.unsent);
+        client.inPartial = std::move(h.unread);
+        armClientTimers(client);
+    }
+
+    for (HandoffCommand& command : state.commands) {
+        m_pendingCommands.push_back({std::move(command.command), std::move(command.source)});
+    }
+
+    metricSet(g_metrics.clientsConnected, static_cast<uint64_t>(m_clients.size()));
+    metricSet(g_metrics.pendingCommands, static_cast<uint64_t>(m_pendingCommands.size()));
+
+    char logMsg[160];
+    snprintf(logMsg, sizeof(logMsg), "[VConsole] Took over %zu client(s) and %zu listener(s) from the previous instance\n",
+             m_clients.size(), listenersAdopted);
+    logLocal(logMsg);
+    if (dropped > 0) {
+        snprintf(logMsg, sizeof(logMsg), "[VConsole] Closed %zu client(s) of listeners no longer configured\n", dropped);
+        logLocal(logMsg);
+    }
+    return true;
+#endif
+}
+
+void VConsoleServer::tick() {
+    if (!m_running) {
         return;
     }
 
-    char clientIP[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIP, INET_ADDRSTRLEN);
-    uint16_t clientPort = ntohs(clientAddr.sin_port);
+    uint64_t start = monotonicNanos();
 
     {
         std::lock_guard<std::mutex> lock(m_clientsMutex);
+        m_frameNs = start;
+    }
 
-        setNonBlocking(clientSocket);
+    m_scheduler.run();
+    reapClients();
+    m_shmRing.notify();
 
-        int opt = 1;
-        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt));
+    uint64_t cost = monotonicNanos() - start;
+    g_metrics.tickCost.record(cost);
+    m_telemetry.frame(start, cost);
+}
 
-        m_clients.emplace_back(clientSocket, clientIP, clientPort);
+void VConsoleServer::acceptClient(SOCKET listenSocket, SOCKET clientSocket, const sockaddr_in& clientAddr) {
+    auto it = std::find_if(m_listeners.begin(), m_listeners.end(),
+        [listenSocket](const Listener& l) { return l.socket == listenSocket; });
+    if (it == m_listeners.end()) {
+        closesocket(clientSocket);
+        return;
+    }
+    // Batched backends can accept past the connection cap in one go
+    Listener& listener = *it;
+    if (atCapacity(listener)) {
+        metricAdd(listener.metrics->clientsRejected);
+        closesocket(clientSocket);
+        return;
+    }
 
-        if (m_maxConnections > 0 && static_cast<int>(m_clients.size()) >= m_maxConnections) {
-            stopListening();
-        }
+    char clientIP[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIP, INET_ADDRSTRLEN);
+    uint16_t clientPort = ntohs(clientAddr.sin_port);
+
+    setNonBlocking(clientSocket);
+
+    int opt = 1;
+    setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt));
+
+    ClientInfo* added = m_clients.emplace(clientSocket, clientSocket, clientIP, clientPort,
+                                          static_cast<size_t>(it - m_listeners.begin()));
+    if (!added) {
+        closesocket(clientSocket);
+        return;
+    }
+    ClientInfo& client = *added;
+    m_io->addClient(clientSocket);
+    listener.clients++;
+    metricAdd(g_metrics.clientsAccepted);
+    metricSet(g_metrics.clientsConnected, static_cast<uint64_t>(m_clients.size()));
+    metricAdd(listener.metrics->clientsAccepted);
+    metricSet(listener.metrics->clientsConnected, static_cast<uint64_t>(listener.clients));
+    updateOutputInterest();
+    client.cmdBucket.configure(listener.options.cmdRate, listener.options.cmdBurst);
+    armClientTimers(client);
+
+    sendAINF(client);
+    sendADON(client, "HLDS");
+    sendCHAN(client);
+    client.scrollbackNext = m_scrollbackTotal - m_scrollback.size();
+
+    if (atCapacity(listener)) {
+        stopListening(listener);
     }
 
     char logMsg[128];
-    snprintf(logMsg, sizeof(logMsg), "[VConsole] Client connected: %s:%u\n", clientIP, clientPort);
+    snprintf(logMsg, sizeof(logMsg), "[VConsole] Client connected: %s:%u (%s)\n", clientIP, clientPort,
+             listener.options.name.c_str());
     logLocal(logMsg);
-
-    sendAINF(clientSocket);
-    sendADON(clientSocket, "HLDS");
-    sendCHAN(clientSocket);
 }
 
-void VConsoleServer::processClients() {
+void VConsoleServer::receiveClients() {
     std::lock_guard<std::mutex> lock(m_clientsMutex);
 
-    std::vector<SOCKET> toRemove;
+    m_ioEvents.clear();
+    m_io->poll(m_ioEvents);
 
-    for (auto& client : m_clients) {
-        char buffer[4096];
-        int bytesReceived = recv(client.socket, buffer, sizeof(buffer), 0);
+    for (const IoEvent& ev : m_ioEvents) {
+        if (ev.type == IO_EVENT_ACCEPT) {
+            acceptClient(ev.listener, ev.socket, ev.addr);
+            continue;
+        }
 
-        if (bytesReceived > 0) {
-            handleClientMessage(client, buffer, bytesReceived);
-        } else if (bytesReceived == 0) {
-            toRemove.push_back(client.socket);
+        ClientInfo* client = m_clients.find(ev.socket);
+        if (!client) {
+            continue;
+        }
+        if (ev.type == IO_EVENT_RECV) {
+            client->lastReceiveNs = m_frameNs;
+            handleClientMessage(*client, ev.data, ev.len);
         } else {
-#ifdef _WIN32
-            if (SOCKET_ERROR_CODE != WSAEWOULDBLOCK) {
-                toRemove.push_back(client.socket);
-            }
-#else
-            if (SOCKET_ERROR_CODE != EWOULDBLOCK && SOCKET_ERROR_CODE != EAGAIN) {
-                toRemove.push_back(client.socket);
-            }
-#endif
+            client->closing = true;
+        }
+    }
+}
+
+// Flushes clients round-robin from where the last frame stopped, so when the
+// budget cuts a frame short the same clients are not always the ones waiting
+bool VConsoleServer::flushClients(uint64_t deadlineNs) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+
+    size_t count = m_clients.size();
+    for (size_t i = 0; i < count; i++) {
+        ClientInfo& client = m_clients[(m_flushCursor + i) % count];
+        if (!client.closing) {
+            flushClient(client);
+        }
+        if (i + 1 < count && monotonicNanos() >= deadlineNs) {
+            m_flushCursor = (m_flushCursor + i + 1) % count;
+            return false;
         }
     }
+    m_flushCursor = 0;
+    return true;
+}
 
-    for (SOCKET s : toRemove) {
-        removeClient(s);
+// Deadlines a client starts out with. The send stall timer is armed by
+// queueFrames() once output is left waiting.
+void VConsoleServer::armClientTimers(ClientInfo& client) {
+    ClientId id = m_clients.idOf(client);
+    client.lastReceiveNs = m_frameNs;
+    client.lastQueuedNs = m_frameNs;
+    client.lastProgressNs = m_frameNs;
+    if (m_idleTimeoutNs > 0) {
+        client.idleTimer = m_timers.schedule(m_frameNs + m_idleTimeoutNs, TIMER_IDLE, id);
     }
+    if (m_keepaliveNs > 0 && (client.topics & VCON_TOPIC_KEEPALIVE)) {
+        client.keepaliveTimer = m_timers.schedule(m_frameNs + m_keepaliveNs, TIMER_KEEPALIVE, id);
+    }
+    if (m_sendTimeoutNs > 0 && client.pendingBytes() > 0) {
+        client.stallTimer = m_timers.schedule(m_frameNs + m_sendTimeoutNs, TIMER_SEND_STALL, id);
+    }
+}
 
-    if (!toRemove.empty() && m_listenSocket == INVALID_SOCKET) {
-        if (m_maxConnections == 0 || static_cast<int>(m_clients.size()) < m_maxConnections) {
-            startListening();
+// Handles the client deadlines that came due. A timer made stale by later
+// activity is pushed back to the new deadline rather than re-armed on
+// every frame sent or received. Keys are ClientIds, so a timer that
+// outlived its client finds nothing even once the slot is reused.
+void VConsoleServer::runTimers() {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+
+    m_timerEvents.clear();
+    m_timers.advance(m_frameNs, m_timerEvents);
+    for (const TimerEvent& ev : m_timerEvents) {
+        ClientInfo* found = m_clients.get(ev.key);
+        if (!found || found->closing) {
+            continue;
+        }
+        ClientInfo& client = *found;
+
+        char logMsg[128] = "";
+        if (ev.kind == TIMER_IDLE) {
+            client.idleTimer = 0;
+            uint64_t deadline = client.lastReceiveNs + m_idleTimeoutNs;
+            if (deadline > m_frameNs) {
+                client.idleTimer = m_timers.schedule(deadline, TIMER_IDLE, ev.key);
+            } else {
+                snprintf(logMsg, sizeof(logMsg), "[VConsole] Closing %s:%u: nothing received for %.1fs\n",
+                         client.ip.c_str(), client.port, (m_frameNs - client.lastReceiveNs) / 1e9);
+            }
+        } else if (ev.kind == TIMER_KEEPALIVE) {
+            client.keepaliveTimer = 0;
+            if (!(client.topics & VCON_TOPIC_KEEPALIVE)) {
+                continue;
+            }
+            if (client.lastQueuedNs + m_keepaliveNs <= m_frameNs) {
+                queueFrames(client, VCON_PING_FRAME.data(), VCON_PING_FRAME.size(), 1);
+            }
+            uint64_t next = client.lastQueuedNs + m_keepaliveNs;
+            if (next <= m_frameNs) {
+                // The PING was dropped on a full backlog; retry a whole interval later
+                next = m_frameNs + m_keepaliveNs;
+            }
+            client.keepaliveTimer = m_timers.schedule(next, TIMER_KEEPALIVE, ev.key);
+        } else if (ev.kind == TIMER_SEND_STALL) {
+            client.stallTimer = 0;
+            uint64_t deadline = client.lastProgressNs + m_sendTimeoutNs;
+            if (client.pendingBytes() == 0) {
+                continue;
+            }
+            if (deadline > m_frameNs) {
+                client.stallTimer = m_timers.schedule(deadline, TIMER_SEND_STALL, ev.key);
+            } else {
+                snprintf(logMsg, sizeof(logMsg), "[VConsole] Closing %s:%u: %zu bytes unsent for %.1fs\n",
+                         client.ip.c_str(), client.port, client.pendingBytes(),
+                         (m_frameNs - client.lastProgressNs) / 1e9);
+            }
+        }
+
+        if (logMsg[0]) {
+            client.closing = true;
+            metricAdd(g_metrics.clientsTimedOut);
+            logLocal(logMsg);
         }
     }
 }
 
-void VConsoleServer::handleClientMessage(ClientInfo& client, const char* data, size_t len) {
-    if (len < sizeof(VConChunk)) {
-        return;
+// Runs every frame after the scheduled work: drops closed clients, updates
+// the queue gauge and hands queued I/O to the kernel
+void VConsoleServer::reapClients() {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+
+    // Back to front, since removal moves the last client into the hole
+    bool removed = false;
+    for (size_t i = m_clients.size(); i-- > 0;) {
+        if (m_clients[i].closing) {
+            removeClient(i);
+            removed = true;
+        }
     }
 
-    const VConChunk* header = reinterpret_cast<const VConChunk*>(data);
-    std::string msgType(header->type, 4);
+    uint64_t queued = 0;
+    for (const auto& client : m_clients) {
+        queued += client.pendingBytes();
+    }
+    metricSet(g_metrics.outputQueueBytes, queued);
 
-    if (msgType == "CMND") {
-        uint16_t packetLen = ntohs(header->length);
-        if (packetLen > len) {
-            return;
+    if (removed) {
+        for (Listener& listener : m_listeners) {
+            if (listener.socket == INVALID_SOCKET && !atCapacity(listener)) {
+                startListening(listener);
+            }
         }
+    }
+
+    m_io->submit();
+}
 
+// Whatever one recv returned: any number of frames, the last possibly cut
+// short, in which case its start waits in the client's inPartial
+void VConsoleServer::handleClientMessage(ClientInfo& client, const char* data, size_t len) {
+    bool ok = splitFrames(client.inPartial, reinterpret_cast<const uint8_t*>(data), len,
+                          [&](const uint8_t* frame, const VConFrameHeader& header) {
+        if (!client.closing) {
+            handleClientFrame(client, reinterpret_cast<const char*>(frame), header);
+        }
+    });
+    if (!ok && !client.closing) {
+        char logMsg[128];
+        snprintf(logMsg, sizeof(logMsg), "[VConsole] Closing %s:%u: malformed frame length\n", client.ip.c_str(),
+                 client.port);
+        logLocal(logMsg);
+        client.closing = true;
+    }
+}
+
+void VConsoleServer::handleClientFrame(ClientInfo& client, const char* data, const VConFrameHeader& header) {
+    size_t len = header.length;
+    if (header.is("CMND")) {
         const char* cmdData = data + sizeof(VConChunk);
-        size_t cmdLen = packetLen - sizeof(VConChunk);
+        size_t cmdLen = header.length - sizeof(VConChunk);
 
         if (cmdLen > 0) {
             std::string command(cmdData, strnlen(cmdData, cmdLen));
             if (!command.empty()) {
-                char logMsg[512];
-                snprintf(logMsg, sizeof(logMsg), "[VConsole] Command from %s:%u: %s\n",
-                         client.ip.c_str(), client.port, command.c_str());
-                logLocal(logMsg);
-
-                extern void executeServerCommand(const std::string& cmd);
-                executeServerCommand(command);
+                Listener& listener = m_listeners[client.listener];
+                if (listener.options.readOnly) {
+                    metricAdd(listener.metrics->commandsRejected);
+                    sendPrint(client, "[VConsole] Command rejected: this connection is read-only\n", 0, 0xFFFF0000);
+                    return;
+                }
+                if (!client.cmdBucket.consume()) {
+                    client.commandsThrottled++;
+                    metricAdd(g_metrics.commandsThrottled);
+                    m_totalThrottled++;
+
+                    if (!client.throttled) {
+                        client.throttled = true;
+                        char logMsg[128];
+                        snprintf(logMsg, sizeof(logMsg), "[VConsole] Throttling commands from %s:%u\n",
+                                 client.ip.c_str(), client.port);
+                        logLocal(logMsg);
+                    }
+
+                    char notice[256];
+                    snprintf(notice, sizeof(notice),
+                             "[VConsole] Command rejected: rate limit exceeded (%.1f/s, burst %d)\n",
+                             client.cmdBucket.rate, static_cast<int>(client.cmdBucket.burst));
+                    sendPrint(client, notice, 0, 0xFFFF0000);
+                    return;
+                }
+                client.throttled = false;
+                client.commandsQueued++;
+                metricAdd(g_metrics.commandsQueued);
+                metricAdd(listener.metrics->commandsQueued);
+
+                char source[64];
+                snprintf(source, sizeof(source), "%s:%u", client.ip.c_str(), client.port);
+                m_pendingCommands.push_back({std::move(command), source});
+                metricSet(g_metrics.pendingCommands, static_cast<uint64_t>(m_pendingCommands.size()));
             }
         }
+    } else if (header.is("CMPL") || header.is("CVRQ")) {
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(data) + sizeof(VConChunk);
+        size_t payloadLen = header.length - sizeof(VConChunk);
+        if (header.is("CMPL")) {
+            answerCompletion(client, payload, payloadLen);
+        } else {
+            answerCvarQuery(client, payload, payloadLen);
+        }
+    } else if (header.is("PING") || header.is("PONG")) {
+        // Receiving it already counted as activity; a PING is answered
+        if (header.is("PING")) {
+            queueFrames(client, VCON_PONG_FRAME.data(), VCON_PONG_FRAME.size(), 1);
+        }
+    } else if (header.is("SUBS")) {
+        if (header.length < sizeof(VConChunk) + 4) {
+            return;
+        }
+
+        uint32_t topics = getBE32(reinterpret_cast<const uint8_t*>(data) + sizeof(VConChunk)) & VCON_TOPICS_KNOWN;
+        if (topics != client.topics) {
+            char logMsg[128];
+            snprintf(logMsg, sizeof(logMsg), "[VConsole] %s:%u subscribed to:%s%s%s%s\n", client.ip.c_str(), client.port,
+                     (topics & VCON_TOPIC_STATUS) ? " status" : "",
+                     (topics & VCON_TOPIC_TELEMETRY) ? " telemetry" : "",
+                     (topics & VCON_TOPIC_KEEPALIVE) ? " keepalive" : "",
+                     topics ? "" : " nothing");
+            logLocal(logMsg);
+        }
+        client.topics = topics;
+        if ((topics & VCON_TOPIC_KEEPALIVE) && m_keepaliveNs > 0 && client.keepaliveTimer == 0) {
+            client.keepaliveTimer = m_timers.schedule(m_frameNs + m_keepaliveNs, TIMER_KEEPALIVE, m_clients.idOf(client));
+        }
+        // Subscribing again is also how a client that missed a delta asks
+        // for a fresh full snapshot
+        client.statusSynced = false;
     } else {
         char logMsg[512];
-        snprintf(logMsg, sizeof(logMsg), "[VConsole] Unknown packet type '%s', hex dump: ", msgType.c_str());
+        snprintf(logMsg, sizeof(logMsg), "[VConsole] Unknown packet type '%.4s', hex dump: ", header.type);
         logLocal(logMsg);
 
         std::string hexDump;
@@ -284,20 +981,134 @@ void VConsoleServer::handleClientMessage(ClientInfo& client, const char* data, s
     }
 }
 
-void VConsoleServer::removeClient(SOCKET socket) {
-    auto it = std::find_if(m_clients.begin(), m_clients.end(),
-        [socket](const ClientInfo& c) { return c.socket == socket; });
-    if (it != m_clients.end()) {
-        char logMsg[128];
-        snprintf(logMsg, sizeof(logMsg), "[VConsole] Client disconnected: %s:%u\n", it->ip.c_str(), it->port);
-        logLocal(logMsg);
+// Completion and cvar queries are answered straight away from the index;
+// neither runs an engine command or produces console output
+void VConsoleServer::answerCompletion(ClientInfo& client, const uint8_t* payload, size_t len) {
+    CompletionRequest request{};
+    if (!parseCMPL(payload, len, request)) {
+        return;
+    }
+    metricAdd(g_metrics.completionRequests);
+
+    m_completions.clear();
+    size_t total = m_consoleIndex.complete(request.prefix, request.maxResults, request.kinds, m_completions);
+    encodeCMPRFrame(m_replyFrame, request.id, total, m_completions);
+    queueFrames(client, m_replyFrame.data(), m_replyFrame.size(), 1);
+}
+
+void VConsoleServer::answerCvarQuery(ClientInfo& client, const uint8_t* payload, size_t len) {
+    uint32_t id = 0;
+    m_cvarNames.clear();
+    if (!parseCVRQ(payload, len, id, m_cvarNames)) {
+        return;
+    }
+    metricAdd(g_metrics.cvarQueries);
+
+    // Cvar values can hold passwords, so a read-only connection is told
+    // every cvar is unknown
+    Listener& listener = m_listeners[client.listener];
+    if (listener.options.readOnly) {
+        metricAdd(listener.metrics->commandsRejected);
+    }
+
+    m_cvarValues.clear();
+    for (std::string_view name : m_cvarNames) {
+        const char* value = nullptr;
+        if (m_cvarReader && !listener.options.readOnly) {
+            const ConsoleIndex::Entry* entry = m_consoleIndex.find(name);
+            m_cvarName.assign(name.data(), name.size());
+            value = m_cvarReader(entry && entry->kind == CONSOLE_CVAR ? entry : nullptr, m_cvarName.c_str());
+        }
+        m_cvarValues.push_back({name, value});
+    }
+    encodeCVRSFrame(m_replyFrame, id, m_cvarValues);
+    queueFrames(client, m_replyFrame.data(), m_replyFrame.size(), 1);
+}
+
+void VConsoleServer::removeClient(size_t index) {
+    ClientInfo& client = m_clients[index];
+    char logMsg[128];
+    snprintf(logMsg, sizeof(logMsg), "[VConsole] Client disconnected: %s:%u\n", client.ip.c_str(), client.port);
+    logLocal(logMsg);
+
+    m_timers.cancel(client.idleTimer);
+    m_timers.cancel(client.keepaliveTimer);
+    m_timers.cancel(client.stallTimer);
+    m_io->removeClient(client.socket);
+    ::shutdown(client.socket, SHUT_RDWR);
+    closesocket(client.socket);
+    Listener& listener = m_listeners[client.listener];
+    listener.clients--;
+    metricSet(listener.metrics->clientsConnected, static_cast<uint64_t>(listener.clients));
+    m_clients.removeAt(index);
+    metricSet(g_metrics.clientsConnected, static_cast<uint64_t>(m_clients.size()));
+    updateOutputInterest();
+}
+
+// Commands are queued while the clients lock is held and run here afterwards,
+// so anything the engine prints while executing them can be broadcast safely.
+// Each is logged as it runs, with the client that sent it, so commands taken
+// over on a reload are logged too.
+void VConsoleServer::executePendingCommands() {
+    std::vector<PendingCommand> commands;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        if (m_pendingCommands.empty()) {
+            return;
+        }
+        commands.swap(m_pendingCommands);
+        metricSet(g_metrics.pendingCommands, uint64_t(0));
+    }
 
-        ::shutdown(it->socket, SHUT_RDWR);
-        closesocket(it->socket);
-        m_clients.erase(it);
+    extern void executeServerCommand(const std::string& cmd);
+    for (const auto& pending : commands) {
+        char logMsg[512];
+        snprintf(logMsg, sizeof(logMsg), "[VConsole] Command from %s: %s\n", pending.source.c_str(),
+                 pending.command.c_str());
+        logLocal(logMsg);
+        executeServerCommand(pending.command);
     }
 }
 
+void VConsoleServer::updateOutputInterest() {
+    bool wanted = m_running && (!m_clients.empty() || m_logSink.isOpen() || m_recorder.isOpen() ||
+                                m_shmRing.isOpen() || m_scrollbackLimit > 0);
+    m_wantsOutput.store(wanted, std::memory_order_relaxed);
+}
+
+bool VConsoleServer::openLogSink(const std::string& path, LogSinkFormat format, size_t rotateBytes, int keepFiles) {
+    bool opened = m_logSink.open(path, format, rotateBytes, keepFiles);
+    updateOutputInterest();
+    return opened;
+}
+
+void VConsoleServer::closeLogSink() {
+    m_logSink.close();
+    updateOutputInterest();
+}
+
+bool VConsoleServer::startRecording(const std::string& path) {
+    bool opened = m_recorder.open(path, LOG_SINK_BINARY);
+    updateOutputInterest();
+    return opened;
+}
+
+void VConsoleServer::stopRecording() {
+    m_recorder.close();
+    updateOutputInterest();
+}
+
+bool VConsoleServer::openShmRing(const std::string& name, size_t capacity) {
+    bool opened = m_shmRing.open(name, capacity);
+    updateOutputInterest();
+    return opened;
+}
+
+void VConsoleServer::closeShmRing() {
+    m_shmRing.close();
+    updateOutputInterest();
+}
+
 size_t VConsoleServer::getClientCount() const {
     return m_clients.size();
 }
@@ -315,112 +1126,612 @@ void VConsoleServer::logLocal(const char* msg) {
     SERVER_PRINT(msg);
 }
 
-void VConsoleServer::sendPacket(SOCKET socket, const char* type, const std::vector<uint8_t>& payload) {
-    std::vector<uint8_t> packet;
-    packet.reserve(sizeof(VConChunk) + payload.size());
+void VConsoleServer::printStats() {
+    std::vector<std::string> lines;
+    char line[256];
+
+    {
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+
+        snprintf(line, sizeof(line), "[VConsole] %zu client(s) connected on %zu listener(s), %llu commands throttled total\n",
+                 m_clients.size(), m_listeners.size(), static_cast<unsigned long long>(m_totalThrottled));
+        lines.push_back(line);
+        for (const Listener& listener : m_listeners) {
+            const ListenerOptions& o = listener.options;
+            char cap[16] = "-";
+            if (o.maxConnections > 0) {
+                snprintf(cap, sizeof(cap), "%d", o.maxConnections);
+            }
+            snprintf(line, sizeof(line), "[VConsole]   %-10s %s:%u%s clients=%zu/%s accepted=%llu rejected=%llu "
+                     "sent=%.1fKB frames=%llu dropped=%llu commands=%llu limit=%.1f/s%s\n",
+                     o.name.c_str(), o.bindAddr.c_str(), o.port, listener.socket == INVALID_SOCKET ? " (closed)" : "",
+                     listener.clients, cap,
+                     static_cast<unsigned long long>(listener.metrics->clientsAccepted.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(listener.metrics->clientsRejected.load(std::memory_order_relaxed)),
+                     listener.metrics->bytesSent.load(std::memory_order_relaxed) / 1024.0,
+                     static_cast<unsigned long long>(listener.metrics->framesSent.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(listener.metrics->framesDropped.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(listener.metrics->commandsQueued.load(std::memory_order_relaxed)),
+                     o.cmdRate, o.readOnly ? " read-only" : "");
+            lines.push_back(line);
+        }
+
+        snprintf(line, sizeof(line), "[VConsole] Pipeline heap allocations: %llu (encode buffer %zu bytes)\n",
+                 static_cast<unsigned long long>(g_metrics.pipelineHeapAllocs.load(std::memory_order_relaxed)),
+                 m_encodeScratch.capacity());
+        lines.push_back(line);
+
+        snprintf(line, sizeof(line), "[VConsole] I/O backend %s, %llu syscalls\n", getIoBackendName(),
+                 static_cast<unsigned long long>(g_metrics.ioSyscalls.load(std::memory_order_relaxed)));
+        lines.push_back(line);
+
+        snprintf(line, sizeof(line), "[VConsole] Timeouts idle=%llums keepalive=%llums send=%llums: %zu timer(s) armed, "
+                 "%llu client(s) timed out\n",
+                 static_cast<unsigned long long>(m_idleTimeoutNs / 1000000),
+                 static_cast<unsigned long long>(m_keepaliveNs / 1000000),
+                 static_cast<unsigned long long>(m_sendTimeoutNs / 1000000), m_timers.size(),
+                 static_cast<unsigned long long>(g_metrics.clientsTimedOut.load(std::memory_order_relaxed)));
+        lines.push_back(line);
+
+        uint64_t collapsed = 0;
+        for (const auto& count : g_metrics.linesCollapsed) {
+            collapsed += count.load(std::memory_order_relaxed);
+        }
+        uint64_t suppressed = 0;
+        for (const auto& count : g_metrics.linesSuppressed) {
+            suppressed += count.load(std::memory_order_relaxed);
+        }
+        if (m_captureLimiter.enabled()) {
+            snprintf(line, sizeof(line), "[VConsole] Capture budget %.0f lines/s, burst %.0f per emitter: %zu emitter(s), "
+                     "%llu line(s) suppressed\n", m_captureLimiter.rate(), m_captureLimiter.burst(),
+                     m_captureLimiter.emitters(), static_cast<unsigned long long>(suppressed));
+        } else {
+            snprintf(line, sizeof(line), "[VConsole] Capture budget off: %llu line(s) suppressed\n",
+                     static_cast<unsigned long long>(suppressed));
+        }
+        lines.push_back(line);
+
+        snprintf(line, sizeof(line), "[VConsole] Repeats window=%ums: %llu line(s) collapsed\n", getRepeatWindowMs(),
+                 static_cast<unsigned long long>(collapsed));
+        lines.push_back(line);
 
-    VConChunk header;
-    memcpy(header.type, type, 4);
-    header.version = htonl(0x000000D4);
-    header.length = htons(static_cast<uint16_t>(sizeof(VConChunk) + payload.size()));
-    header.handle = htons(0);
+        if (m_scheduler.getBudgetMicros() > 0) {
+            snprintf(line, sizeof(line), "[VConsole] Tick budget %uus: %llu frames, %llu over budget (worst +%.1fus)\n",
+                     m_scheduler.getBudgetMicros(), static_cast<unsigned long long>(m_scheduler.getFrames()),
+                     static_cast<unsigned long long>(m_scheduler.getOverruns()),
+                     m_scheduler.getMaxOverrunNanos() / 1000.0);
+        } else {
+            snprintf(line, sizeof(line), "[VConsole] Tick budget unlimited: %llu frames\n",
+                     static_cast<unsigned long long>(m_scheduler.getFrames()));
+        }
+        lines.push_back(line);
+        for (const auto& unit : m_scheduler.getUnits()) {
+            snprintf(line, sizeof(line), "[VConsole]   %-10s runs=%llu rolled over=%llu avg=%.1fus max=%.1fus\n",
+                     unit.name, static_cast<unsigned long long>(unit.runs),
+                     static_cast<unsigned long long>(unit.rollovers),
+                     unit.runs ? unit.totalNanos / 1000.0 / unit.runs : 0.0, unit.maxNanos / 1000.0);
+            lines.push_back(line);
+        }
 
-    packet.insert(packet.end(), reinterpret_cast<uint8_t*>(&header),
-                  reinterpret_cast<uint8_t*>(&header) + sizeof(VConChunk));
-    packet.insert(packet.end(), payload.begin(), payload.end());
+        if (m_statusProvider) {
+            snprintf(line, sizeof(line), "[VConsole] Status snapshots every %llums: %llu subscriber(s), seq %u, %llu frames sent\n",
+                     static_cast<unsigned long long>(m_statusIntervalNs / 1000000),
+                     static_cast<unsigned long long>(g_metrics.statusSubscribers.load(std::memory_order_relaxed)),
+                     m_statusSeq, static_cast<unsigned long long>(g_metrics.statusFrames.load(std::memory_order_relaxed)));
+            lines.push_back(line);
+        }
 
-    send(socket, reinterpret_cast<const char*>(packet.data()), static_cast<int>(packet.size()), 0);
+        if (const TelemetrySummary* t = m_telemetry.last(TELEMETRY_10S)) {
+            snprintf(line, sizeof(line), "[VConsole] Last 10s: %.1f ticks/s, interval avg=%.2fms p99=%.2fms max=%.2fms, "
+                     "jitter p99=%.2fms, tick p99=%.1fus, %llu TELE frames sent\n",
+                     t->tickRateCentiHz / 100.0, t->interval.avg / 1e6, t->interval.p99 / 1e6, t->interval.max / 1e6,
+                     t->jitter.p99 / 1e6, t->cost.p99 / 1e3,
+                     static_cast<unsigned long long>(g_metrics.telemetryFrames.load(std::memory_order_relaxed)));
+            lines.push_back(line);
+        }
+
+        if (m_consoleIndex.size() > 0) {
+            snprintf(line, sizeof(line), "[VConsole] Console index: %zu cvars, %zu commands, %llu completions, %llu cvar queries\n",
+                     m_consoleIndex.count(CONSOLE_CVAR), m_consoleIndex.count(CONSOLE_COMMAND),
+                     static_cast<unsigned long long>(g_metrics.completionRequests.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(g_metrics.cvarQueries.load(std::memory_order_relaxed)));
+            lines.push_back(line);
+        }
+
+        if (m_logSink.isOpen()) {
+            snprintf(line, sizeof(line), "[VConsole] Log sink %s: %llu records, %llu dropped\n",
+                     m_logSink.getPath().c_str(),
+                     static_cast<unsigned long long>(m_logSink.getRecords()),
+                     static_cast<unsigned long long>(m_logSink.getDropped()));
+            lines.push_back(line);
+        }
+
+        if (m_recorder.isOpen()) {
+            snprintf(line, sizeof(line), "[VConsole] Recording to %s: %llu lines, %llu dropped\n",
+                     m_recorder.getPath().c_str(),
+                     static_cast<unsigned long long>(m_recorder.getRecords()),
+                     static_cast<unsigned long long>(m_recorder.getDropped()));
+            lines.push_back(line);
+        }
+
+        if (m_shmRing.isOpen()) {
+            snprintf(line, sizeof(line), "[VConsole] Shared memory ring %s (%zu KB): %llu lines, %llu wakeups\n",
+                     m_shmRing.getName().c_str(), m_shmRing.getCapacity() / 1024,
+                     static_cast<unsigned long long>(m_shmRing.getRecords()),
+                     static_cast<unsigned long long>(m_shmRing.getWakeups()));
+            lines.push_back(line);
+        }
+
+        auto now = TokenBucket::Clock::now();
+        for (auto& client : m_clients) {
+            if (client.cmdBucket.enabled()) {
+                client.cmdBucket.refill(now);
+            }
+            snprintf(line, sizeof(line), "[VConsole]   %s:%u (%s)  commands=%llu throttled=%llu tokens=%.1f backlog=%zu dropped=%llu%s\n",
+                     client.ip.c_str(), client.port, m_listeners[client.listener].options.name.c_str(),
+                     static_cast<unsigned long long>(client.commandsQueued),
+                     static_cast<unsigned long long>(client.commandsThrottled),
+                     client.cmdBucket.enabled() ? client.cmdBucket.tokens : 0.0,
+                     client.pendingBytes(),
+                     static_cast<unsigned long long>(client.framesDropped),
+                     client.throttled ? " (throttled)" : "");
+            lines.push_back(line);
+        }
+    }
+
+    for (const auto& l : lines) {
+        SERVER_PRINT(l.c_str());
+    }
 }
 
-void VConsoleServer::sendAINF(SOCKET socket) {
-    std::vector<uint8_t> payload(77, 0);
-    sendPacket(socket, "AINF", payload);
+bool VConsoleServer::queueFrames(ClientInfo& client, const uint8_t* data, size_t len, size_t frameCount, uint64_t ingestNs) {
+    if (client.closing) {
+        return false;
+    }
+
+    const Listener& listener = m_listeners[client.listener];
+    if (client.pendingBytes() + len > listener.options.maxBacklog) {
+        flushClient(client);
+        if (client.pendingBytes() + len > listener.options.maxBacklog) {
+            client.framesDropped += frameCount;
+            metricAdd(g_metrics.framesDropped, static_cast<uint64_t>(frameCount));
+            metricAdd(listener.metrics->framesDropped, static_cast<uint64_t>(frameCount));
+            return false;
+        }
+    }
+
+    if (client.outOffset == client.outBuf.size()) {
+        client.outBuf.clear();
+        client.outOffset = 0;
+        // A send stall is timed from when output starts waiting
+        client.lastProgressNs = m_frameNs;
+    }
+    appendTracked(client.outBuf, [&] { client.outBuf.insert(client.outBuf.end(), data, data + len); });
+    if (ingestNs != 0) {
+        appendTracked(client.outMarks, [&] {
+            client.outMarks.push_back({client.outBuf.size(), ingestNs, monotonicNanos()});
+        });
+    }
+    metricAdd(g_metrics.framesSent, static_cast<uint64_t>(frameCount));
+    metricAdd(listener.metrics->framesSent, static_cast<uint64_t>(frameCount));
+    client.lastQueuedNs = m_frameNs;
+    flushClient(client);
+    if (m_sendTimeoutNs > 0 && client.stallTimer == 0 && client.pendingBytes() > 0) {
+        client.stallTimer = m_timers.schedule(client.lastProgressNs + m_sendTimeoutNs, TIMER_SEND_STALL,
+                                              m_clients.idOf(client));
+    }
+    return true;
 }
 
-void VConsoleServer::sendADON(SOCKET socket, const std::string& name) {
-    std::vector<uint8_t> payload;
-    uint16_t unknown = htons(0);
-    uint16_t nameLen = htons(static_cast<uint16_t>(name.length()));
+// Records socket-buffer and end-to-end latency for every traced line whose
+// last byte has now left send()
+void VConsoleServer::completeMarks(ClientInfo& client) {
+    if (client.outMarkHead == client.outMarks.size()) {
+        return;
+    }
 
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&unknown),
-                   reinterpret_cast<uint8_t*>(&unknown) + 2);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&nameLen),
-                   reinterpret_cast<uint8_t*>(&nameLen) + 2);
-    payload.insert(payload.end(), name.begin(), name.end());
+    uint64_t now = monotonicNanos();
+    while (client.outMarkHead < client.outMarks.size() &&
+           client.outMarks[client.outMarkHead].end <= client.outOffset) {
+        const OutputMark& mark = client.outMarks[client.outMarkHead++];
+        g_metrics.latency.socketBuffer.record(now - mark.queuedNs);
+        g_metrics.latency.endToEnd.record(now - mark.ingestNs);
+    }
 
-    sendPacket(socket, "ADON", payload);
+    if (client.outMarkHead == client.outMarks.size()) {
+        client.outMarks.clear();
+        client.outMarkHead = 0;
+    }
 }
 
-void VConsoleServer::sendCHAN(SOCKET socket) {
-    std::vector<uint8_t> payload;
+// Writes as much queued output as the socket accepts. Returns false once the
+// connection is unusable; the client is then reaped by reapClients().
+bool VConsoleServer::flushClient(ClientInfo& client) {
+    while (client.outOffset < client.outBuf.size()) {
+        size_t remaining = client.outBuf.size() - client.outOffset;
+        int sent = m_io->send(client.socket, client.outBuf.data() + client.outOffset, remaining);
+        if (sent > 0) {
+            client.outOffset += sent;
+            client.lastProgressNs = m_frameNs;
+            metricAdd(g_metrics.bytesSent, static_cast<uint64_t>(sent));
+            metricAdd(m_listeners[client.listener].metrics->bytesSent, static_cast<uint64_t>(sent));
+            completeMarks(client);
+            continue;
+        }
+        if (sent == 0) {
+            return true;
+        }
+        client.closing = true;
+        client.outMarks.clear();
+        client.outMarkHead = 0;
+        return false;
+    }
 
-    uint16_t numChannels = htons(1);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&numChannels),
-                   reinterpret_cast<uint8_t*>(&numChannels) + 2);
+    client.outBuf.clear();
+    client.outOffset = 0;
+    return true;
+}
 
-    int32_t id = htonl(0);
-    int32_t unknown1 = htonl(0);
-    int32_t unknown2 = htonl(0);
-    int32_t verbosity_default = htonl(1);
-    int32_t verbosity_current = htonl(1);
-    uint32_t color = htonl(0xFFFFFFFF);
-    char name[34] = "Console";
+void VConsoleServer::printLatency() {
+    char line[256];
+    snprintf(line, sizeof(line), "[VConsole] Output latency (trailer debug %s):\n", m_latencyDebug ? "on" : "off");
+    SERVER_PRINT(line);
+
+    const struct { const char* name; const LatencyHistogram& hist; } stages[] = {
+        { "queue wait", g_metrics.latency.queueWait },
+        { "encode", g_metrics.latency.encode },
+        { "socket buffer", g_metrics.latency.socketBuffer },
+        { "end to end", g_metrics.latency.endToEnd },
+    };
+    for (const auto& stage : stages) {
+        memcpy(line, "[VConsole]   ", 13);
+        stage.hist.format(line + 13, sizeof(line) - 13, stage.name);
+        SERVER_PRINT(line);
+    }
+}
 
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&id),
-                   reinterpret_cast<uint8_t*>(&id) + 4);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&unknown1),
-                   reinterpret_cast<uint8_t*>(&unknown1) + 4);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&unknown2),
-                   reinterpret_cast<uint8_t*>(&unknown2) + 4);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&verbosity_default),
-                   reinterpret_cast<uint8_t*>(&verbosity_default) + 4);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&verbosity_current),
-                   reinterpret_cast<uint8_t*>(&verbosity_current) + 4);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&color),
-                   reinterpret_cast<uint8_t*>(&color) + 4);
-    payload.insert(payload.end(), name, name + 34);
+void VConsoleServer::sendPrint(ClientInfo& client, std::string_view message, int32_t channelId, uint32_t color,
+                               ColorRuns runs) {
+    size_t frames = 0;
+    uint8_t* buf = m_encodeScratch.get(prntRunsBound(message.size(), runs.size(), false));
+    size_t len = encodePRNTRuns(buf, message, channelId, color, runs, 0, &frames);
+    queueFrames(client, buf, len, frames);
+}
 
-    sendPacket(socket, "CHAN", payload);
+void VConsoleServer::sendAINF(ClientInfo& client) {
+    queueFrames(client, VCON_AINF_FRAME.data(), VCON_AINF_FRAME.size(), 1);
 }
 
-std::vector<uint8_t> VConsoleServer::createPRNTPacket(const std::string& message, int32_t channelId, uint32_t color) {
-    std::vector<uint8_t> payload;
+void VConsoleServer::sendADON(ClientInfo& client, std::string_view name) {
+    uint8_t* frame = m_encodeScratch.get(adonFrameSize(name.size()));
+    size_t len = encodeADONFrame(frame, name);
+    if (len > 0) {
+        queueFrames(client, frame, len, 1);
+    }
+}
 
-    // offset 0: channelId (4 bytes)
-    int32_t chanId = htonl(channelId);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&chanId),
-                   reinterpret_cast<uint8_t*>(&chanId) + 4);
+void VConsoleServer::sendCHAN(ClientInfo& client) {
+    queueFrames(client, VCON_CHAN_FRAME.data(), VCON_CHAN_FRAME.size(), 1);
+}
 
-    // offset 4: unknown1 (8 bytes)
-    uint8_t unknown1[8] = {0};
-    payload.insert(payload.end(), unknown1, unknown1 + 8);
+void VConsoleServer::setScrollback(size_t lines) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    m_scrollback.clear();
+    m_scrollback.shrink_to_fit();
+    m_scrollbackLimit = lines;
+    m_scrollbackHead = 0;
+    for (auto& client : m_clients) {
+        client.scrollbackNext = m_scrollbackTotal;
+    }
+    updateOutputInterest();
+}
 
-    // offset 12: color (4 bytes) - client reads color from here
-    uint32_t col = htonl(color);
-    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&col),
-                   reinterpret_cast<uint8_t*>(&col) + 4);
+// Sends each catching-up client the scrollback it still needs, oldest first,
+// 64 lines at a time between budget checks. A client whose backlog is large
+// waits for it to drain; one that falls further behind than the ring holds
+// skips ahead and has the lost lines counted as dropped frames.
+bool VConsoleServer::replayScrollback(uint64_t deadlineNs) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
 
-    // offset 16: unknown2 (12 bytes) - padding to reach offset 28
-    uint8_t unknown2[12] = {0};
-    payload.insert(payload.end(), unknown2, unknown2 + 12);
+    const size_t linesPerCheck = 64;
+    size_t count = m_scrollback.size();
+    uint64_t oldest = m_scrollbackTotal - count;
+    bool finished = true;
 
-    // offset 28: message (null-terminated)
-    payload.insert(payload.end(), message.begin(), message.end());
-    payload.push_back(0);
+    for (auto& client : m_clients) {
+        if (client.closing || client.scrollbackNext >= m_scrollbackTotal) {
+            continue;
+        }
+        if (client.scrollbackNext < oldest) {
+            client.framesDropped += oldest - client.scrollbackNext;
+            metricAdd(g_metrics.framesDropped, oldest - client.scrollbackNext);
+            client.scrollbackNext = oldest;
+        }
 
-    return payload;
+        const ListenerOptions& options = m_listeners[client.listener].options;
+        size_t backlog = std::min(VCON_SCROLLBACK_BACKLOG, options.maxBacklog);
+        size_t sent = 0;
+        while (client.scrollbackNext < m_scrollbackTotal && client.pendingBytes() < backlog) {
+            if (sent > 0 && sent % linesPerCheck == 0 && monotonicNanos() >= deadlineNs) {
+                return false;
+            }
+            // The oldest entry sits at the head once the ring has wrapped, at 0 before
+            const ScrollbackLine& line = m_scrollback[(m_scrollbackHead + (client.scrollbackNext - oldest)) % count];
+            if (channelAllowed(options.channels, line.channelId)) {
+                sendPrint(client, line.text, line.channelId, line.color, line.runs);
+            }
+            client.scrollbackNext++;
+            sent++;
+        }
+        if (client.scrollbackNext < m_scrollbackTotal) {
+            finished = false;
+        }
+    }
+    return finished;
 }
 
-void VConsoleServer::broadcastPrint(const std::string& message, int32_t channelId, uint32_t color) {
-    if (!m_running || message.empty()) {
+void VConsoleServer::setStatusSource(StatusProvider provider, uint32_t intervalMs) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    m_statusProvider = provider;
+    m_statusIntervalNs = static_cast<uint64_t>(intervalMs) * 1000000;
+    m_nextStatusNs = 0;
+    m_statusValid = false;
+    for (auto& client : m_clients) {
+        client.statusSynced = false;
+    }
+}
+
+// Collects a snapshot once per interval while anyone is subscribed, or right
+// away for a client that has just subscribed. Synced subscribers get the
+// delta from the last snapshot (if anything changed), new ones the whole
+// snapshot at the same seq, so both continue from the same state.
+void VConsoleServer::publishStatus() {
+    if (!m_statusProvider) {
+        return;
+    }
+
+    uint64_t subscribers = 0;
+    bool newSubscriber = false;
+    {
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (const auto& client : m_clients) {
+            if ((client.topics & VCON_TOPIC_STATUS) && !client.closing) {
+                subscribers++;
+                newSubscriber = newSubscriber || !client.statusSynced;
+            }
+        }
+    }
+    metricSet(g_metrics.statusSubscribers, subscribers);
+
+    uint64_t now = monotonicNanos();
+    if (subscribers == 0 || (!newSubscriber && now < m_nextStatusNs)) {
         return;
     }
 
-    std::vector<uint8_t> payload = createPRNTPacket(message, channelId, color);
+    // Engine calls happen outside the clients lock
+    m_statusProvider(m_statusScratch);
+    m_nextStatusNs = now + m_statusIntervalNs;
+
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    if (m_statusValid && encodeStatusDelta(m_statusFrame, m_status, m_statusScratch, m_statusSeq + 1)) {
+        m_statusSeq++;
+        for (auto& client : m_clients) {
+            if ((client.topics & VCON_TOPIC_STATUS) && client.statusSynced) {
+                queueFrames(client, m_statusFrame.data(), m_statusFrame.size(), 1);
+                metricAdd(g_metrics.statusFrames);
+            }
+        }
+    }
+    std::swap(m_status, m_statusScratch);
+    m_statusValid = true;
+
+    if (newSubscriber && encodeStatusFull(m_statusFrame, m_status, m_statusSeq)) {
+        for (auto& client : m_clients) {
+            if ((client.topics & VCON_TOPIC_STATUS) && !client.statusSynced) {
+                queueFrames(client, m_statusFrame.data(), m_statusFrame.size(), 1);
+                metricAdd(g_metrics.statusFrames);
+                client.statusSynced = true;
+            }
+        }
+    }
+}
+
+// Windows closed by the last frames go out once each; the queue is drained
+// even without subscribers so nobody gets stale windows on subscribing
+void VConsoleServer::publishTelemetry() {
+    TelemetrySummary summary;
+    while (m_telemetry.takeReady(summary)) {
+        if (m_playerCounter) {
+            m_playerCounter(summary.players, summary.maxPlayers);
+        }
+        encodeTELEFrame(m_telemetryFrame, summary);
+
+        std::lock_guard<std::mutex> lock(m_clientsMutex);
+        for (auto& client : m_clients) {
+            if ((client.topics & VCON_TOPIC_TELEMETRY) && !client.closing) {
+                queueFrames(client, m_telemetryFrame, sizeof(m_telemetryFrame), 1);
+                metricAdd(g_metrics.telemetryFrames);
+            }
+        }
+    }
+}
+
+void VConsoleServer::captureLine(CaptureSource source, std::string_view line, int32_t channelId, uint32_t color,
+                                 uint64_t ingestNs, ColorRuns runs, const char* emitter) {
+    metricAdd(g_metrics.linesCaptured[source]);
+
+    if (m_logSink.isOpen() || m_recorder.isOpen() || m_shmRing.isOpen()) {
+        uint64_t unixNs = LogSink::unixNanos();
+        if (m_logSink.isOpen()) {
+            m_logSink.write(source, channelId, color, unixNs, line);
+        }
+        if (m_recorder.isOpen()) {
+            m_recorder.write(source, channelId, color, unixNs, line);
+        }
+        if (m_shmRing.isOpen()) {
+            m_shmRing.write(source, channelId, color, unixNs, line);
+        }
+    }
+
+    // Only what reaches clients is collapsed and budgeted; the outputs above
+    // keep every line
+    RepeatSummary summary;
+    uint64_t nowNs = ingestNs ? ingestNs : monotonicNanos();
+    bool send = m_repeats[source].admit(line, channelId, color, nowNs, summary, runs);
+    if (summary.count > 0) {
+        sendRepeatSummary(summary, nowNs);
+    }
+    if (!send) {
+        metricAdd(g_metrics.linesCollapsed[source]);
+        return;
+    }
+    if (!admitCapture(source, emitter, channelId, nowNs)) {
+        return;
+    }
+
+    broadcastPrint(line, channelId, color, ingestNs, runs);
+}
+
+bool VConsoleServer::admitCapture(CaptureSource source, const char* emitter, int32_t channelId, uint64_t nowNs) {
+    if (m_captureLimiter.admit(source, emitter, emitter, channelId, nowNs)) {
+        return true;
+    }
+    metricAdd(g_metrics.linesSuppressed[source]);
+    return false;
+}
+
+// One line per emitter that went over budget, in its own channel, naming
+// the AlertMessage format string where there is one. It goes to clients
+// only, since the outputs that keep every line lost nothing.
+void VConsoleServer::reportSuppressed(uint64_t nowNs, uint64_t intervalNs) {
+    m_captureLimiter.collect(nowNs, intervalNs, [&](const CaptureEmitter& emitter, uint64_t spanNs) {
+        char what[96];
+        if (emitter.label[0]) {
+            size_t len = strcspn(emitter.label, "\r\n");
+            snprintf(what, sizeof(what), "%s \"%.*s\"", captureSourceName(emitter.source), static_cast<int>(len),
+                     emitter.label);
+        } else {
+            snprintf(what, sizeof(what), "%s", captureSourceName(emitter.source));
+        }
+
+        char sampled[40] = "";
+        if (emitter.sampled > 0) {
+            snprintf(sampled, sizeof(sampled), ", %llu sampled", static_cast<unsigned long long>(emitter.sampled));
+        }
+
+        char line[256];
+        snprintf(line, sizeof(line), "[VConsole] Suppressed %llu line(s) from %s over %.1fs%s\n",
+                 static_cast<unsigned long long>(emitter.suppressed), what, spanNs / 1e9, sampled);
+        broadcastPrint(line, emitter.channelId, 0xFFFFFF00, nowNs);
+    });
+}
+
+void VConsoleServer::flushRepeats(uint64_t nowNs, bool force) {
+    RepeatSummary summary;
+    for (RepeatCollapser& repeats : m_repeats) {
+        if (repeats.flush(nowNs, summary, force)) {
+            sendRepeatSummary(summary, nowNs);
+        }
+    }
+}
+
+// The repeated line once more, without its newline, followed by the count
+// in the color the line ends in
+void VConsoleServer::sendRepeatSummary(const RepeatSummary& summary, uint64_t nowNs) {
+    std::string_view line = summary.line;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+    size_t runs = summary.runs.size();
+    while (runs > 0 && summary.runs.data[runs - 1].offset >= line.size()) {
+        runs--;
+    }
+
+    char suffix[48];
+    int len = snprintf(suffix, sizeof(suffix), " (repeated %llu time%s)\n",
+                       static_cast<unsigned long long>(summary.count), summary.count == 1 ? "" : "s");
+    m_repeatText.clear();
+    appendTracked(m_repeatText, [&] {
+        m_repeatText.append(line);
+        m_repeatText.append(suffix, len);
+    });
+    broadcastPrint(m_repeatText, summary.channelId, summary.color, nowNs, ColorRuns(summary.runs.data, runs));
+}
+
+std::string_view VConsoleServer::formatCapture(const char* fmt, va_list args) {
+    va_list probe;
+    va_copy(probe, args);
+    int len = vsnprintf(m_captureSlot, sizeof(m_captureSlot), fmt, probe);
+    va_end(probe);
+
+    if (len < 0) {
+        return {};
+    }
+    if (static_cast<size_t>(len) < sizeof(m_captureSlot)) {
+        return std::string_view(m_captureSlot, len);
+    }
+
+    // Second pass only for messages that overflow the slot; the spill
+    // buffer keeps its capacity so repeated long lines stop allocating
+    if (m_captureSpill.size() < static_cast<size_t>(len) + 1) {
+        m_captureSpill.resize(len + 1);
+    }
+    vsnprintf(m_captureSpill.data(), len + 1, fmt, args);
+    return std::string_view(m_captureSpill.data(), len);
+}
+
+void VConsoleServer::broadcastPrint(std::string_view message, int32_t channelId, uint32_t color, uint64_t ingestNs,
+                                    ColorRuns runs) {
+    if (!m_running || message.empty()) {
+        return;
+    }
 
     std::lock_guard<std::mutex> lock(m_clientsMutex);
+    uint64_t lineIndex = m_scrollbackTotal;
+    if (m_scrollbackLimit > 0) {
+        if (m_scrollback.size() < m_scrollbackLimit) {
+            m_scrollback.push_back({std::string(message), channelId, color,
+                                    std::vector<ColorRun>(runs.begin(), runs.end())});
+        } else {
+            ScrollbackLine& slot = m_scrollback[m_scrollbackHead];
+            slot.text.assign(message.data(), message.size());
+            slot.channelId = channelId;
+            slot.color = color;
+            slot.runs.assign(runs.begin(), runs.end());
+            m_scrollbackHead = (m_scrollbackHead + 1) % m_scrollbackLimit;
+        }
+        m_scrollbackTotal++;
+    }
+
+    if (m_clients.empty()) {
+        return;
+    }
+
+    uint64_t encodeStart = monotonicNanos();
+    if (ingestNs == 0 || ingestNs > encodeStart) {
+        ingestNs = encodeStart;
+    }
+    g_metrics.latency.queueWait.record(encodeStart - ingestNs);
+
+    // Encoded once into the shared encode buffer, then copied into each client's
+    // reusable output buffer
+    uint64_t traceNs = m_latencyDebug ? ingestNs : 0;
+    size_t frames = 0;
+    uint8_t* buf = m_encodeScratch.get(prntRunsBound(message.size(), runs.size(), traceNs != 0));
+    size_t len = encodePRNTRuns(buf, message, channelId, color, runs, traceNs, &frames);
+    g_metrics.latency.encode.record(monotonicNanos() - encodeStart);
+
     for (auto& client : m_clients) {
-        sendPacket(client.socket, "PRNT", payload);
+        // Clients still being replayed to pick this line up from the ring
+        if (m_scrollbackLimit > 0) {
+            if (client.scrollbackNext != lineIndex) {
+                continue;
+            }
+            client.scrollbackNext = lineIndex + 1;
+        }
+        if (channelAllowed(m_listeners[client.listener].options.channels, channelId)) {
+            queueFrames(client, buf, len, frames, ingestNs);
+        }
     }
 }
 
@@ -454,6 +1765,8 @@ void VConsoleServer::setupOutputCapture() {
     flags = fcntl(m_stderrPipe[0], F_GETFL, 0);
     fcntl(m_stderrPipe[0], F_SETFL, flags | O_NONBLOCK);
 
+    m_stdoutAnsi.reset();
+    m_stderrAnsi.reset();
     m_captureActive = true;
 }
 
@@ -494,48 +1807,123 @@ void VConsoleServer::readCapturedOutput() {
         return;
     }
 
+    drainPipe(m_stdoutPipe[0], m_origStdout, CAPTURE_STDOUT, m_stdoutAnsi, true);
+    drainPipe(m_stderrPipe[0], m_origStderr, CAPTURE_STDERR, m_stderrAnsi, false);
+}
+
+// Lines are cut straight out of the read buffer. Only a line split across
+// reads is copied, into m_partialLine, which keeps its capacity. Without
+// keepPartial (stderr) a trailing fragment is sent as-is, since stderr
+// output is often written unbuffered in pieces.
+//
+// Escape sequences are stripped in the same buffer before splitting, and
+// the color changes they make are kept as runs of the line they fall in,
+// so a line in several colors is still captured once.
+void VConsoleServer::drainPipe(int fd, int passthroughFd, CaptureSource source, AnsiParser& ansi, bool keepPartial) {
     char buffer[4096];
 
-    ssize_t bytesRead = read(m_stdoutPipe[0], buffer, sizeof(buffer) - 1);
-    while (bytesRead > 0) {
-        buffer[bytesRead] = '\0';
+    ssize_t bytesRead;
+    while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0) {
+        uint64_t readNs = monotonicNanos();
 
-        if (m_origStdout != -1) {
-            write(m_origStdout, buffer, bytesRead);
+        if (passthroughFd != -1) {
+            write(passthroughFd, buffer, bytesRead);
         }
 
-        m_partialLine += buffer;
-
-        size_t pos;
-        while ((pos = m_partialLine.find('\n')) != std::string::npos) {
-            std::string line = m_partialLine.substr(0, pos + 1);
-            m_partialLine.erase(0, pos + 1);
-            broadcastPrint(line);
+        size_t length = static_cast<size_t>(bytesRead);
+        if (!wantsOutput()) {
+            // Colors set while nobody listens still apply to later output
+            if (m_ansiColors) {
+                ansi.strip(buffer, length, [](size_t, uint32_t) {});
+            }
+            if (keepPartial) {
+                m_partialLine.clear();
+                m_partialRuns.clear();
+            }
+            continue;
         }
 
-        bytesRead = read(m_stdoutPipe[0], buffer, sizeof(buffer) - 1);
+        uint32_t color = ansi.color();
+        m_readRuns.clear();
+        if (m_ansiColors) {
+            length = ansi.strip(buffer, length, [&](size_t offset, uint32_t changed) {
+                m_readRuns.push_back({static_cast<uint32_t>(offset), changed});
+            });
+        }
+        captureRead(source, std::string_view(buffer, length), color, readNs, keepPartial);
     }
+}
 
-    bytesRead = read(m_stderrPipe[0], buffer, sizeof(buffer) - 1);
-    while (bytesRead > 0) {
-        buffer[bytesRead] = '\0';
+// Adds a color change to a line's runs. Changes at the same offset leave
+// only the last, and one to the color already in effect is dropped.
+static void addColorRun(std::vector<ColorRun>& runs, uint32_t startColor, ColorRun run) {
+    if (!runs.empty() && runs.back().offset == run.offset) {
+        runs.pop_back();
+    }
+    if (run.color != (runs.empty() ? startColor : runs.back().color)) {
+        runs.push_back(run);
+    }
+}
 
-        if (m_origStderr != -1) {
-            write(m_origStderr, buffer, bytesRead);
+// Splits one stripped read into lines. color is the color the read starts
+// in and m_readRuns its changes; each line gets the color it starts in and
+// the changes inside it, relative to its start. An unterminated last line
+// waits in m_partialLine for the rest.
+void VConsoleServer::captureRead(CaptureSource source, std::string_view text, uint32_t color, uint64_t readNs,
+                                 bool keepPartial) {
+    size_t next = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const char* nl = static_cast<const char*>(memchr(text.data() + pos, '\n', text.size() - pos));
+        size_t end = nl ? nl + 1 - text.data() : text.size();
+
+        // A change right at the line start is the color it starts in
+        while (next < m_readRuns.size() && m_readRuns[next].offset <= pos) {
+            color = m_readRuns[next++].color;
         }
-
-        std::string errMsg(buffer, bytesRead);
-        size_t pos;
-        while ((pos = errMsg.find('\n')) != std::string::npos) {
-            std::string line = errMsg.substr(0, pos + 1);
-            errMsg.erase(0, pos + 1);
-            broadcastPrint(line, 0, 0xFFFF0000);
+        uint32_t lineColor = color;
+        m_lineRuns.clear();
+        while (next < m_readRuns.size() && m_readRuns[next].offset < end) {
+            ColorRun run = m_readRuns[next++];
+            color = run.color;
+            addColorRun(m_lineRuns, lineColor, {static_cast<uint32_t>(run.offset - pos), run.color});
         }
-        if (!errMsg.empty()) {
-            broadcastPrint(errMsg, 0, 0xFFFF0000);
+
+        std::string_view line = text.substr(pos, end - pos);
+        if (keepPartial && (!nl || !m_partialLine.empty())) {
+            // A line that started in an earlier read keeps that read's timestamp
+            appendPartialLine(line, lineColor, m_lineRuns, readNs);
+
+            // Never hold more than one frame's worth of unterminated output
+            if (nl || m_partialLine.size() >= VCON_MAX_PRNT_TEXT) {
+                flushPartialLine(source);
+            }
+        } else {
+            captureLine(source, line, 0, lineColor, readNs, m_lineRuns);
         }
+        pos = end;
+    }
+}
+
+void VConsoleServer::appendPartialLine(std::string_view text, uint32_t color, ColorRuns runs, uint64_t readNs) {
+    uint32_t base = static_cast<uint32_t>(m_partialLine.size());
+    if (base == 0) {
+        m_partialLineNs = readNs;
+        m_partialColor = color;
+    } else {
+        addColorRun(m_partialRuns, m_partialColor, {base, color});
+    }
+    for (const ColorRun& run : runs) {
+        addColorRun(m_partialRuns, m_partialColor, {base + run.offset, run.color});
+    }
+    appendTracked(m_partialLine, [&] { m_partialLine.append(text); });
+}
 
-        bytesRead = read(m_stderrPipe[0], buffer, sizeof(buffer) - 1);
+void VConsoleServer::flushPartialLine(CaptureSource source) {
+    if (!m_partialLine.empty()) {
+        captureLine(source, m_partialLine, 0, m_partialColor, m_partialLineNs, m_partialRuns);
+        m_partialLine.clear();
+        m_partialRuns.clear();
     }
 }
 #endif
@@ -4,63 +4,263 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <cstdint>
+#include <cstdarg>
+#include <string_view>
+#include <memory>
+#include "token_bucket.hpp"
+#include "vconsole_protocol.hpp"
+#include "metrics.hpp"
+#include "log_sink.hpp"
+#include "shm_ring.hpp"
+#include "encode_scratch.hpp"
+#include "io_backend.hpp"
+#include "tick_scheduler.hpp"
+#include "server_status.hpp"
+#include "telemetry.hpp"
+#include "console_index.hpp"
+#include "timer_wheel.hpp"
+#include "client_table.hpp"
+#include "ansi.hpp"
+#include "line_repeats.hpp"
+#include "capture_limiter.hpp"
 
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
-#define SOCKET_ERROR_CODE WSAGetLastError()
-#define SHUT_RDWR SD_BOTH
-#else
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
-#include <arpa/inet.h>
-#include <fcntl.h>
-#include <errno.h>
-#include <cstdio>
-#define SOCKET int
-#define INVALID_SOCKET -1
-#define SOCKET_ERROR -1
-#define closesocket close
-#define SOCKET_ERROR_CODE errno
-#endif
-
-#pragma pack(push, 1)
-struct VConChunk {
-    char type[4];
-    uint32_t version;
-    uint16_t length;
-    uint16_t handle;
+// Marks where a traced line's frames end in a client's output buffer
+struct OutputMark {
+    size_t end;
+    uint64_t ingestNs;
+    uint64_t queuedNs;
 };
-#pragma pack(pop)
 
+// One connection. Entries are stored back to back in a ClientTable, and
+// the fields fanning out a line reads come first, so a broadcast mostly
+// stays within the first cache line or two of each client.
 struct ClientInfo {
     SOCKET socket;
+    bool closing;
+    bool statusSynced;
+    // VCON_TOPIC_* bits from the client's last SUBS; a status subscriber
+    // gets a full snapshot before it is sent deltas
+    uint32_t topics;
+    // Index into the server's listeners; fixed while the server runs
+    size_t listener;
+    // Absolute index of the next scrollback line this client needs; while
+    // it is behind the newest line the client is still being replayed to
+    // and gets no live output
+    uint64_t scrollbackNext;
+
+    // Encoded frames not yet accepted by send(); only whole frames are
+    // ever queued so a slow client never sees a torn stream.
+    std::vector<uint8_t> outBuf;
+    size_t outOffset;
+    std::vector<OutputMark> outMarks;
+    size_t outMarkHead;
+    // Start of a frame whose rest has not arrived yet
+    std::vector<uint8_t> inPartial;
+
+    // Timer wheel handles, 0 while disarmed. Activity only updates the
+    // stamps below; a timer that fires early because of it is re-armed then.
+    uint64_t lastQueuedNs;    // last frame queued to it
+    uint64_t lastProgressNs;  // last time send() took bytes with more waiting
+    TimerId stallTimer;
+    TimerId idleTimer;
+    TimerId keepaliveTimer;
+    uint64_t lastReceiveNs;   // last frame received
+
     std::string ip;
     uint16_t port;
+    TokenBucket cmdBucket;
+    uint64_t commandsQueued;
+    uint64_t commandsThrottled;
+    uint64_t framesDropped;
+    bool throttled;
+
+    ClientInfo(SOCKET s, const std::string& i, uint16_t p, size_t l)
+        : socket(s), closing(false), statusSynced(false), topics(0), listener(l), scrollbackNext(0)
+        , outOffset(0), outMarkHead(0)
+        , lastQueuedNs(0), lastProgressNs(0), stallTimer(0), idleTimer(0), keepaliveTimer(0), lastReceiveNs(0)
+        , ip(i), port(p)
+        , commandsQueued(0), commandsThrottled(0), framesDropped(0), throttled(false) {}
+
+    size_t pendingBytes() const { return outBuf.size() - outOffset; }
+};
+
+// Formatting buffer for hooked engine messages; longer output takes a
+// second vsnprintf pass into a reusable spill buffer
+constexpr size_t VCON_CAPTURE_SLOT_SIZE = 4096;
+
+// Default per-client cap on unsent output before whole frames start being
+// dropped; each listener can set its own
+constexpr size_t VCON_MAX_CLIENT_BACKLOG = 4 * 1024 * 1024;
+
+// Scrollback replay pauses for a client once this much is waiting to be sent
+constexpr size_t VCON_SCROLLBACK_BACKLOG = 256 * 1024;
+
+// A port clients connect to and the policy its clients get. Every listener
+// is served by the same event loop and client table.
+struct ListenerOptions {
+    std::string name;  // letters, digits, '-' and '_'; labels its stats
+    uint16_t port = 29000;
+    std::string bindAddr = "127.0.0.1";
+    int maxConnections = 1;  // 0 = unlimited
+    double cmdRate = 0.0;    // commands per second per client, 0 = unlimited
+    int cmdBurst = 1;
+    bool readOnly = false;   // refuse CMND and CVRQ; output and CMPL still work
+    uint32_t channels = VCON_CHANNELS_ALL;  // PRNT channels forwarded, bit per ConsoleChannelId
+    size_t maxBacklog = VCON_MAX_CLIENT_BACKLOG;
+};
+
+struct Listener {
+    ListenerOptions options;
+    SOCKET socket;
+    size_t clients;
+    ListenerMetrics* metrics;  // never null; a shared spare once all slots are taken
+};
+
+// A broadcast line kept for clients that connect later
+struct ScrollbackLine {
+    std::string text;
+    int32_t channelId;
+    uint32_t color;
+    std::vector<ColorRun> runs;
+};
 
-    ClientInfo(SOCKET s, const std::string& i, uint16_t p)
-        : socket(s), ip(i), port(p) {}
+// Fills in the current server status; called on the engine thread
+using StatusProvider = void (*)(ServerStatus& status);
+
+// Reads a cvar's current value for CVRQ; entry is the indexed cvar if there
+// is one. Returns nullptr for unknown cvars. Called on the engine thread.
+using CvarReader = const char* (*)(const ConsoleIndex::Entry* entry, const char* name);
+
+// Current and maximum player count for TELE frames; called on the engine thread
+using PlayerCountProvider = void (*)(uint8_t& players, uint8_t& maxPlayers);
+
+struct PendingCommand {
+    std::string command;
+    std::string source;  // "ip:port" of the client that sent it, for the log
 };
 
 class VConsoleServer {
 public:
     static VConsoleServer& getInstance();
 
+    // Listens on port/bindAddr as the "default" listener, using the
+    // setMaxConnections() and setCommandRateLimit() policy, plus every
+    // listener added with addListener(). Port 0 skips the default one.
     bool initialize(uint16_t port = 29000, const std::string& bindAddr = "0.0.0.0");
+    // Must be called before initialize(). False if the name is invalid or
+    // taken, or VCON_MAX_LISTENERS are already configured.
+    bool addListener(const ListenerOptions& options);
+    // Closes everything; with a drain timeout set, pending output is
+    // delivered first (see setShutdownDrain)
     void shutdown();
+    // Plugin reload: instead of closing them, passes the listener, every
+    // client with its unsent output, the scrollback and queued commands to
+    // the next instance loaded into this process, which picks them up in
+    // initialize(). False if nothing could be handed over, in which case
+    // the caller should shutdown() as usual.
+    bool handOff();
     void tick();
 
-    void broadcastPrint(const std::string& message, int32_t channelId = 0, uint32_t color = 0xFFFFFFFF);
+    // Entry point for every captured console line: counts it per source and
+    // fans it out. ingestNs is the monotonicNanos() capture time; 0 means now.
+    // A line in several colors starts in color and changes at each run; it
+    // stays one line everywhere and only becomes one PRNT per color on the
+    // wire. Sinks, recordings and the shm ring store its starting color.
+    // emitter tells apart the lines of one source for the capture budget;
+    // AlertMessage passes its format string, which also names it.
+    void captureLine(CaptureSource source, std::string_view line, int32_t channelId = 0,
+                     uint32_t color = 0xFFFFFFFF, uint64_t ingestNs = 0, ColorRuns runs = {},
+                     const char* emitter = nullptr);
+    // Formats a printf-style engine message into the reserved capture slot.
+    // The view stays valid until the next call; only the engine thread may
+    // use it.
+    std::string_view formatCapture(const char* fmt, va_list args);
 
-    uint16_t getPort() const { return m_port; }
+    void broadcastPrint(std::string_view message, int32_t channelId = 0, uint32_t color = 0xFFFFFFFF,
+                        uint64_t ingestNs = 0, ColorRuns runs = {});
+
+    // Port of the first listener, 0 if there is none
+    uint16_t getPort() const { return m_listeners.empty() ? 0 : m_listeners[0].options.port; }
+    const std::vector<Listener>& getListeners() const { return m_listeners; }
     size_t getClientCount() const;
     bool isRunning() const { return m_running; }
     void setMaxConnections(int max) { m_maxConnections = max; }
     void setLogging(bool enabled) { m_logging = enabled; }
+    void setCommandRateLimit(double rate, int burst) { m_cmdRate = rate; m_cmdBurst = burst; }
     void logLocal(const char* msg);
+    void printStats();
+    void printLatency();
+    void resetLatency() { g_metrics.latency.reset(); }
+    // Cheap check for the capture hooks: false when no client, log sink or
+    // other consumer wants captured lines, so hooks can skip all formatting
+    bool wantsOutput() const { return m_wantsOutput.load(std::memory_order_relaxed); }
+
+    bool openLogSink(const std::string& path, LogSinkFormat format, size_t rotateBytes, int keepFiles);
+    void closeLogSink();
+    const LogSink& getLogSink() const { return m_logSink; }
+    // Recorder: every captured line with source and timestamp, in the binary
+    // sink format, for replay through tools/vconsole_replay
+    bool startRecording(const std::string& path);
+    void stopRecording();
+    const LogSink& getRecorder() const { return m_recorder; }
+    // Shared-memory ring for readers on the same host; lines are written as
+    // they are captured and readers are woken once per tick
+    bool openShmRing(const std::string& name, size_t capacity);
+    void closeShmRing();
+    const ShmRingWriter& getShmRing() const { return m_shmRing; }
+    // Stdout/stderr redirection; standalone harnesses turn it off before
+    // initialize() so their own output is not broadcast
+    void setOutputCapture(bool enabled) { m_outputCapture = enabled; }
+    // Socket I/O backend created by initialize(); AUTO picks epoll, then
+    // plain polling, whichever the platform supports
+    void setIoBackend(IoBackendType type) { m_ioType = type; }
+    // Keep the last lines broadcast and replay them to each new client after
+    // the handshake; 0 disables. Counts as an output consumer while set.
+    void setScrollback(size_t lines);
+    // Per-frame time budget for tick() in microseconds, 0 = unlimited
+    void setTickBudget(uint32_t us) { m_scheduler.setBudgetMicros(us); }
+    const TickScheduler& getScheduler() const { return m_scheduler; }
+    // Status snapshots for clients subscribed with SUBS, collected at most
+    // every intervalMs and only while someone is subscribed. Without a
+    // provider (standalone tools) subscriptions are accepted but idle.
+    void setStatusSource(StatusProvider provider, uint32_t intervalMs);
+    // Cvar and command names answered by CMPL, and how CVRQ reads values.
+    // Only the engine thread touches the index.
+    ConsoleIndex& getConsoleIndex() { return m_consoleIndex; }
+    void setCvarReader(CvarReader reader) { m_cvarReader = reader; }
+    // Frame timing is always sampled; closed 1s and 10s windows go to
+    // clients subscribed to VCON_TOPIC_TELEMETRY
+    void setPlayerCounter(PlayerCountProvider provider) { m_playerCounter = provider; }
+    const FrameTelemetry& getTelemetry() const { return m_telemetry; }
+    const char* getIoBackendName() const { return m_io ? m_io->name() : "none"; }
+    void setLatencyDebug(bool enabled) { m_latencyDebug = enabled; }
+    // Longest shutdown() spends flushing captured output and client queues
+    // before closing the sockets; 0 closes them straight away
+    void setShutdownDrain(uint32_t ms) { m_drainNs = static_cast<uint64_t>(ms) * 1000000; }
+    // Per-client deadlines, each 0 to disable: close a client that sent
+    // nothing for idleMs, PING keepalive subscribers that were sent nothing
+    // for keepaliveMs, and close a client whose queued output made no
+    // progress for sendMs. Must be called before initialize().
+    void setTimeouts(uint32_t idleMs, uint32_t keepaliveMs, uint32_t sendMs);
+    const TimerWheel& getTimers() const { return m_timers; }
+    bool getLatencyDebug() const { return m_latencyDebug; }
+    // Translate ANSI colors in captured stdout/stderr into PRNT colors and
+    // strip the escape sequences; off passes them through as text
+    void setAnsiColors(bool enabled) { m_ansiColors = enabled; }
+    // Consecutive identical lines from one source reach clients once, with
+    // a "(repeated N times)" line per windowMs while the run lasts and when
+    // it ends; 0 sends every line. Sinks, recordings and the shm ring always
+    // get every line. Engine thread only.
+    void setRepeatWindow(uint32_t windowMs);
+    uint32_t getRepeatWindowMs() const { return static_cast<uint32_t>(m_repeats[0].window() / 1000000); }
+    // Lines per second and burst each emitter may send to clients (rate 0 =
+    // no limit). Over budget, every sampleEvery-th line still passes (0 =
+    // none), and what was held back is reported every summaryMs. Sinks,
+    // recordings and the shm ring always get every line. Engine thread only.
+    void setCaptureBudget(double rate, double burst, uint32_t sampleEvery, uint32_t summaryMs);
+    const CaptureLimiter& getCaptureLimiter() const { return m_captureLimiter; }
 
 private:
     VConsoleServer();
@@ -68,31 +268,110 @@ private:
     VConsoleServer(const VConsoleServer&) = delete;
     VConsoleServer& operator=(const VConsoleServer&) = delete;
 
-    void acceptClients();
-    void processClients();
+    void acceptClient(SOCKET listenSocket, SOCKET clientSocket, const sockaddr_in& clientAddr);
+    void receiveClients();
+    bool flushClients(uint64_t deadlineNs);
+    bool replayScrollback(uint64_t deadlineNs);
+    void publishStatus();
+    void publishTelemetry();
+    void reapClients();
+    void drainClients();
+    void runTimers();
+    void flushRepeats(uint64_t nowNs, bool force);
+    bool admitCapture(CaptureSource source, const char* emitter, int32_t channelId, uint64_t nowNs);
+    void reportSuppressed(uint64_t nowNs, uint64_t intervalNs);
+    void sendRepeatSummary(const RepeatSummary& summary, uint64_t nowNs);
+    void armClientTimers(ClientInfo& client);
     void handleClientMessage(ClientInfo& client, const char* data, size_t len);
-    void removeClient(SOCKET socket);
+    void handleClientFrame(ClientInfo& client, const char* data, const VConFrameHeader& header);
+    void answerCompletion(ClientInfo& client, const uint8_t* payload, size_t len);
+    void answerCvarQuery(ClientInfo& client, const uint8_t* payload, size_t len);
+    void removeClient(size_t index);
+    void executePendingCommands();
+    void updateOutputInterest();
     void setNonBlocking(SOCKET socket);
 
-    void sendPacket(SOCKET socket, const char* type, const std::vector<uint8_t>& payload);
-    void sendAINF(SOCKET socket);
-    void sendADON(SOCKET socket, const std::string& name);
-    void sendCHAN(SOCKET socket);
+    void sendPrint(ClientInfo& client, std::string_view message, int32_t channelId, uint32_t color,
+                   ColorRuns runs = {});
+    void sendAINF(ClientInfo& client);
+    void sendADON(ClientInfo& client, std::string_view name);
+    void sendCHAN(ClientInfo& client);
+
+    bool queueFrames(ClientInfo& client, const uint8_t* data, size_t len, size_t frameCount, uint64_t ingestNs = 0);
+    bool flushClient(ClientInfo& client);
+    void completeMarks(ClientInfo& client);
 
-    std::vector<uint8_t> createPRNTPacket(const std::string& message, int32_t channelId, uint32_t color);
+    EncodeScratch m_encodeScratch;
+    char m_captureSlot[VCON_CAPTURE_SLOT_SIZE];
+    std::vector<char> m_captureSpill;
 
-    SOCKET m_listenSocket;
-    uint16_t m_port;
-    std::string m_bindAddr;
+    std::vector<Listener> m_listeners;
     bool m_running;
     int m_maxConnections;
     bool m_logging;
+    double m_cmdRate;
+    int m_cmdBurst;
+    uint64_t m_totalThrottled;
+    bool m_latencyDebug;
+    uint64_t m_drainNs;
+    TimerWheel m_timers;
+    std::vector<TimerEvent> m_timerEvents;
+    uint64_t m_idleTimeoutNs;
+    uint64_t m_keepaliveNs;
+    uint64_t m_sendTimeoutNs;
+    // monotonicNanos() at the start of the current tick; client activity is
+    // stamped with it instead of reading the clock for every frame
+    uint64_t m_frameNs;
+    RepeatCollapser m_repeats[CAPTURE_SOURCE_COUNT];
+    CaptureLimiter m_captureLimiter;
+    uint64_t m_budgetSummaryNs;
+    std::string m_repeatText;
+    LogSink m_logSink;
+    LogSink m_recorder;
+    ShmRingWriter m_shmRing;
+    bool m_outputCapture;
+    bool m_ansiColors;
+    IoBackendType m_ioType;
+    std::unique_ptr<IoBackend> m_io;
+    std::vector<IoEvent> m_ioEvents;
+    // Ring of the last m_scrollbackLimit lines; entries keep their string
+    // capacity when overwritten so a full ring stops allocating
+    std::vector<ScrollbackLine> m_scrollback;
+    size_t m_scrollbackLimit;
+    size_t m_scrollbackHead;
+    uint64_t m_scrollbackTotal;
+    TickScheduler m_scheduler;
+    StatusProvider m_statusProvider;
+    uint64_t m_statusIntervalNs;
+    uint64_t m_nextStatusNs;
+    // Last snapshot published; the next delta is taken against it
+    ServerStatus m_status;
+    ServerStatus m_statusScratch;
+    std::vector<uint8_t> m_statusFrame;
+    uint32_t m_statusSeq;
+    bool m_statusValid;
+    ConsoleIndex m_consoleIndex;
+    CvarReader m_cvarReader;
+    // Reused for CMPR/CVRS replies
+    std::vector<uint8_t> m_replyFrame;
+    std::vector<const ConsoleIndex::Entry*> m_completions;
+    std::vector<std::string_view> m_cvarNames;
+    std::vector<CvarValue> m_cvarValues;
+    std::string m_cvarName;
+    FrameTelemetry m_telemetry;
+    PlayerCountProvider m_playerCounter;
+    uint8_t m_telemetryFrame[sizeof(VConChunk) + VCON_TELE_PAYLOAD_SIZE];
+    size_t m_flushCursor;
+    std::atomic<bool> m_wantsOutput;
 
-    void stopListening();
-    void startListening();
+    bool atCapacity(const Listener& listener) const;
+    void stopListening(Listener& listener);
+    void startListening(Listener& listener);
+    bool adoptHandoff();
 
-    std::vector<ClientInfo> m_clients;
+    ClientTable<ClientInfo> m_clients;
     std::mutex m_clientsMutex;
+    std::vector<PendingCommand> m_pendingCommands;
 
 #ifndef _WIN32
     int m_stdoutPipe[2];
@@ -101,10 +380,24 @@ private:
     int m_origStderr;
     bool m_captureActive;
     std::string m_partialLine;
+    uint64_t m_partialLineNs;
+    uint32_t m_partialColor;
+    std::vector<ColorRun> m_partialRuns;
+    // Escape sequence state of each stream, with its default color
+    AnsiParser m_stdoutAnsi;
+    AnsiParser m_stderrAnsi;
+    // Color changes in the current read, and in the line being cut from it;
+    // both keep their capacity
+    std::vector<ColorRun> m_readRuns;
+    std::vector<ColorRun> m_lineRuns;
 
     void setupOutputCapture();
     void cleanupOutputCapture();
     void readCapturedOutput();
+    void drainPipe(int fd, int passthroughFd, CaptureSource source, AnsiParser& ansi, bool keepPartial);
+    void captureRead(CaptureSource source, std::string_view text, uint32_t color, uint64_t readNs, bool keepPartial);
+    void appendPartialLine(std::string_view text, uint32_t color, ColorRuns runs, uint64_t readNs);
+    void flushPartialLine(CaptureSource source);
 #endif
 };
 
@@ -0,0 +1,214 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ansi.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static const uint32_t WHITE = 0xFFFFFFFF;
+static const uint32_t RED = 0xFFFF0000;
+
+// Text and color changes that come out of feeding input in pieces of step bytes
+struct Stripped {
+    std::string text;
+    std::vector<std::pair<size_t, uint32_t>> colors;
+};
+
+static Stripped run(AnsiParser& parser, const std::string& input, size_t step = 0) {
+    Stripped out;
+    std::string buffer = input;
+    if (step == 0) {
+        step = buffer.size();
+    }
+    for (size_t pos = 0; pos < buffer.size(); pos += step) {
+        size_t n = std::min(step, buffer.size() - pos);
+        size_t base = out.text.size();
+        size_t len = parser.strip(&buffer[pos], n, [&](size_t offset, uint32_t color) {
+            out.colors.push_back({base + offset, color});
+        });
+        CHECK(len <= n);
+        out.text.append(&buffer[pos], len);
+    }
+    return out;
+}
+
+static void testPlainText() {
+    AnsiParser parser;
+    Stripped s = run(parser, "L 10/19/2026 - 12:00:00: \"Player<2><STEAM_0:1:1><CT>\" say \"[hi]\"\n");
+    CHECK(s.text == "L 10/19/2026 - 12:00:00: \"Player<2><STEAM_0:1:1><CT>\" say \"[hi]\"\n");
+    CHECK(s.colors.empty());
+    CHECK(parser.color() == WHITE);
+}
+
+static void testSgrColors() {
+    AnsiParser parser;
+    Stripped s = run(parser, "ok \x1b[31mred\x1b[0m plain \x1b[1;32mgreen\x1b[m\n");
+    CHECK(s.text == "ok red plain green\n");
+    CHECK(s.colors.size() == 4);
+    CHECK(s.colors[0].first == 3 && s.colors[0].second == 0xFFCD0000);
+    CHECK(s.colors[1].first == 6 && s.colors[1].second == WHITE);
+    CHECK(s.colors[2].first == 13 && s.colors[2].second == 0xFF00FF00);  // bold makes it bright
+    CHECK(s.colors[3].first == 18 && s.colors[3].second == WHITE);
+
+    // Bright codes, 256 colors and true color; backgrounds are skipped
+    parser.reset();
+    s = run(parser, "\x1b[93ma\x1b[38;5;196mb\x1b[38;5;244mc\x1b[38;2;1;2;3md\x1b[44;48;5;12;48;2;9;9;9me\x1b[39mf");
+    CHECK(s.text == "abcdef");
+    CHECK(s.colors.size() == 5);
+    CHECK(s.colors[0].second == 0xFFFFFF00);
+    CHECK(s.colors[1].second == 0xFFFF0000);
+    CHECK(s.colors[2].second == 0xFF808080);
+    CHECK(s.colors[3].first == 3 && s.colors[3].second == 0xFF010203);
+    CHECK(s.colors[4].first == 5 && s.colors[4].second == WHITE);
+
+    // Setting the color already in effect is not a change
+    parser.reset();
+    s = run(parser, "\x1b[31ma\x1b[31mb\x1b[0;31mc");
+    CHECK(s.text == "abc" && s.colors.size() == 1);
+
+    // Reset goes back to the stream's own default
+    AnsiParser errors(RED);
+    s = run(errors, "\x1b[33mwarn\x1b[0m err");
+    CHECK(s.colors.size() == 2 && s.colors[1].second == RED && errors.color() == RED);
+}
+
+static void testOtherSequences() {
+    AnsiParser parser;
+    // Cursor and erase CSI, private modes, a window title ended by BEL and by
+    // ESC \, charset selection and a two-byte ESC sequence
+    Stripped s = run(parser,
+        "\x1b[2K\x1b[1Gone\x1b[?25l \x1b]0;hlds title\x07two \x1b]2;x\x1b\\three\x1b(B \x1b" "7four\x1bPdcs\x1b\\\n");
+    CHECK(s.text == "one two three four\n");
+    CHECK(s.colors.empty());
+
+    // A control character abandons an unfinished sequence and is kept
+    parser.reset();
+    s = run(parser, "a\x1b[31\nb\x1b]title\nc\x1b\n");
+    CHECK(s.text == "a\nb\nc\n");
+    CHECK(s.colors.empty());
+
+    // Too many parameters are ignored rather than misread
+    parser.reset();
+    s = run(parser, "\x1b[0;0;0;0;0;0;0;0;0;0;0;0;0;0;0;0;0;31mx");
+    CHECK(s.text == "x" && s.colors.empty());
+    s = run(parser, "\x1b[99999mx\x1b[31my");
+    CHECK(s.text == "xy" && s.colors.size() == 1 && s.colors[0].first == 1);
+
+    // UTF-8 passes through untouched
+    parser.reset();
+    s = run(parser, "\xc3\xa9t\xc3\xa9 \x1b[36m\xe2\x9c\x93\x1b[0m");
+    CHECK(s.text == "\xc3\xa9t\xc3\xa9 \xe2\x9c\x93");
+}
+
+// Every way of cutting the input across reads gives the same result
+static void testSplitReads() {
+    const std::string input =
+        "[AMXX] \x1b[1;31mError\x1b[0m: plugin \x1b[38;5;208m\"foo.amxx\"\x1b[39m failed\n"
+        "\x1b]0;title\x07\x1b[32mloaded\x1b[m 12 plugins\n";
+    AnsiParser whole;
+    Stripped expected = run(whole, input);
+    CHECK(expected.text == "[AMXX] Error: plugin \"foo.amxx\" failed\nloaded 12 plugins\n");
+    CHECK(expected.colors.size() == 6);
+
+    for (size_t step = 1; step < input.size(); step++) {
+        AnsiParser parser;
+        Stripped s = run(parser, input, step);
+        CHECK(s.text == expected.text);
+        CHECK(s.colors == expected.colors);
+    }
+}
+
+static void testPalette() {
+    CHECK(AnsiParser::paletteColor(0) == 0xFF000000);
+    CHECK(AnsiParser::paletteColor(15) == 0xFFFFFFFF);
+    CHECK(AnsiParser::paletteColor(16) == 0xFF000000);
+    CHECK(AnsiParser::paletteColor(21) == 0xFF0000FF);
+    CHECK(AnsiParser::paletteColor(231) == 0xFFFFFFFF);
+    CHECK(AnsiParser::paletteColor(232) == 0xFF080808);
+    CHECK(AnsiParser::paletteColor(255) == 0xFFEEEEEE);
+}
+
+// Plain console text through the capture path's line split, with and
+// without stripping, in 4 KB reads like the pipe drain
+static void bench() {
+    std::string text;
+    for (int i = 0; text.size() < (64u << 20); i++) {
+        char line[160];
+        snprintf(line, sizeof(line), "L 10/19/2026 - 12:%02d:%02d: \"Player%d<%d><STEAM_0:1:%d><CT>\" killed \"Bot<3><BOT><TERRORIST>\" with \"ak47\"\n",
+                 i / 60 % 60, i % 60, i % 32, i % 32 + 1, i * 7919 % 100000);
+        text += line;
+    }
+
+    auto measure = [&](const char* name, const std::string& input, bool strip) {
+        AnsiParser parser;
+        char buffer[4096];
+        size_t lines = 0;
+        size_t changes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < 4; pass++) {
+            for (size_t pos = 0; pos < input.size(); pos += sizeof(buffer)) {
+                // The copy stands in for read()
+                size_t n = std::min(sizeof(buffer), input.size() - pos);
+                memcpy(buffer, input.data() + pos, n);
+                if (strip) {
+                    n = parser.strip(buffer, n, [&](size_t, uint32_t) { changes++; });
+                }
+                const char* p = buffer;
+                const char* end = buffer + n;
+                const char* nl;
+                while ((nl = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr) {
+                    lines++;
+                    p = nl + 1;
+                }
+            }
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double mb = 4.0 * input.size() / (1 << 20);
+        std::cout << name << ": " << static_cast<int>(mb / secs) << " MB/s, " << lines << " lines, " << changes
+                  << " color changes" << std::endl;
+        return secs;
+    };
+
+    double split = measure("plain, split only ", text, false);
+    double stripped = measure("plain, ANSI + split", text, true);
+    std::cout << "ANSI overhead on plain text: " << static_cast<int>((stripped / split - 1.0) * 100.0) << "%" << std::endl;
+
+    std::string colored;
+    while (colored.size() < text.size()) {
+        colored += "\x1b[1;33m[AMXX]\x1b[0m \x1b[31mRun time error 4\x1b[m: index out of bounds (plugin \"x.amxx\")\n";
+    }
+    measure("colored, ANSI + split", colored, true);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench();
+        return 0;
+    }
+
+    testPlainText();
+    testSgrColors();
+    testOtherSequences();
+    testSplitReads();
+    testPalette();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All ANSI tests passed" << std::endl;
+    return 0;
+}
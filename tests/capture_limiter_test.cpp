@@ -0,0 +1,137 @@
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "capture_limiter.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static const uint64_t MS = 1000000;
+
+struct Report {
+    CaptureSource source;
+    std::string label;
+    uint64_t suppressed;
+    uint64_t sampled;
+    uint64_t spanNs;
+};
+
+static std::vector<Report> collect(CaptureLimiter& limiter, uint64_t nowNs, uint64_t intervalNs) {
+    std::vector<Report> reports;
+    limiter.collect(nowNs, intervalNs, [&](const CaptureEmitter& e, uint64_t spanNs) {
+        reports.push_back({e.source, e.label, e.suppressed, e.sampled, spanNs});
+    });
+    return reports;
+}
+
+static void testDisabled() {
+    CaptureLimiter limiter;
+    limiter.configure(0.0, 10.0, 0);
+    for (int i = 0; i < 1000; i++) {
+        CHECK(limiter.admit(CAPTURE_PRINT, nullptr, nullptr, 0, 0));
+    }
+    CHECK(limiter.emitters() == 0);
+    CHECK(collect(limiter, 1000 * MS, 0).empty());
+}
+
+// Emitters are told apart by source and key, and each has its own budget
+static void testPerEmitter() {
+    static const char loop[] = "Run time error %d\n";
+    static const char quiet[] = "Map changed to %s\n";
+    uint64_t now = 1000000 * MS;
+
+    CaptureLimiter limiter;
+    limiter.configure(10.0, 5.0, 0);
+    int passed = 0;
+    for (int i = 0; i < 100; i++) {
+        passed += limiter.admit(CAPTURE_ALERT, loop, loop, 3, now);
+    }
+    CHECK(passed == 5);
+    CHECK(limiter.admit(CAPTURE_ALERT, quiet, quiet, 3, now));
+    CHECK(limiter.admit(CAPTURE_STDOUT, loop, nullptr, 0, now));
+    CHECK(limiter.admit(CAPTURE_STDERR, nullptr, nullptr, 0, now));
+    CHECK(limiter.emitters() == 4);
+
+    // Refills at the configured rate
+    CHECK(!limiter.admit(CAPTURE_ALERT, loop, loop, 3, now + 50 * MS));
+    CHECK(limiter.admit(CAPTURE_ALERT, loop, loop, 3, now + 150 * MS));
+
+    // Reported once the interval has passed since the first suppressed line
+    CHECK(collect(limiter, now + 999 * MS, 1000 * MS).empty());
+    std::vector<Report> reports = collect(limiter, now + 1500 * MS, 1000 * MS);
+    CHECK(reports.size() == 1);
+    if (reports.size() == 1) {
+        CHECK(reports[0].source == CAPTURE_ALERT && reports[0].label == loop);
+        CHECK(reports[0].suppressed == 96 && reports[0].sampled == 0);
+        CHECK(reports[0].spanNs == 1500 * MS);
+    }
+    CHECK(collect(limiter, now + 9000 * MS, 1000 * MS).empty());
+}
+
+static void testSampling() {
+    static const char fmt[] = "spam\n";
+    CaptureLimiter limiter;
+    limiter.configure(1.0, 1.0, 10);
+    int passed = 0;
+    for (int i = 0; i < 1001; i++) {
+        passed += limiter.admit(CAPTURE_ALERT, fmt, fmt, 0, 5000 * MS);
+    }
+    CHECK(passed == 1 + 100);
+    std::vector<Report> reports = collect(limiter, 5000 * MS, 0);
+    CHECK(reports.size() == 1 && reports[0].suppressed == 900 && reports[0].sampled == 100);
+
+    // Reconfiguring starts every emitter over
+    limiter.configure(1.0, 1.0, 10);
+    CHECK(limiter.emitters() == 0);
+    CHECK(limiter.admit(CAPTURE_ALERT, fmt, fmt, 0, 5000 * MS));
+}
+
+// Labels are copied and cut to fit; once the table is full, new emitters
+// share one bucket per source
+static void testTable() {
+    CaptureLimiter limiter;
+    limiter.configure(1.0, 1.0, 0);
+
+    std::string longLabel(200, 'x');
+    std::vector<char> keys(CaptureLimiter::SLOTS * 4);
+    for (size_t i = 0; i < keys.size(); i++) {
+        limiter.admit(CAPTURE_ALERT, &keys[i], longLabel.c_str(), 0, 0);
+    }
+    CHECK(limiter.emitters() <= CaptureLimiter::SLOTS);
+    CHECK(limiter.emitters() >= CaptureLimiter::SLOTS / 2);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        limiter.admit(CAPTURE_ALERT, &keys[i], longLabel.c_str(), 0, 0);
+    }
+    uint64_t total = 0;
+    bool shared = false;
+    for (const Report& r : collect(limiter, 0, 0)) {
+        CHECK(r.label.empty() || r.label == longLabel.substr(0, sizeof(CaptureEmitter::label) - 1));
+        shared = shared || r.label.empty();
+        total += r.suppressed;
+    }
+    CHECK(shared);
+    // Every admit past each emitter's single token was suppressed
+    CHECK(total == 2 * keys.size() - limiter.emitters() - 1);
+}
+
+int main() {
+    testDisabled();
+    testPerEmitter();
+    testSampling();
+    testTable();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All capture limiter tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+#include "client_table.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+struct Entry {
+    int socket;
+    std::string name;
+    Entry(int s, std::string n) : socket(s), name(std::move(n)) {}
+};
+
+static void testBasics() {
+    ClientTable<Entry> table;
+    CHECK(table.empty() && table.find(5) == nullptr && table.get(0) == nullptr);
+
+    Entry* a = table.emplace(5, 5, "a");
+    CHECK(a && a->name == "a");
+    ClientId idA = table.idOf(*a);
+    CHECK(table.emplace(5, 5, "dup") == nullptr);
+    table.emplace(7, 7, "b");
+    table.emplace(9, 9, "c");
+    CHECK(table.size() == 3);
+    ClientId idC = table.idOf(*table.find(9));
+
+    // Removing the first entry moves the last one into its place; ids and
+    // keys still find it
+    CHECK(table.remove(5));
+    CHECK(!table.remove(5));
+    CHECK(table.size() == 2);
+    CHECK(table[0].name == "c");
+    CHECK(table.get(idC) && table.get(idC)->name == "c");
+    CHECK(table.find(9) == table.get(idC));
+    CHECK(table.idAt(0) == idC);
+
+    // The freed slot is reused under a new generation
+    CHECK(table.get(idA) == nullptr);
+    Entry* d = table.emplace(5, 5, "d");
+    CHECK(d && table.idOf(*d) != idA && table.get(idA) == nullptr);
+
+    table.clear();
+    CHECK(table.empty() && table.get(idC) == nullptr && table.find(7) == nullptr);
+    CHECK(table.emplace(7, 7, "e") != nullptr && table.size() == 1);
+}
+
+// Random churn checked against a plain map, with back-to-front removal
+// during a walk as the server's reaper does it
+static void testChurn() {
+    srand(3);
+    ClientTable<Entry> table;
+    std::map<int, ClientId> live;
+    std::vector<ClientId> dead;
+
+    for (int round = 0; round < 20000; round++) {
+        int key = rand() % 500;
+        if (rand() % 3 != 0) {
+            if (Entry* e = table.emplace(key, key, std::to_string(key))) {
+                CHECK(!live.count(key));
+                live[key] = table.idOf(*e);
+            } else {
+                CHECK(live.count(key));
+            }
+        } else if (live.count(key)) {
+            dead.push_back(live[key]);
+            CHECK(table.remove(key));
+            live.erase(key);
+        }
+
+        if (round % 1000 == 999) {
+            for (size_t i = table.size(); i-- > 0;) {
+                if (table[i].socket % 7 == 0) {
+                    dead.push_back(table.idAt(i));
+                    live.erase(table[i].socket);
+                    table.removeAt(i);
+                }
+            }
+        }
+    }
+
+    CHECK(table.size() == live.size());
+    for (const auto& kv : live) {
+        Entry* e = table.get(kv.second);
+        CHECK(e && e->socket == kv.first && e->name == std::to_string(kv.first));
+        CHECK(table.find(kv.first) == e);
+    }
+    for (ClientId id : dead) {
+        CHECK(table.get(id) == nullptr);
+    }
+    for (const Entry& e : table) {
+        CHECK(live.count(e.socket) == 1);
+    }
+}
+
+int main() {
+    testBasics();
+    testChurn();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All client table tests passed" << std::endl;
+    return 0;
+}
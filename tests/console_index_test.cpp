@@ -0,0 +1,173 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "console_index.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static ConsoleIndex sampleIndex() {
+    ConsoleIndex index;
+    index.add("sv_gravity", CONSOLE_CVAR);
+    index.add("sv_cheats", CONSOLE_CVAR);
+    index.add("status", CONSOLE_COMMAND);
+    index.add("SV_Maxspeed", CONSOLE_CVAR);
+    index.add("sv_restart", CONSOLE_CVAR);
+    index.add("say", CONSOLE_COMMAND);
+    index.add("sv_", CONSOLE_CVAR);
+    index.add("svc_dump", CONSOLE_COMMAND);
+    return index;
+}
+
+static std::vector<std::string> names(const std::vector<const ConsoleIndex::Entry*>& entries) {
+    std::vector<std::string> out;
+    for (const auto* entry : entries) {
+        out.push_back(entry->name);
+    }
+    return out;
+}
+
+static void testPrefixCompletion() {
+    ConsoleIndex index = sampleIndex();
+    CHECK(index.size() == 8);
+
+    std::vector<const ConsoleIndex::Entry*> out;
+    size_t total = index.complete("sv_", 10, CONSOLE_CVAR | CONSOLE_COMMAND, out);
+    CHECK(total == 5);
+    CHECK((names(out) == std::vector<std::string>{"sv_", "sv_cheats", "sv_gravity", "SV_Maxspeed", "sv_restart"}));
+
+    // Case-insensitive, limited, but the total still counts every match
+    out.clear();
+    total = index.complete("SV_", 2, CONSOLE_CVAR | CONSOLE_COMMAND, out);
+    CHECK(total == 5);
+    CHECK((names(out) == std::vector<std::string>{"sv_", "sv_cheats"}));
+
+    out.clear();
+    total = index.complete("s", 100, CONSOLE_COMMAND, out);
+    CHECK(total == 3);
+    CHECK((names(out) == std::vector<std::string>{"say", "status", "svc_dump"}));
+
+    out.clear();
+    CHECK(index.complete("zz", 10, CONSOLE_CVAR | CONSOLE_COMMAND, out) == 0);
+    CHECK(out.empty());
+
+    // An empty prefix lists everything
+    out.clear();
+    CHECK(index.complete("", 100, CONSOLE_CVAR | CONSOLE_COMMAND, out) == 8);
+}
+
+static void testAddAndFind() {
+    ConsoleIndex index = sampleIndex();
+    int handle = 0;
+    CHECK(!index.add("SV_GRAVITY", CONSOLE_CVAR, &handle));
+    CHECK(!index.add("", CONSOLE_CVAR));
+    CHECK(index.add("mp_timelimit", CONSOLE_CVAR, &handle));
+
+    const ConsoleIndex::Entry* entry = index.find("MP_TimeLimit");
+    CHECK(entry != nullptr);
+    CHECK(entry && entry->name == "mp_timelimit");
+    CHECK(entry && entry->handle == &handle);
+    CHECK(index.find("mp_time") == nullptr);
+    CHECK(index.count(CONSOLE_CVAR) == 6);
+    CHECK(index.count(CONSOLE_COMMAND) == 3);
+}
+
+// Strips the frame header after checking it, like a client reading the stream
+static bool framePayload(const std::vector<uint8_t>& frame, const char* type, const uint8_t*& payload, size_t& len) {
+    VConFrameHeader header;
+    if (!readFrameHeader(frame.data(), frame.size(), header) || !header.is(type) || header.length != frame.size()) {
+        return false;
+    }
+    payload = frame.data() + sizeof(VConChunk);
+    len = frame.size() - sizeof(VConChunk);
+    return true;
+}
+
+static void testCompletionFrames() {
+    std::vector<uint8_t> request;
+    appendCMPLFrame(request, 77, "sv_", 3);
+    const uint8_t* payload = nullptr;
+    size_t len = 0;
+    CHECK(framePayload(request, "CMPL", payload, len));
+
+    CompletionRequest parsed{};
+    CHECK(parseCMPL(payload, len, parsed));
+    CHECK(parsed.id == 77);
+    CHECK(parsed.maxResults == 3);
+    CHECK(parsed.kinds == (CONSOLE_CVAR | CONSOLE_COMMAND));
+    CHECK(parsed.prefix == "sv_");
+    CHECK(!parseCMPL(payload, VCON_CMPL_HEADER_SIZE - 1, parsed));
+
+    ConsoleIndex index = sampleIndex();
+    std::vector<const ConsoleIndex::Entry*> out;
+    size_t total = index.complete(parsed.prefix, parsed.maxResults, parsed.kinds, out);
+    std::vector<uint8_t> reply;
+    encodeCMPRFrame(reply, parsed.id, total, out);
+    CHECK(framePayload(reply, "CMPR", payload, len));
+
+    uint32_t id = 0;
+    uint16_t replyTotal = 0;
+    std::vector<CompletionMatch> matches;
+    CHECK(parseCMPR(payload, len, id, replyTotal, matches));
+    CHECK(id == 77);
+    CHECK(replyTotal == 5);
+    CHECK(matches.size() == 3);
+    CHECK(matches.size() == 3 && matches[2].name == "sv_gravity" && matches[2].kind == CONSOLE_CVAR);
+    CHECK(!parseCMPR(payload, len - 1, id, replyTotal, matches));
+}
+
+static void testCvarFrames() {
+    std::vector<uint8_t> request;
+    appendCVRQFrame(request, 9, {"sv_gravity", "hostname", "nope"});
+    const uint8_t* payload = nullptr;
+    size_t len = 0;
+    CHECK(framePayload(request, "CVRQ", payload, len));
+
+    uint32_t id = 0;
+    std::vector<std::string_view> requested;
+    CHECK(parseCVRQ(payload, len, id, requested));
+    CHECK(id == 9);
+    CHECK((requested == std::vector<std::string_view>{"sv_gravity", "hostname", "nope"}));
+    std::vector<std::string_view> partial;
+    CHECK(!parseCVRQ(payload, len - 1, id, partial));
+
+    std::string longValue(70000, 'x');
+    std::vector<CvarValue> values = {
+        {"sv_gravity", "800"}, {"hostname", "My Server"}, {"nope", nullptr}, {"motd", longValue.c_str()},
+    };
+    std::vector<uint8_t> reply;
+    encodeCVRSFrame(reply, id, values);
+    CHECK(reply.size() <= VCON_MAX_FRAME_SIZE);
+    CHECK(framePayload(reply, "CVRS", payload, len));
+
+    std::vector<CvarResult> results;
+    CHECK(parseCVRS(payload, len, id, results));
+    CHECK(id == 9);
+    // The value that cannot fit in the frame is left out
+    CHECK(results.size() == 3);
+    CHECK(results.size() == 3 && results[0].found && results[0].value == "800");
+    CHECK(results.size() == 3 && results[1].name == "hostname" && results[1].value == "My Server");
+    CHECK(results.size() == 3 && !results[2].found && results[2].value.empty());
+}
+
+int main() {
+    testPrefixCompletion();
+    testAddAndFind();
+    testCompletionFrames();
+    testCvarFrames();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All console index tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "handoff.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static HandoffState sampleState() {
+    HandoffState state;
+    state.pid = 4242;
+    state.createdNs = 0x0102030405060708ull;
+    state.listeners.push_back({"default", 7, 29000, "127.0.0.1"});
+    state.listeners.push_back({"public", -1, 29001, "0.0.0.0"});
+    state.scrollbackTotal = 1000;
+    state.scrollback.push_back({"first line", 0, 0xFFFFFFFF, {}});
+    state.scrollback.push_back({"second line", -3, 0xFF0000FF, {{7, 0xFFFFFFFF}}});
+
+    HandoffClient client;
+    client.socket = 9;
+    client.listener = "default";
+    client.ip = "10.0.0.5";
+    client.port = 51234;
+    client.topics = 3;
+    client.commandsQueued = 12;
+    client.commandsThrottled = 2;
+    client.framesDropped = 1ull << 40;
+    client.scrollbackNext = 999;
+    client.unsent = {'P', 'R', 'N', 'T', 0, 1, 2, 3};
+    client.unread = {'C', 'M', 'N', 'D', 0, 0};
+    state.clients.push_back(client);
+    client.socket = 10;
+    client.listener = "public";
+    client.ip = "10.0.0.6";
+    client.unsent.clear();
+    client.unread.clear();
+    state.clients.push_back(client);
+
+    state.commands.push_back({"status", "10.0.0.5:51234"});
+    return state;
+}
+
+static void testRoundTrip() {
+    HandoffState state = sampleState();
+    std::vector<uint8_t> blob;
+    encodeHandoff(state, blob);
+
+    HandoffState decoded;
+    CHECK(decodeHandoff(blob.data(), blob.size(), decoded) == HANDOFF_DECODED);
+    CHECK(decoded.pid == 4242);
+    CHECK(decoded.createdNs == 0x0102030405060708ull);
+    CHECK(decoded.listeners.size() == 2);
+    if (decoded.listeners.size() == 2) {
+        CHECK(decoded.listeners[0].name == "default" && decoded.listeners[0].socket == 7);
+        CHECK(decoded.listeners[0].port == 29000 && decoded.listeners[0].bindAddr == "127.0.0.1");
+        CHECK(decoded.listeners[1].name == "public" && decoded.listeners[1].socket == -1);
+    }
+    CHECK(decoded.scrollbackTotal == 1000);
+    CHECK(decoded.scrollback.size() == 2);
+    CHECK(decoded.scrollback.size() == 2 && decoded.scrollback[1].text == "second line" &&
+          decoded.scrollback[1].channelId == -3 && decoded.scrollback[1].color == 0xFF0000FF);
+    CHECK(decoded.scrollback.size() == 2 && decoded.scrollback[0].runs.empty() &&
+          decoded.scrollback[1].runs.size() == 1 && decoded.scrollback[1].runs[0].offset == 7 &&
+          decoded.scrollback[1].runs[0].color == 0xFFFFFFFF);
+    CHECK(decoded.clients.size() == 2);
+    if (decoded.clients.size() == 2) {
+        const HandoffClient& c = decoded.clients[0];
+        CHECK(c.socket == 9 && c.listener == "default" && c.ip == "10.0.0.5" && c.port == 51234 && c.topics == 3);
+        CHECK(c.commandsQueued == 12 && c.commandsThrottled == 2 && c.framesDropped == (1ull << 40));
+        CHECK(c.scrollbackNext == 999);
+        CHECK(c.unsent == state.clients[0].unsent && c.unread == state.clients[0].unread);
+        CHECK(decoded.clients[1].socket == 10 && decoded.clients[1].listener == "public" &&
+              decoded.clients[1].unsent.empty() && decoded.clients[1].unread.empty());
+    }
+    CHECK(decoded.commands.size() == 1 && decoded.commands[0].command == "status" &&
+          decoded.commands[0].source == "10.0.0.5:51234");
+
+    // No listener and nothing else is valid too
+    HandoffState empty;
+    encodeHandoff(empty, blob);
+    CHECK(decodeHandoff(blob.data(), blob.size(), decoded) == HANDOFF_DECODED);
+    CHECK(decoded.listeners.empty() && decoded.clients.empty() && decoded.scrollback.empty());
+}
+
+static void testRejects() {
+    std::vector<uint8_t> blob;
+    encodeHandoff(sampleState(), blob);
+    HandoffState decoded;
+
+    // Every truncation and trailing garbage is caught
+    for (size_t len = 0; len < blob.size(); len++) {
+        CHECK(decodeHandoff(blob.data(), len, decoded) == HANDOFF_MALFORMED);
+    }
+    std::vector<uint8_t> longer = blob;
+    longer.push_back(0);
+    CHECK(decodeHandoff(longer.data(), longer.size(), decoded) == HANDOFF_MALFORMED);
+
+    std::vector<uint8_t> badMagic = blob;
+    badMagic[0] = 'X';
+    CHECK(decodeHandoff(badMagic.data(), badMagic.size(), decoded) == HANDOFF_MALFORMED);
+
+    std::vector<uint8_t> newer = blob;
+    putBE32(newer.data() + 4, VCON_HANDOFF_VERSION + 1);
+    CHECK(decodeHandoff(newer.data(), newer.size(), decoded) == HANDOFF_VERSION_MISMATCH);
+
+    // A huge line count is refused before anything is reserved
+    HandoffState state;
+    encodeHandoff(state, blob);
+    size_t countOffset = 4 + 4 + 4 + 8 + 4 + 4 + 8;
+    putBE32(blob.data() + countOffset, 0xFFFFFFFF);
+    CHECK(decodeHandoff(blob.data(), blob.size(), decoded) == HANDOFF_MALFORMED);
+}
+
+// Any version's header names every socket, so a blob that is rejected can
+// still have them closed
+static void testHeader() {
+    std::vector<uint8_t> blob;
+    encodeHandoff(sampleState(), blob);
+
+    HandoffHeader header;
+    CHECK(decodeHandoffHeader(blob.data(), blob.size(), header));
+    CHECK(header.version == VCON_HANDOFF_VERSION && header.pid == 4242);
+    CHECK(header.createdNs == 0x0102030405060708ull);
+    // The closed listener is not listed
+    CHECK((header.sockets == std::vector<int32_t>{7, 9, 10}));
+
+    putBE32(blob.data() + 4, VCON_HANDOFF_VERSION + 1);
+    blob.resize(blob.size() - 5);
+    HandoffState decoded;
+    CHECK(decodeHandoff(blob.data(), blob.size(), decoded) == HANDOFF_VERSION_MISMATCH);
+    CHECK(decodeHandoffHeader(blob.data(), blob.size(), header));
+    CHECK(header.version == VCON_HANDOFF_VERSION + 1 && header.sockets.size() == 3);
+
+    CHECK(!decodeHandoffHeader(blob.data(), 4 + 4 + 4 + 8 + 4 + 2, header));
+    blob[1] = 'X';
+    CHECK(!decodeHandoffHeader(blob.data(), blob.size(), header));
+}
+
+static size_t openDescriptors() {
+    size_t count = 0;
+    for (int fd = 0; fd < 1024; fd++) {
+        count += fcntl(fd, F_GETFD) != -1;
+    }
+    return count;
+}
+
+static void testTransport() {
+    std::vector<uint8_t> taken;
+    CHECK(!takeHandoff(taken));
+    size_t before = openDescriptors();
+
+    std::vector<uint8_t> blob;
+    encodeHandoff(sampleState(), blob);
+    CHECK(publishHandoff(blob));
+    CHECK(openDescriptors() == before + 1);
+
+    // Publishing again replaces the blob that was never taken
+    std::vector<uint8_t> second = blob;
+    second.push_back(0xAB);
+    CHECK(publishHandoff(second));
+    CHECK(openDescriptors() == before + 1);
+
+    CHECK(takeHandoff(taken));
+    CHECK(taken == second);
+    CHECK(openDescriptors() == before);
+    CHECK(!takeHandoff(taken));
+}
+
+int main() {
+    testRoundTrip();
+    testRejects();
+    testHeader();
+    testTransport();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All handoff tests passed" << std::endl;
+    return 0;
+}
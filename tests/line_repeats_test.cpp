@@ -0,0 +1,149 @@
+#include <iostream>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "line_repeats.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static const uint64_t MS = 1000000;
+
+static void testRuns() {
+    RepeatCollapser repeats;
+    repeats.setWindow(1000 * MS);
+    RepeatSummary summary;
+    uint64_t now = 5000 * MS;
+
+    CHECK(repeats.admit("SZ_GetSpace: overflow\n", 0, 0xFFFFFFFF, now, summary));
+    CHECK(summary.count == 0);
+    for (int i = 0; i < 99; i++) {
+        CHECK(!repeats.admit("SZ_GetSpace: overflow\n", 0, 0xFFFFFFFF, now + i * MS, summary));
+        CHECK(summary.count == 0);
+    }
+    CHECK(!repeats.flush(now + 999 * MS, summary));
+
+    // A different line ends the run; its summary comes first and stays
+    // valid until the next call
+    CHECK(repeats.admit("other\n", 0, 0xFFFFFFFF, now + 200 * MS, summary));
+    CHECK(summary.count == 99 && summary.line == "SZ_GetSpace: overflow\n");
+    CHECK(summary.channelId == 0 && summary.color == 0xFFFFFFFF);
+
+    // Same text in another channel or color is a different line
+    CHECK(repeats.admit("other\n", 3, 0xFFFFFFFF, now + 201 * MS, summary));
+    CHECK(repeats.admit("other\n", 3, 0xFFFF0000, now + 202 * MS, summary));
+    CHECK(!repeats.admit("other\n", 3, 0xFFFF0000, now + 203 * MS, summary));
+    CHECK(repeats.admit("other", 3, 0xFFFF0000, now + 204 * MS, summary));
+    CHECK(summary.count == 1 && summary.channelId == 3 && summary.color == 0xFFFF0000);
+    CHECK(summary.line == "other\n");
+}
+
+// Same text in other colors mid-line is a different line; the summary
+// carries the colors of the run it ends
+static void testColors() {
+    RepeatCollapser repeats;
+    repeats.setWindow(1000 * MS);
+    RepeatSummary summary;
+    std::vector<ColorRun> red = {{7, 0xFFFF0000}};
+    std::vector<ColorRun> green = {{7, 0xFF00FF00}};
+
+    CHECK(repeats.admit("[AMXX] Error\n", 0, 0xFFFFFFFF, 0, summary, red));
+    CHECK(!repeats.admit("[AMXX] Error\n", 0, 0xFFFFFFFF, MS, summary, red));
+    CHECK(repeats.admit("[AMXX] Error\n", 0, 0xFFFFFFFF, 2 * MS, summary, green));
+    CHECK(summary.count == 1 && summary.runs.size() == 1);
+    CHECK(summary.runs.size() == 1 && summary.runs.data[0].offset == 7 && summary.runs.data[0].color == 0xFFFF0000);
+    CHECK(repeats.admit("[AMXX] Error\n", 0, 0xFFFFFFFF, 3 * MS, summary));
+    CHECK(summary.count == 0);
+}
+
+// A long run reports once per window while it lasts, and the tick flush
+// reports a run that stopped
+static void testWindow() {
+    RepeatCollapser repeats;
+    repeats.setWindow(1000 * MS);
+    RepeatSummary summary;
+    uint64_t start = 10000 * MS;
+
+    std::vector<uint64_t> counts;
+    CHECK(repeats.admit("loop\n", 0, 0, start, summary));
+    for (uint64_t t = 1; t <= 3500; t++) {
+        CHECK(!repeats.admit("loop\n", 0, 0, start + t * MS, summary));
+        if (summary.count > 0) {
+            counts.push_back(summary.count);
+        }
+    }
+    CHECK(counts.size() == 3);
+    CHECK(counts.size() == 3 && counts[0] == 1000 && counts[1] == 1000 && counts[2] == 1000);
+
+    CHECK(!repeats.flush(start + 3999 * MS, summary));
+    CHECK(repeats.flush(start + 4000 * MS, summary));
+    CHECK(summary.count == 500 && summary.line == "loop\n");
+    CHECK(!repeats.flush(start + 9000 * MS, summary));
+
+    // A copy after a quiet window is reported straight away; the next one
+    // is held again until forced out
+    CHECK(!repeats.admit("loop\n", 0, 0, start + 9001 * MS, summary));
+    CHECK(summary.count == 1);
+    CHECK(!repeats.admit("loop\n", 0, 0, start + 9002 * MS, summary));
+    CHECK(summary.count == 0);
+    CHECK(repeats.flush(start + 9002 * MS, summary, true) && summary.count == 1);
+
+    // Timestamps from before the last report never report early
+    CHECK(!repeats.admit("loop\n", 0, 0, start + 9000 * MS, summary));
+    CHECK(summary.count == 0);
+}
+
+static void testDisabled() {
+    RepeatCollapser repeats;
+    RepeatSummary summary;
+    for (int i = 0; i < 10; i++) {
+        CHECK(repeats.admit("same\n", 0, 0, i * MS, summary));
+        CHECK(summary.count == 0);
+    }
+    CHECK(!repeats.flush(UINT64_MAX / 2, summary, true));
+
+    repeats.setWindow(MS);
+    CHECK(repeats.admit("same\n", 0, 0, 20 * MS, summary));
+    CHECK(!repeats.admit("same\n", 0, 0, 20 * MS, summary));
+    repeats.reset();
+    CHECK(repeats.admit("same\n", 0, 0, 20 * MS, summary) && summary.count == 0);
+}
+
+static void testHash() {
+    // Every length around the word size, and a change in any byte
+    std::string base = "L 10/19/2026 - 12:00:00: Run time error 4: index out of bounds";
+    for (size_t len = 0; len <= base.size(); len++) {
+        std::string a = base.substr(0, len);
+        CHECK(RepeatCollapser::hashLine(a) == RepeatCollapser::hashLine(std::string(a)));
+        if (len > 0) {
+            CHECK(RepeatCollapser::hashLine(a) != RepeatCollapser::hashLine(base.substr(0, len - 1)));
+        }
+        for (size_t i = 0; i < len; i++) {
+            std::string b = a;
+            b[i] ^= 1;
+            CHECK(RepeatCollapser::hashLine(a) != RepeatCollapser::hashLine(b));
+        }
+    }
+    CHECK(RepeatCollapser::hashLine(std::string_view("a\0", 2)) != RepeatCollapser::hashLine("a"));
+}
+
+int main() {
+    testRuns();
+    testColors();
+    testWindow();
+    testDisabled();
+    testHash();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All line repeat tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,598 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "vconsole_protocol.hpp"
+#include "server_status.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+struct ParsedFrame {
+    std::string type;
+    size_t length;
+    int32_t channelId;
+    uint32_t color;
+    std::string text;
+    uint64_t traceNanos;
+};
+
+// Walks a byte stream the way a client does: header, then length - 12 bytes
+static bool parseFrames(const std::vector<uint8_t>& buf, std::vector<ParsedFrame>& frames) {
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        if (buf.size() - pos < sizeof(VConChunk)) {
+            return false;
+        }
+        VConChunk header;
+        memcpy(&header, buf.data() + pos, sizeof(header));
+        size_t length = ntohs(header.length);
+        if (length < sizeof(VConChunk) || pos + length > buf.size()) {
+            return false;
+        }
+
+        ParsedFrame frame;
+        frame.type.assign(header.type, 4);
+        frame.length = length;
+        const uint8_t* payload = buf.data() + pos + sizeof(VConChunk);
+        size_t payloadLen = length - sizeof(VConChunk);
+        frame.traceNanos = 0;
+        if (frame.type == "PRNT") {
+            if (payloadLen < VCON_PRNT_HEADER_SIZE + 1) {
+                return false;
+            }
+            uint32_t v;
+            memcpy(&v, payload, 4);
+            frame.channelId = static_cast<int32_t>(ntohl(v));
+            memcpy(&v, payload + 12, 4);
+            frame.color = ntohl(v);
+
+            const char* text = reinterpret_cast<const char*>(payload) + VCON_PRNT_HEADER_SIZE;
+            const char* end = static_cast<const char*>(memchr(text, 0, payloadLen - VCON_PRNT_HEADER_SIZE));
+            if (!end) {
+                return false;
+            }
+            frame.text.assign(text, end);
+
+            size_t extra = payloadLen - VCON_PRNT_HEADER_SIZE - frame.text.size() - 1;
+            if (extra == VCON_TRACE_TRAILER_SIZE && memcmp(end + 1, VCON_TRACE_MAGIC, 4) == 0) {
+                uint32_t hi, lo;
+                memcpy(&hi, end + 5, 4);
+                memcpy(&lo, end + 9, 4);
+                frame.traceNanos = (static_cast<uint64_t>(ntohl(hi)) << 32) | ntohl(lo);
+            } else if (extra != 0) {
+                return false;
+            }
+        }
+        frames.push_back(frame);
+        pos += length;
+    }
+    return true;
+}
+
+static std::string joinText(const std::vector<ParsedFrame>& frames) {
+    std::string out;
+    for (const auto& f : frames) {
+        out += f.text;
+    }
+    return out;
+}
+
+static void testSmallMessage() {
+    std::vector<uint8_t> buf;
+    CHECK(appendPRNTFrames(buf, "hello\n", 3, 0xFFFF0000) == 1);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == 1);
+    CHECK(frames[0].length == sizeof(VConChunk) + VCON_PRNT_HEADER_SIZE + 7);
+    CHECK(frames[0].channelId == 3);
+    CHECK(frames[0].color == 0xFFFF0000);
+    CHECK(frames[0].text == "hello\n");
+}
+
+static void testExactFrameLimit() {
+    std::string msg(VCON_MAX_PRNT_TEXT, 'a');
+    std::vector<uint8_t> buf;
+    CHECK(appendPRNTFrames(buf, msg, 0, 0xFFFFFFFF) == 1);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == 1);
+    CHECK(frames[0].length == 65535);
+    CHECK(frames[0].text == msg);
+}
+
+static void testOneByteOverLimit() {
+    std::string msg(VCON_MAX_PRNT_TEXT + 1, 'b');
+    std::vector<uint8_t> buf;
+    CHECK(appendPRNTFrames(buf, msg, 0, 0xFFFFFFFF) == 2);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == 2);
+    CHECK(frames[0].length == 65535);
+    CHECK(frames[1].text == "b");
+    CHECK(joinText(frames) == msg);
+}
+
+static void testLargeMessage() {
+    std::string msg;
+    for (int i = 0; msg.size() < 300000; i++) {
+        msg += "line " + std::to_string(i) + " of a very large plugin dump\n";
+    }
+
+    std::vector<uint8_t> buf;
+    size_t count = appendPRNTFrames(buf, msg, 0, 0xFFFFFFFF);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == count);
+    CHECK(count == (msg.size() + VCON_MAX_PRNT_TEXT - 1) / VCON_MAX_PRNT_TEXT);
+    for (const auto& f : frames) {
+        CHECK(f.type == "PRNT");
+        CHECK(f.length <= 65535);
+    }
+    CHECK(joinText(frames) == msg);
+}
+
+static void testUtf8Boundary() {
+    // A 3-byte character straddling the limit must move whole into frame 2
+    const char euro[] = "\xE2\x82\xAC";
+    std::string msg(VCON_MAX_PRNT_TEXT - 1, 'c');
+    msg += euro;
+    msg += "tail";
+
+    std::vector<uint8_t> buf;
+    CHECK(appendPRNTFrames(buf, msg, 0, 0xFFFFFFFF) == 2);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == 2);
+    CHECK(frames[0].text.size() == VCON_MAX_PRNT_TEXT - 1);
+    CHECK(frames[1].text == std::string(euro) + "tail");
+    CHECK(joinText(frames) == msg);
+
+    // A 4-byte character ending exactly at the limit stays in frame 1
+    std::string exact(VCON_MAX_PRNT_TEXT - 4, 'd');
+    exact += "\xF0\x9F\x98\x80";
+    exact += "x";
+    CHECK(utf8SplitPoint(exact.data(), exact.size(), VCON_MAX_PRNT_TEXT) == VCON_MAX_PRNT_TEXT);
+
+    // Continuation bytes with no lead byte fall back to a hard cut
+    std::string junk(16, '\x80');
+    CHECK(utf8SplitPoint(junk.data(), junk.size(), 8) == 8);
+}
+
+static void testOversizedRawFrame() {
+    std::vector<uint8_t> buf;
+    std::vector<uint8_t> payload(VCON_MAX_PAYLOAD_SIZE, 0);
+    CHECK(appendFrame(buf, "AINF", payload.data(), payload.size()));
+    CHECK(buf.size() == 65535);
+
+    payload.push_back(0);
+    CHECK(!appendFrame(buf, "AINF", payload.data(), payload.size()));
+    CHECK(buf.size() == 65535);
+}
+
+static void testTraceTrailer() {
+    const uint64_t stamp = 0x0123456789ABCDEFull;
+    std::vector<uint8_t> buf;
+    CHECK(appendPRNTFrames(buf, "traced\n", 0, 0xFFFFFFFF, stamp) == 1);
+
+    std::vector<ParsedFrame> frames;
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames.size() == 1);
+    CHECK(frames[0].text == "traced\n");
+    CHECK(frames[0].traceNanos == stamp);
+
+    // The trailer eats into the text budget so traced frames stay in range
+    std::string msg(VCON_MAX_PRNT_TEXT, 'e');
+    buf.clear();
+    frames.clear();
+    CHECK(appendPRNTFrames(buf, msg, 0, 0xFFFFFFFF, stamp) == 2);
+    CHECK(parseFrames(buf, frames));
+    CHECK(frames[0].length == 65535);
+    CHECK(frames[1].traceNanos == stamp);
+    CHECK(joinText(frames) == msg);
+}
+
+static void testFramesBound() {
+    // Worst case for the bound: multi-byte characters at every cut
+    std::string msg;
+    while (msg.size() < 400000) {
+        msg += "\xE2\x82\xAC";
+    }
+
+    for (bool traced : {false, true}) {
+        std::vector<uint8_t> buf(prntFramesBound(msg.size(), traced));
+        size_t frames = 0;
+        size_t written = encodePRNTFrames(buf.data(), msg, 0, 0xFFFFFFFF, traced ? 1 : 0, &frames);
+        CHECK(written <= buf.size());
+
+        buf.resize(written);
+        std::vector<ParsedFrame> parsed;
+        CHECK(parseFrames(buf, parsed));
+        CHECK(parsed.size() == frames);
+        CHECK(joinText(parsed) == msg);
+    }
+
+    std::vector<uint8_t> empty(prntFramesBound(0, false));
+    CHECK(encodePRNTFrames(empty.data(), "", 0, 0xFFFFFFFF) == empty.size());
+}
+
+static std::vector<uint8_t> cmndFrame(const std::string& command) {
+    std::vector<uint8_t> frame;
+    appendFrame(frame, "CMND", reinterpret_cast<const uint8_t*>(command.c_str()), command.size() + 1);
+    return frame;
+}
+
+// Frames come out whole however the stream is cut into reads
+static void testSplitFrames() {
+    std::vector<uint8_t> stream = cmndFrame("status");
+    std::vector<uint8_t> second = cmndFrame("say hi");
+    stream.insert(stream.end(), second.begin(), second.end());
+    appendSUBSFrame(stream, VCON_TOPIC_STATUS);
+
+    for (size_t step = 1; step <= stream.size(); step++) {
+        std::vector<uint8_t> partial;
+        std::vector<std::string> seen;
+        for (size_t pos = 0; pos < stream.size(); pos += step) {
+            size_t n = std::min(step, stream.size() - pos);
+            CHECK(splitFrames(partial, stream.data() + pos, n, [&](const uint8_t* frame, const VConFrameHeader& h) {
+                std::string type(h.type, 4);
+                if (h.is("CMND")) {
+                    type += ":" + std::string(reinterpret_cast<const char*>(frame) + sizeof(VConChunk));
+                }
+                seen.push_back(type);
+            }));
+        }
+        CHECK(partial.empty());
+        CHECK(seen.size() == 3);
+        CHECK(seen.size() == 3 && seen[0] == "CMND:status" && seen[1] == "CMND:say hi" && seen[2] == "SUBS");
+    }
+
+    // A length shorter than the header cannot be skipped over
+    std::vector<uint8_t> bad = cmndFrame("status");
+    putBE16(bad.data() + offsetof(VConChunk, length), 4);
+    std::vector<uint8_t> partial;
+    size_t frames = 0;
+    CHECK(!splitFrames(partial, bad.data(), bad.size(), [&](const uint8_t*, const VConFrameHeader&) { frames++; }));
+    CHECK(frames == 0 && partial.empty());
+}
+
+// A line in several colors: one frame per stretch, text intact
+static void testColorRuns() {
+    const std::string msg = "[AMXX] Error: plugin failed\n";
+    std::vector<ColorRun> runs = {{7, 0xFFFF0000}, {12, 0xFFFFFFFF}, {27, 0xFF00FF00}};
+    std::vector<uint8_t> buf(prntRunsBound(msg.size(), runs.size(), false));
+    size_t frames = 0;
+    buf.resize(encodePRNTRuns(buf.data(), msg, 2, 0xFFFFFF00, runs, 0, &frames));
+
+    std::vector<ParsedFrame> parsed;
+    CHECK(parseFrames(buf, parsed));
+    CHECK(frames == 4 && parsed.size() == 4);
+    CHECK(joinText(parsed) == msg);
+    if (parsed.size() == 4) {
+        CHECK(parsed[0].text == "[AMXX] " && parsed[0].color == 0xFFFFFF00 && parsed[0].channelId == 2);
+        CHECK(parsed[1].text == "Error" && parsed[1].color == 0xFFFF0000);
+        CHECK(parsed[2].text == ": plugin failed" && parsed[2].color == 0xFFFFFFFF);
+        CHECK(parsed[3].text == "\n" && parsed[3].color == 0xFF00FF00);
+    }
+
+    // No runs is the plain encoding; runs past the end are ignored
+    std::vector<uint8_t> plain;
+    appendPRNTFrames(plain, msg, 2, 0xFFFFFF00);
+    buf.assign(prntRunsBound(msg.size(), 0, false), 0);
+    buf.resize(encodePRNTRuns(buf.data(), msg, 2, 0xFFFFFF00, {}));
+    CHECK(buf == plain);
+
+    std::vector<ColorRun> past = {{100, 0xFFFF0000}};
+    buf.assign(prntRunsBound(msg.size(), past.size(), false), 0);
+    buf.resize(encodePRNTRuns(buf.data(), msg, 2, 0xFFFFFF00, past));
+    CHECK(buf == plain);
+}
+
+// Reference encoders in the original style (struct header, htonl temporaries,
+// vector inserts); the typed builders must match them byte for byte
+static void legacyPacket(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& payload) {
+    VConChunk header;
+    memcpy(header.type, type, 4);
+    header.version = htonl(VCON_PROTOCOL_VERSION);
+    header.length = htons(static_cast<uint16_t>(sizeof(VConChunk) + payload.size()));
+    header.handle = htons(0);
+    out.insert(out.end(), reinterpret_cast<uint8_t*>(&header), reinterpret_cast<uint8_t*>(&header) + sizeof(header));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+template <typename T>
+static void legacyPut(std::vector<uint8_t>& payload, T value) {
+    payload.insert(payload.end(), reinterpret_cast<uint8_t*>(&value), reinterpret_cast<uint8_t*>(&value) + sizeof(T));
+}
+
+static std::vector<uint8_t> legacyAINF() {
+    std::vector<uint8_t> out;
+    legacyPacket(out, "AINF", std::vector<uint8_t>(77, 0));
+    return out;
+}
+
+static std::vector<uint8_t> legacyADON(const std::string& name) {
+    std::vector<uint8_t> payload;
+    legacyPut(payload, htons(0));
+    legacyPut(payload, htons(static_cast<uint16_t>(name.length())));
+    payload.insert(payload.end(), name.begin(), name.end());
+
+    std::vector<uint8_t> out;
+    legacyPacket(out, "ADON", payload);
+    return out;
+}
+
+static std::vector<uint8_t> legacyCHAN() {
+    std::vector<uint8_t> payload;
+    legacyPut(payload, htons(CHANNEL_COUNT));
+    for (const ConsoleChannel& channel : VCON_CHANNELS) {
+        legacyPut(payload, htonl(channel.id));
+        legacyPut(payload, htonl(0));
+        legacyPut(payload, htonl(0));
+        legacyPut(payload, htonl(1));
+        legacyPut(payload, htonl(1));
+        legacyPut(payload, htonl(channel.color));
+        char name[34] = {};
+        strncpy(name, channel.name, sizeof(name) - 1);
+        payload.insert(payload.end(), name, name + 34);
+    }
+
+    std::vector<uint8_t> out;
+    legacyPacket(out, "CHAN", payload);
+    return out;
+}
+
+static std::vector<uint8_t> legacyPRNT(const std::string& message, int32_t channelId, uint32_t color) {
+    std::vector<uint8_t> payload(VCON_PRNT_HEADER_SIZE, 0);
+    int32_t chanId = htonl(channelId);
+    uint32_t col = htonl(color);
+    memcpy(payload.data(), &chanId, 4);
+    memcpy(payload.data() + 12, &col, 4);
+    payload.insert(payload.end(), message.begin(), message.end());
+    payload.push_back(0);
+
+    std::vector<uint8_t> out;
+    legacyPacket(out, "PRNT", payload);
+    return out;
+}
+
+// Compile-time frames: the header length must cover the whole array
+static_assert(VCON_AINF_FRAME.size() == 12 + 77, "AINF frame size");
+static_assert(getBE16(VCON_AINF_FRAME.data() + 8) == VCON_AINF_FRAME.size(), "AINF length field");
+static_assert(getBE16(VCON_CHAN_FRAME.data() + 8) == VCON_CHAN_FRAME.size(), "CHAN length field");
+static_assert(getBE16(VCON_CHAN_FRAME.data() + 12) == CHANNEL_COUNT, "CHAN channel count");
+
+static void testConstantFrames() {
+    std::vector<uint8_t> ainf(VCON_AINF_FRAME.begin(), VCON_AINF_FRAME.end());
+    CHECK(ainf == legacyAINF());
+
+    std::vector<uint8_t> chan(VCON_CHAN_FRAME.begin(), VCON_CHAN_FRAME.end());
+    CHECK(chan == legacyCHAN());
+}
+
+static void testADONFrame() {
+    for (const std::string& name : {std::string("HLDS"), std::string(), std::string(300, 'x')}) {
+        std::vector<uint8_t> buf(adonFrameSize(name.size()));
+        CHECK(encodeADONFrame(buf.data(), name) == buf.size());
+        CHECK(buf == legacyADON(name));
+    }
+
+    std::string tooLong(VCON_MAX_PAYLOAD_SIZE, 'x');
+    std::vector<uint8_t> buf(adonFrameSize(tooLong.size()));
+    CHECK(encodeADONFrame(buf.data(), tooLong) == 0);
+}
+
+static void testPRNTMatchesLegacy() {
+    const std::string messages[] = {"", "hello\n", "\xE2\x82\xAC multi-byte", std::string(VCON_MAX_PRNT_TEXT, 'a')};
+    for (const std::string& msg : messages) {
+        std::vector<uint8_t> buf;
+        CHECK(appendPRNTFrames(buf, msg, CHANNEL_WARNING, 0xFFFFFF00) == 1);
+        CHECK(buf == legacyPRNT(msg, CHANNEL_WARNING, 0xFFFFFF00));
+    }
+}
+
+static void testReadFrameHeader() {
+    std::vector<uint8_t> buf = legacyADON("HLDS");
+    VConFrameHeader header;
+    CHECK(readFrameHeader(buf.data(), buf.size(), header));
+    CHECK(header.is("ADON"));
+    CHECK(header.length == buf.size());
+    CHECK(!readFrameHeader(buf.data(), sizeof(VConChunk) - 1, header));
+
+    // A length field smaller than the header itself is malformed
+    buf[8] = 0;
+    buf[9] = 4;
+    CHECK(!readFrameHeader(buf.data(), buf.size(), header));
+}
+
+static void testChannelMask() {
+    uint32_t mask = 0;
+    CHECK(parseChannelMask("all", mask) && mask == VCON_CHANNELS_ALL);
+    CHECK(parseChannelMask("Console", mask) && mask == (1u << CHANNEL_CONSOLE));
+    CHECK(parseChannelMask(" warning, ERROR ,log", mask));
+    CHECK(mask == ((1u << CHANNEL_WARNING) | (1u << CHANNEL_ERROR) | (1u << CHANNEL_LOG)));
+
+    // A bad list leaves the mask alone
+    CHECK(!parseChannelMask("console,chat", mask));
+    CHECK(!parseChannelMask("", mask));
+    CHECK(!parseChannelMask("console,", mask));
+    CHECK(mask == ((1u << CHANNEL_WARNING) | (1u << CHANNEL_ERROR) | (1u << CHANNEL_LOG)));
+
+    CHECK(channelAllowed(mask, CHANNEL_ERROR));
+    CHECK(!channelAllowed(mask, CHANNEL_CONSOLE));
+    CHECK(!channelAllowed(mask, CHANNEL_DEVELOPER));
+    CHECK(channelAllowed(mask, -3));
+    CHECK(channelAllowed(mask, CHANNEL_COUNT));
+}
+
+static StatusPlayer statusPlayer(uint8_t slot, int32_t userId, uint16_t ping, int32_t frags, const char* name) {
+    return StatusPlayer{slot, userId, ping, frags, name, "STEAM_0:1:" + std::to_string(userId)};
+}
+
+static bool sameStatus(const ServerStatus& a, const ServerStatus& b) {
+    if (a.map != b.map || a.maxPlayers != b.maxPlayers || a.players.size() != b.players.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.players.size(); i++) {
+        const StatusPlayer& p = a.players[i];
+        const StatusPlayer& q = b.players[i];
+        if (p.slot != q.slot || p.userId != q.userId || p.ping != q.ping || p.frags != q.frags ||
+            p.name != q.name || p.authId != q.authId) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies a whole STAT frame as a client would, after checking its header
+static StatusApplyResult applyStatFrame(const std::vector<uint8_t>& frame, ServerStatus& status, uint32_t& seq) {
+    VConFrameHeader header;
+    if (!readFrameHeader(frame.data(), frame.size(), header) || !header.is("STAT") || header.length != frame.size()) {
+        return STATUS_MALFORMED;
+    }
+    return applyStatusPayload(frame.data() + sizeof(VConChunk), frame.size() - sizeof(VConChunk), status, seq);
+}
+
+static ServerStatus sampleStatus() {
+    ServerStatus status;
+    status.map = "crossfire";
+    status.maxPlayers = 16;
+    status.players.push_back(statusPlayer(1, 2, 35, 4, "alice"));
+    status.players.push_back(statusPlayer(3, 5, 80, -1, "bob"));
+    status.players.push_back(statusPlayer(7, 9, 12, 10, "carol"));
+    return status;
+}
+
+static void testStatusFullSnapshot() {
+    ServerStatus status = sampleStatus();
+    std::vector<uint8_t> frame;
+    CHECK(encodeStatusFull(frame, status, 42));
+
+    ServerStatus decoded;
+    uint32_t seq = 0;
+    CHECK(applyStatFrame(frame, decoded, seq) == STATUS_APPLIED);
+    CHECK(seq == 42);
+    CHECK(sameStatus(decoded, status));
+
+    // An empty server still produces a snapshot with the map
+    ServerStatus empty;
+    empty.map = "datacore";
+    empty.maxPlayers = 8;
+    CHECK(encodeStatusFull(frame, empty, 1));
+    CHECK(applyStatFrame(frame, decoded, seq) == STATUS_APPLIED);
+    CHECK(sameStatus(decoded, empty));
+}
+
+static void testStatusDelta() {
+    ServerStatus prev = sampleStatus();
+    ServerStatus cur = prev;
+    cur.players[0].ping = 40;                              // alice: ping only
+    cur.players.erase(cur.players.begin() + 1);            // bob left slot 3
+    cur.players[1] = statusPlayer(7, 11, 60, 0, "dave");   // slot 7 reused
+    cur.players.push_back(statusPlayer(9, 12, 20, 0, "erin"));
+
+    std::vector<uint8_t> full;
+    std::vector<uint8_t> delta;
+    CHECK(encodeStatusFull(full, cur, 8));
+    CHECK(encodeStatusDelta(delta, prev, cur, 8));
+    CHECK(delta.size() < full.size());
+
+    ServerStatus client = prev;
+    uint32_t seq = 7;
+    CHECK(applyStatFrame(delta, client, seq) == STATUS_APPLIED);
+    CHECK(seq == 8);
+    CHECK(sameStatus(client, cur));
+
+    // A map change is carried in the delta even with the same players
+    ServerStatus changed = cur;
+    changed.map = "snark_pit";
+    CHECK(encodeStatusDelta(delta, cur, changed, 9));
+    CHECK(applyStatFrame(delta, client, seq) == STATUS_APPLIED);
+    CHECK(sameStatus(client, changed));
+
+    // Nothing changed: nothing to send
+    CHECK(!encodeStatusDelta(delta, changed, changed, 10));
+    CHECK(delta.empty());
+}
+
+static void testStatusGapAndMalformed() {
+    ServerStatus prev = sampleStatus();
+    ServerStatus cur = prev;
+    cur.players[2].frags = 11;
+
+    std::vector<uint8_t> delta;
+    CHECK(encodeStatusDelta(delta, prev, cur, 5));
+
+    // The client missed seq 4, so the delta must not be applied
+    ServerStatus client = prev;
+    uint32_t seq = 3;
+    CHECK(applyStatFrame(delta, client, seq) == STATUS_GAP);
+    CHECK(seq == 3);
+    CHECK(sameStatus(client, prev));
+
+    // Truncated payloads are rejected without touching the state
+    seq = 4;
+    for (size_t cut = 1; cut < delta.size() - sizeof(VConChunk); cut++) {
+        CHECK(applyStatusPayload(delta.data() + sizeof(VConChunk), cut, client, seq) == STATUS_MALFORMED);
+    }
+    CHECK(seq == 4);
+    CHECK(sameStatus(client, prev));
+}
+
+static void testSUBSFrame() {
+    std::vector<uint8_t> buf;
+    appendSUBSFrame(buf, VCON_TOPIC_STATUS);
+    VConFrameHeader header;
+    CHECK(readFrameHeader(buf.data(), buf.size(), header));
+    CHECK(header.is("SUBS"));
+    CHECK(header.length == sizeof(VConChunk) + 4);
+    CHECK(getBE32(buf.data() + sizeof(VConChunk)) == VCON_TOPIC_STATUS);
+
+    // Keepalive frames are a bare header
+    CHECK(readFrameHeader(VCON_PING_FRAME.data(), VCON_PING_FRAME.size(), header));
+    CHECK(header.is("PING") && header.length == sizeof(VConChunk));
+    CHECK(readFrameHeader(VCON_PONG_FRAME.data(), VCON_PONG_FRAME.size(), header));
+    CHECK(header.is("PONG") && header.length == sizeof(VConChunk));
+}
+
+int main() {
+    testSmallMessage();
+    testExactFrameLimit();
+    testOneByteOverLimit();
+    testLargeMessage();
+    testUtf8Boundary();
+    testOversizedRawFrame();
+    testTraceTrailer();
+    testFramesBound();
+    testColorRuns();
+    testConstantFrames();
+    testADONFrame();
+    testPRNTMatchesLegacy();
+    testReadFrameHeader();
+    testSplitFrames();
+    testChannelMask();
+    testStatusFullSnapshot();
+    testStatusDelta();
+    testStatusGapAndMalformed();
+    testSUBSFrame();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All protocol tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "shm_ring.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static std::string ringName() {
+    return "/vconsole_test_" + std::to_string(getpid());
+}
+
+static std::string lineText(uint64_t n, size_t padding) {
+    return "line " + std::to_string(n) + " " + std::string(padding, 'x');
+}
+
+static void testReadInOrder() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    CHECK(writer.getCapacity() == SHM_RING_MIN_CAPACITY);
+
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+
+    ShmRingLine line;
+    CHECK(reader.next(line) == SHM_READ_EMPTY);
+
+    writer.write(CAPTURE_ALERT, 3, 0xFF0000FF, 1234, "first");
+    writer.write(CAPTURE_STDOUT, 0, 0xFFFFFFFF, 5678, "second");
+
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.seq == 1);
+    CHECK(line.text == "first");
+    CHECK(line.source == CAPTURE_ALERT);
+    CHECK(line.channelId == 3);
+    CHECK(line.color == 0xFF0000FF);
+    CHECK(line.unixNanos == 1234);
+
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.seq == 2);
+    CHECK(line.text == "second");
+    CHECK(reader.next(line) == SHM_READ_EMPTY);
+    CHECK(reader.getLost() == 0);
+}
+
+// Keeping up through many wraps of the data area must never lose or tear a
+// line, including the padding records at the end of each pass
+static void testWrapAround() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+
+    ShmRingLine line;
+    uint64_t read = 0;
+    bool intact = true;
+    for (uint64_t n = 1; n <= 20000; n++) {
+        std::string text = lineText(n, n % 300);
+        writer.write(CAPTURE_PRINT, 0, 0, 0, text);
+        if (n % 7 == 0) {
+            while (reader.next(line) == SHM_READ_LINE) {
+                read++;
+                intact = intact && line.seq == read && line.text == lineText(read, read % 300);
+            }
+        }
+    }
+    while (reader.next(line) == SHM_READ_LINE) {
+        read++;
+        intact = intact && line.seq == read && line.text == lineText(read, read % 300);
+    }
+    CHECK(intact);
+    CHECK(read == 20000);
+    CHECK(reader.getLost() == 0);
+}
+
+static void testOverrun() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+
+    ShmRingLine line;
+    writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(1, 100));
+    CHECK(reader.next(line) == SHM_READ_LINE);
+
+    // Far more than the ring holds: the reader's position is reclaimed
+    for (uint64_t n = 2; n <= 5000; n++) {
+        writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(n, 100));
+    }
+    CHECK(reader.next(line) == SHM_READ_OVERRUN);
+    CHECK(reader.next(line) == SHM_READ_EMPTY);
+
+    // It resumes with the next line written and counts what it skipped
+    writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(5001, 100));
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.seq == 5001);
+    CHECK(line.text == lineText(5001, 100));
+    CHECK(reader.getLost() == 4999);
+}
+
+static void testFromStart() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    for (uint64_t n = 1; n <= 5000; n++) {
+        writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(n, 50));
+    }
+
+    ShmRingReader latest;
+    CHECK(latest.open(ringName()));
+    ShmRingLine line;
+    CHECK(latest.next(line) == SHM_READ_EMPTY);
+
+    // The oldest line still held is somewhere after the first, and the rest
+    // follow without gaps
+    ShmRingReader oldest;
+    CHECK(oldest.open(ringName(), true));
+    CHECK(oldest.next(line) == SHM_READ_LINE);
+    uint64_t first = line.seq;
+    CHECK(first > 1);
+    uint64_t count = 1;
+    while (oldest.next(line) == SHM_READ_LINE) {
+        count++;
+    }
+    CHECK(line.seq == 5000);
+    CHECK(count == 5000 - first + 1);
+    CHECK(oldest.getLost() == 0);
+}
+
+static void testLongLineTruncated() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+
+    std::string text(SHM_RING_MIN_CAPACITY, 'y');
+    writer.write(CAPTURE_STDERR, 0, 0, 0, text);
+
+    ShmRingLine line;
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.text.size() == SHM_RING_MIN_CAPACITY / 4 - sizeof(ShmRingRecord));
+    CHECK(line.text.find_first_not_of('y') == std::string::npos);
+}
+
+static void testWriterClose() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 100 * 1024));
+    CHECK(writer.getCapacity() == 128 * 1024);
+
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+    writer.write(CAPTURE_PRINT, 0, 0, 0, "last");
+    writer.notify();
+    CHECK(reader.wait(0));
+    CHECK(!reader.isWriterClosed());
+
+    writer.close();
+    CHECK(reader.isWriterClosed());
+
+    // Lines already written stay readable through the existing mapping
+    ShmRingLine line;
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.text == "last");
+
+    ShmRingReader late;
+    CHECK(!late.open(ringName()));
+}
+
+// Any process that can open the segment can write all of it; the writer
+// must keep going whatever it finds there
+static void testHostileReader() {
+    ShmRingWriter writer;
+    CHECK(writer.open(ringName(), 0));
+    for (uint64_t n = 1; n <= 100; n++) {
+        writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(n, 100));
+    }
+
+    int fd = shm_open(ringName().c_str(), O_RDWR, 0);
+    CHECK(fd != -1);
+    size_t size = SHM_RING_HEADER_SIZE + writer.getCapacity();
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(mapping != MAP_FAILED);
+    if (mapping == MAP_FAILED) {
+        return;
+    }
+    ShmRingHeader* header = static_cast<ShmRingHeader*>(mapping);
+    header->writePos.store(12345);
+    header->tailPos.store(3);
+    header->nextSeq.store(0);
+    memset(static_cast<uint8_t*>(mapping) + SHM_RING_HEADER_SIZE, 0, writer.getCapacity());
+
+    // Zeroed records under the tail used to spin the reclaim loop forever
+    for (uint64_t n = 101; n <= 5000; n++) {
+        writer.write(CAPTURE_PRINT, 0, 0, 0, lineText(n, 100));
+    }
+    CHECK(header->nextSeq.load() == 5001);
+
+    ShmRingReader reader;
+    CHECK(reader.open(ringName()));
+    writer.write(CAPTURE_PRINT, 0, 0, 0, "after");
+    ShmRingLine line;
+    CHECK(reader.next(line) == SHM_READ_LINE);
+    CHECK(line.seq == 5001 && line.text == "after");
+    munmap(mapping, size);
+}
+
+int main() {
+    testReadInOrder();
+    testWrapAround();
+    testOverrun();
+    testFromStart();
+    testLongLineTruncated();
+    testWriterClose();
+    testHostileReader();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All shared memory ring tests passed" << std::endl;
+    return 0;
+}
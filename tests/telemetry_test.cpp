@@ -0,0 +1,197 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "telemetry.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static bool within(uint32_t value, uint64_t expected, double tolerance) {
+    double diff = static_cast<double>(value) - static_cast<double>(expected);
+    return (diff < 0 ? -diff : diff) <= expected * tolerance;
+}
+
+static void testBuckets() {
+    // Values below 16 get a bucket each, the rest 16 per power of two
+    CHECK(FrameStat::bucketOf(0) == 0);
+    CHECK(FrameStat::bucketOf(15) == 15);
+    CHECK(FrameStat::bucketOf(16) == 16);
+    CHECK(FrameStat::bucketOf(31) == 31);
+    CHECK(FrameStat::bucketOf(32) == 32);
+    CHECK(FrameStat::bucketOf(UINT32_MAX) == FrameStat::BUCKETS - 1);
+
+    for (int i = 1; i < FrameStat::BUCKETS; i++) {
+        CHECK(FrameStat::bucketLower(i) > FrameStat::bucketLower(i - 1));
+        CHECK(FrameStat::bucketOf(static_cast<uint32_t>(FrameStat::bucketLower(i))) == i);
+        CHECK(FrameStat::bucketOf(static_cast<uint32_t>(FrameStat::bucketLower(i) - 1)) == i - 1);
+    }
+}
+
+static void testPercentiles() {
+    FrameStat stat;
+    TelemetryStats empty = stat.summarize();
+    CHECK(empty.min == 0 && empty.max == 0 && empty.p99 == 0);
+
+    // 1..10000 us in shuffled order
+    std::vector<uint64_t> samples;
+    for (uint64_t i = 1; i <= 10000; i++) {
+        samples.push_back(i * 1000);
+    }
+    srand(7);
+    for (size_t i = samples.size() - 1; i > 0; i--) {
+        std::swap(samples[i], samples[rand() % (i + 1)]);
+    }
+    for (uint64_t v : samples) {
+        stat.add(v);
+    }
+
+    TelemetryStats s = stat.summarize();
+    CHECK(stat.count() == 10000);
+    CHECK(s.min == 1000);
+    CHECK(s.max == 10000000);
+    CHECK(s.avg == 5000500);
+    CHECK(within(s.p50, 5000000, 0.04));
+    CHECK(within(s.p95, 9500000, 0.04));
+    CHECK(within(s.p99, 9900000, 0.04));
+
+    // A single sample is exact, and a hitch beyond 4.29s saturates
+    FrameStat one;
+    one.add(16666666);
+    TelemetryStats o = one.summarize();
+    CHECK(o.p50 == 16666666 && o.p99 == 16666666 && o.min == 16666666);
+    one.add(10000000000ull);
+    CHECK(one.summarize().max == UINT32_MAX);
+
+    stat.reset();
+    CHECK(stat.count() == 0);
+}
+
+static void testWindows() {
+    FrameTelemetry telemetry;
+    TelemetrySummary summary;
+    CHECK(!telemetry.takeReady(summary));
+    CHECK(telemetry.last(TELEMETRY_1S) == nullptr);
+
+    // 100 frames per second at 10ms, with a 50ms hitch in the second second
+    uint64_t t = 1000000000ull;
+    for (int i = 0; i < 100; i++) {
+        telemetry.frame(t, 20000);
+        t += 10000000;
+    }
+    CHECK(!telemetry.takeReady(summary));
+    telemetry.frame(t, 20000);
+    t += 50000000;
+    for (int i = 0; i < 95; i++) {
+        telemetry.frame(t, 30000);
+        t += 10000000;
+    }
+    telemetry.frame(t, 30000);
+
+    CHECK(telemetry.takeReady(summary));
+    CHECK(summary.window == TELEMETRY_1S);
+    CHECK(summary.seq == 1);
+    CHECK(summary.frames == 100);
+    CHECK(summary.durationMs == 1000);
+    CHECK(summary.tickRateCentiHz == 10000);
+    CHECK(summary.interval.min == 10000000 && summary.interval.max == 10000000);
+    CHECK(summary.jitter.max == 0);
+    CHECK(summary.cost.avg == 20000);
+    CHECK(summary.endUnixMs > 0);
+
+    CHECK(telemetry.takeReady(summary));
+    CHECK(summary.window == TELEMETRY_1S);
+    CHECK(summary.seq == 2);
+    CHECK(summary.frames == 96);
+    CHECK(summary.durationMs == 1000);
+    CHECK(summary.tickRateCentiHz == 9600);
+    CHECK(summary.interval.max == 50000000);
+    CHECK(summary.interval.p50 <= 10700000);
+    CHECK(summary.jitter.max == 40000000);
+    CHECK(!telemetry.takeReady(summary));
+
+    const TelemetrySummary* last = telemetry.last(TELEMETRY_1S);
+    CHECK(last && last->seq == 2);
+    CHECK(telemetry.last(TELEMETRY_10S) == nullptr);
+
+    // The 10s window closes on the first frame past 10s; an undrained
+    // queue keeps only the newest summaries
+    for (int i = 0; i < 900; i++) {
+        t += 10000000;
+        telemetry.frame(t, 20000);
+    }
+    const TelemetrySummary* ten = telemetry.last(TELEMETRY_10S);
+    CHECK(ten != nullptr);
+    CHECK(ten && ten->seq == 1 && ten->durationMs == 10000);
+    CHECK(ten && ten->frames == 996);
+    CHECK(ten && ten->interval.max == 50000000);
+
+    uint32_t drained = 0;
+    uint32_t lastSeq = 0;
+    while (telemetry.takeReady(summary)) {
+        if (summary.window == TELEMETRY_1S) {
+            CHECK(summary.seq > lastSeq);
+            lastSeq = summary.seq;
+        }
+        drained++;
+    }
+    CHECK(drained == 8);
+    CHECK(lastSeq == 11);
+}
+
+static void testFrameRoundTrip() {
+    TelemetrySummary s{};
+    s.window = TELEMETRY_10S;
+    s.seq = 0x01020304;
+    s.endUnixMs = 1760000000123ull;
+    s.durationMs = 10004;
+    s.frames = 9987;
+    s.tickRateCentiHz = 99830;
+    s.players = 17;
+    s.maxPlayers = 32;
+    s.interval = TelemetryStats{9000000, 10010000, 48000000, 10000000, 10400000, 13000000};
+    s.jitter = TelemetryStats{0, 120000, 38000000, 60000, 400000, 2900000};
+    s.cost = TelemetryStats{8000, 21000, 950000, 19000, 40000, 120000};
+
+    uint8_t frame[sizeof(VConChunk) + VCON_TELE_PAYLOAD_SIZE];
+    CHECK(encodeTELEFrame(frame, s) == sizeof(frame));
+
+    VConFrameHeader header;
+    CHECK(readFrameHeader(frame, sizeof(frame), header));
+    CHECK(header.is("TELE"));
+    CHECK(header.length == sizeof(frame));
+
+    TelemetrySummary d{};
+    CHECK(parseTELE(frame + sizeof(VConChunk), VCON_TELE_PAYLOAD_SIZE, d));
+    CHECK(d.window == s.window && d.seq == s.seq && d.endUnixMs == s.endUnixMs);
+    CHECK(d.durationMs == s.durationMs && d.frames == s.frames && d.tickRateCentiHz == s.tickRateCentiHz);
+    CHECK(d.players == 17 && d.maxPlayers == 32);
+    CHECK(d.interval.min == s.interval.min && d.interval.p99 == s.interval.p99);
+    CHECK(d.jitter.max == s.jitter.max && d.jitter.p95 == s.jitter.p95);
+    CHECK(d.cost.avg == s.cost.avg && d.cost.p50 == s.cost.p50);
+
+    CHECK(!parseTELE(frame + sizeof(VConChunk), VCON_TELE_PAYLOAD_SIZE - 1, d));
+    frame[sizeof(VConChunk)] = VCON_TELEMETRY_VERSION + 1;
+    CHECK(!parseTELE(frame + sizeof(VConChunk), VCON_TELE_PAYLOAD_SIZE, d));
+}
+
+int main() {
+    testBuckets();
+    testPercentiles();
+    testWindows();
+    testFrameRoundTrip();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All telemetry tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "timer_wheel.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+static const uint64_t MS = TimerWheel::TICK_NS;
+
+static void testBasics() {
+    uint64_t now = 5000 * MS + 123;
+    TimerWheel wheel(now);
+    std::vector<TimerEvent> fired;
+
+    TimerId a = wheel.schedule(now + 10 * MS, 1, 100);
+    TimerId b = wheel.schedule(now + 10 * MS, 2, 200);
+    TimerId c = wheel.schedule(now - 50 * MS, 3, 300);
+    CHECK(a != 0 && b != 0 && c != 0 && a != b);
+    CHECK(wheel.size() == 3 && wheel.armed(a));
+
+    // A deadline in the past fires on the next advance, never early
+    wheel.advance(now, fired);
+    CHECK(fired.empty());
+    wheel.advance(now + MS, fired);
+    CHECK(fired.size() == 1 && fired[0].kind == 3 && fired[0].key == 300);
+    CHECK(!wheel.armed(c));
+
+    CHECK(wheel.cancel(b));
+    CHECK(!wheel.cancel(b));
+    CHECK(!wheel.armed(b));
+
+    fired.clear();
+    wheel.advance(now + 9 * MS, fired);
+    CHECK(fired.empty());
+    wheel.advance(now + 10 * MS, fired);
+    CHECK(fired.empty());  // rounded up to the tick after the deadline
+    wheel.advance(now + 11 * MS, fired);
+    CHECK(fired.size() == 1 && fired[0].key == 100);
+    CHECK(wheel.size() == 0);
+
+    // A fired handle stays dead after its node is reused
+    TimerId d = wheel.schedule(now + 20 * MS, 4, 400);
+    CHECK(d != a && !wheel.cancel(a) && wheel.armed(d));
+    CHECK(!wheel.cancel(0) && !wheel.armed(0));
+
+    wheel.reset(now);
+    CHECK(wheel.size() == 0 && !wheel.armed(d));
+}
+
+// Random deadlines across every level and beyond the horizon, checked
+// against the time each should fire at
+static void testRandom() {
+    srand(11);
+    uint64_t now = 123456789ull * MS;
+    TimerWheel wheel(now);
+
+    struct Expect {
+        TimerId id;
+        uint64_t deadline;
+        bool cancelled;
+        bool fired;
+    };
+    std::vector<Expect> timers;
+    const uint64_t spans[] = {50, 4000, 250000, 20000000, 40000000};
+    for (uint64_t i = 0; i < 20000; i++) {
+        uint64_t span = spans[i % 5] * MS;
+        uint64_t deadline = now + (static_cast<uint64_t>(rand()) * 7919 + rand()) % span;
+        timers.push_back({wheel.schedule(deadline, 0, i), deadline, false, false});
+    }
+    for (size_t i = 0; i < timers.size(); i += 3) {
+        CHECK(wheel.cancel(timers[i].id));
+        timers[i].cancelled = true;
+    }
+
+    std::vector<TimerEvent> fired;
+    uint64_t end = now + 41000000ull * MS;
+    size_t firedCount = 0;
+    while (now < end) {
+        // Mostly frame-sized steps, with the odd long stall
+        now += (rand() % 100 == 0) ? (rand() % 3000000) * MS : (rand() % 50) * MS + rand() % MS;
+        fired.clear();
+        wheel.advance(now, fired);
+        for (const TimerEvent& ev : fired) {
+            Expect& t = timers[ev.key];
+            CHECK(!t.cancelled && !t.fired);
+            CHECK(t.deadline <= now);
+            t.fired = true;
+            firedCount++;
+        }
+        // Nothing due is left behind
+        for (const Expect& t : timers) {
+            if (!t.cancelled && !t.fired && t.deadline + MS <= now) {
+                CHECK(false);
+                break;
+            }
+        }
+    }
+    CHECK(firedCount == timers.size() - (timers.size() + 2) / 3);
+    CHECK(wheel.size() == 0);
+}
+
+int main() {
+    testBasics();
+    testRandom();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All timer wheel tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <chrono>
+#include "token_bucket.hpp"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+        g_failures++; \
+    } \
+} while (0)
+
+using Clock = TokenBucket::Clock;
+
+static Clock::time_point after(Clock::time_point t, int ms) {
+    return t + std::chrono::milliseconds(ms);
+}
+
+// Consumes until the bucket refuses; returns how many were taken
+static int drain(TokenBucket& bucket, Clock::time_point now) {
+    int taken = 0;
+    while (taken < 100000 && bucket.consume(now)) {
+        taken++;
+    }
+    return taken;
+}
+
+static void testDisabled() {
+    TokenBucket bucket;
+    CHECK(!bucket.enabled());
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < 10000; i++) {
+        CHECK(bucket.consume(t0));
+    }
+
+    // configure() with rate 0 turns limiting off whatever the burst
+    bucket.configure(0.0, 5.0);
+    CHECK(!bucket.enabled());
+    CHECK(drain(bucket, t0) == 100000);
+}
+
+static void testBurst() {
+    TokenBucket bucket;
+    bucket.configure(10.0, 5.0);
+    CHECK(bucket.enabled());
+    Clock::time_point t0 = bucket.last;
+
+    // Starts full, then refuses until time passes
+    CHECK(drain(bucket, t0) == 5);
+    CHECK(!bucket.consume(t0));
+
+    // A burst below one still lets a single token through
+    TokenBucket small;
+    small.configure(1.0, 0.0);
+    CHECK(small.burst == 1.0);
+    CHECK(drain(small, small.last) == 1);
+}
+
+static void testRefill() {
+    TokenBucket bucket;
+    bucket.configure(10.0, 5.0);
+    Clock::time_point t0 = bucket.last;
+    CHECK(drain(bucket, t0) == 5);
+
+    // 10/s is one token per 100ms; partial tokens carry over
+    CHECK(!bucket.consume(after(t0, 50)));
+    CHECK(bucket.consume(after(t0, 120)));
+    CHECK(!bucket.consume(after(t0, 120)));
+    CHECK(drain(bucket, after(t0, 370)) == 2);
+    CHECK(drain(bucket, after(t0, 410)) == 1);
+
+    // A long pause refills only up to the burst
+    CHECK(drain(bucket, after(t0, 60000)) == 5);
+}
+
+int main() {
+    testDisabled();
+    testBurst();
+    testRefill();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All token bucket tests passed" << std::endl;
+    return 0;
+}
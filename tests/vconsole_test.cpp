@@ -9,15 +9,20 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <poll.h>
-
-#pragma pack(push, 1)
-struct VConChunk {
-    char type[4];
-    uint32_t version;
-    uint16_t length;
-    uint16_t handle;
-};
-#pragma pack(pop)
+#include <time.h>
+#include "server_status.hpp"
+#include "console_index.hpp"
+#include "telemetry.hpp"
+
+// Latency trailer the server appends after the message terminator when
+// latency_debug is on: "VLAT" + big-endian CLOCK_MONOTONIC nanoseconds
+static const size_t TRACE_TRAILER_SIZE = 12;
+
+static uint64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
 
 struct Channel {
     int32_t id;
@@ -31,7 +36,7 @@ struct Channel {
 
 class VConsoleTest {
 public:
-    VConsoleTest() : m_socket(-1) {}
+    VConsoleTest() : m_socket(-1), m_showLatency(false) {}
     ~VConsoleTest() { disconnect(); }
 
     bool connect(const std::string& ip, int port) {
@@ -93,6 +98,105 @@ public:
         return true;
     }
 
+    bool sendSubscribe(uint32_t topics) {
+        m_topics = topics;
+        std::vector<uint8_t> frame;
+        appendSUBSFrame(frame, topics);
+        if (send(m_socket, frame.data(), frame.size(), 0) < 0) {
+            std::cerr << "Failed to send subscription: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool sendFrame(const std::vector<uint8_t>& frame) {
+        if (send(m_socket, frame.data(), frame.size(), 0) < 0) {
+            std::cerr << "Failed to send request: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void parseCMPR(const std::vector<char>& payload) {
+        uint32_t id = 0;
+        uint16_t total = 0;
+        std::vector<CompletionMatch> matches;
+        if (!::parseCMPR(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), id, total, matches)) {
+            std::cout << "  Malformed completion reply" << std::endl;
+            return;
+        }
+        std::cout << "  " << total << " match(es), showing " << matches.size() << std::endl;
+        for (const CompletionMatch& match : matches) {
+            std::cout << "    " << (match.kind == CONSOLE_CVAR ? "cvar " : "cmd  ") << match.name << std::endl;
+        }
+    }
+
+    void parseCVRS(const std::vector<char>& payload) {
+        uint32_t id = 0;
+        std::vector<CvarResult> results;
+        if (!::parseCVRS(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), id, results)) {
+            std::cout << "  Malformed cvar reply" << std::endl;
+            return;
+        }
+        for (const CvarResult& result : results) {
+            if (result.found) {
+                std::cout << "    " << result.name << " = \"" << result.value << "\"" << std::endl;
+            } else {
+                std::cout << "    " << result.name << " (no such cvar)" << std::endl;
+            }
+        }
+    }
+
+    // Applies a STAT frame to the local copy and prints the result. A gap in
+    // the sequence means a delta was missed, so a full snapshot is requested.
+    void parseSTAT(const std::vector<char>& payload) {
+        StatusApplyResult result = applyStatusPayload(reinterpret_cast<const uint8_t*>(payload.data()),
+                                                      payload.size(), m_status, m_statusSeq);
+        if (result == STATUS_GAP) {
+            std::cout << "  Status delta out of sequence, resubscribing" << std::endl;
+            sendSubscribe(m_topics);
+            return;
+        }
+        if (result == STATUS_MALFORMED) {
+            std::cout << "  Malformed status frame (" << payload.size() << " bytes)" << std::endl;
+            return;
+        }
+
+        std::cout << "  Status #" << m_statusSeq << " (" << (payload[1] == STATUS_FULL ? "full" : "delta") << ", "
+                  << payload.size() << " bytes): map " << m_status.map << ", " << m_status.players.size() << "/"
+                  << static_cast<int>(m_status.maxPlayers) << " players" << std::endl;
+        for (const StatusPlayer& player : m_status.players) {
+            char line[256];
+            snprintf(line, sizeof(line), "    #%-3d %-32s userid %-5d ping %-4u frags %-5d %s",
+                     player.slot, player.name.c_str(), player.userId, player.ping, player.frags,
+                     player.authId.c_str());
+            std::cout << line << std::endl;
+        }
+    }
+
+    void parseTELE(const std::vector<char>& payload) {
+        TelemetrySummary t;
+        if (!::parseTELE(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), t)) {
+            std::cout << "  Malformed telemetry frame (" << payload.size() << " bytes)" << std::endl;
+            return;
+        }
+        char line[256];
+        snprintf(line, sizeof(line), "  Telemetry %s #%u: %u frames in %ums, %.2f ticks/s, %u/%u players",
+                 t.window == TELEMETRY_1S ? "1s" : "10s", t.seq, t.frames, t.durationMs,
+                 t.tickRateCentiHz / 100.0, t.players, t.maxPlayers);
+        std::cout << line << std::endl;
+        printTelemetryStats("interval", t.interval);
+        printTelemetryStats("jitter", t.jitter);
+        printTelemetryStats("tick cost", t.cost);
+    }
+
+    static void printTelemetryStats(const char* name, const TelemetryStats& s) {
+        char line[256];
+        snprintf(line, sizeof(line), "    %-9s min %8.3fms avg %8.3fms max %8.3fms p50 %8.3fms p95 %8.3fms p99 %8.3fms",
+                 name, s.min / 1e6, s.avg / 1e6, s.max / 1e6, s.p50 / 1e6, s.p95 / 1e6, s.p99 / 1e6);
+        std::cout << line << std::endl;
+    }
+
     bool readPacket(std::string& msgType, std::vector<char>& payload, int timeoutMs = 5000) {
         struct pollfd pfd;
         pfd.fd = m_socket;
@@ -184,12 +288,27 @@ public:
         if (message.empty() || message.back() != '\n') {
             std::cout << std::endl;
         }
+
+        size_t trailerOffset = 28 + message.size() + 1;
+        if (m_showLatency && payload.size() == trailerOffset + TRACE_TRAILER_SIZE &&
+            memcmp(payload.data() + trailerOffset, "VLAT", 4) == 0) {
+            uint32_t hi = ntohl(*reinterpret_cast<const uint32_t*>(payload.data() + trailerOffset + 4));
+            uint32_t lo = ntohl(*reinterpret_cast<const uint32_t*>(payload.data() + trailerOffset + 8));
+            uint64_t ingest = (static_cast<uint64_t>(hi) << 32) | lo;
+            std::cout << "    latency: " << (monotonicNanos() - ingest) / 1000.0 << " us" << std::endl;
+        }
     }
 
+    void setShowLatency(bool enabled) { m_showLatency = enabled; }
+
     int getSocket() const { return m_socket; }
 
 private:
     int m_socket;
+    bool m_showLatency;
+    ServerStatus m_status;
+    uint32_t m_statusSeq = 0;
+    uint32_t m_topics = 0;
 };
 
 void printUsage(const char* prog) {
@@ -200,6 +319,13 @@ void printUsage(const char* prog) {
     std::cout << "  -c, --cmd <command> Command to send (can be repeated)" << std::endl;
     std::cout << "  -t, --timeout <ms>  Read timeout in ms (default: 5000)" << std::endl;
     std::cout << "  -l, --listen        Keep listening for messages" << std::endl;
+    std::cout << "  --batch             Send all commands in one send(), as a relay does" << std::endl;
+    std::cout << "  --latency           Print end-to-end latency (needs latency_debug on server)" << std::endl;
+    std::cout << "  --status            Subscribe to status snapshots and keep listening" << std::endl;
+    std::cout << "  --telemetry         Subscribe to frame timing windows and keep listening" << std::endl;
+    std::cout << "  --keepalive         Subscribe to keepalives, answer each PING and keep listening" << std::endl;
+    std::cout << "  --complete <prefix> List cvars and commands starting with prefix" << std::endl;
+    std::cout << "  --cvar <name>       Query a cvar's value (can be repeated, sent as one batch)" << std::endl;
     std::cout << "  --help              Show this help" << std::endl;
 }
 
@@ -209,6 +335,11 @@ int main(int argc, char* argv[]) {
     std::vector<std::string> commands;
     int timeout = 5000;
     bool keepListening = false;
+    bool batch = false;
+    bool showLatency = false;
+    uint32_t topics = 0;
+    std::vector<std::string> completions;
+    std::vector<std::string> cvars;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -222,6 +353,23 @@ int main(int argc, char* argv[]) {
             timeout = std::stoi(argv[++i]);
         } else if (arg == "-l" || arg == "--listen") {
             keepListening = true;
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--latency") {
+            showLatency = true;
+        } else if (arg == "--complete" && i + 1 < argc) {
+            completions.push_back(argv[++i]);
+        } else if (arg == "--cvar" && i + 1 < argc) {
+            cvars.push_back(argv[++i]);
+        } else if (arg == "--status") {
+            topics |= VCON_TOPIC_STATUS;
+            keepListening = true;
+        } else if (arg == "--telemetry") {
+            topics |= VCON_TOPIC_TELEMETRY;
+            keepListening = true;
+        } else if (arg == "--keepalive") {
+            topics |= VCON_TOPIC_KEEPALIVE;
+            keepListening = true;
         } else if (arg == "--help") {
             printUsage(argv[0]);
             return 0;
@@ -229,6 +377,7 @@ int main(int argc, char* argv[]) {
     }
 
     VConsoleTest client;
+    client.setShowLatency(showLatency);
 
     std::cout << "=== VConsole Test Client ===" << std::endl;
     std::cout << "Connecting to " << host << ":" << port << "..." << std::endl;
@@ -264,10 +413,69 @@ int main(int argc, char* argv[]) {
 
     std::cout << std::endl << "=== Handshake Complete ===" << std::endl;
 
-    if (commands.empty() && !keepListening) {
+    if (topics) {
+        std::cout << std::endl << "=== Subscribing ===" << std::endl;
+        if (!client.sendSubscribe(topics)) {
+            return 1;
+        }
+    }
+
+    // Console output arriving before the replies is skipped
+    uint32_t requestId = 1;
+    size_t expectedReplies = 0;
+    for (const auto& prefix : completions) {
+        std::vector<uint8_t> frame;
+        appendCMPLFrame(frame, requestId++, prefix, 50);
+        std::cout << std::endl << "=== Completing: " << prefix << " ===" << std::endl;
+        if (!client.sendFrame(frame)) {
+            return 1;
+        }
+        expectedReplies++;
+    }
+    if (!cvars.empty()) {
+        std::vector<uint8_t> frame;
+        appendCVRQFrame(frame, requestId++, cvars);
+        std::cout << std::endl << "=== Querying " << cvars.size() << " cvar(s) ===" << std::endl;
+        if (!client.sendFrame(frame)) {
+            return 1;
+        }
+        expectedReplies++;
+    }
+    while (expectedReplies > 0 && client.readPacket(msgType, payload, timeout)) {
+        if (msgType == "CMPR") {
+            client.parseCMPR(payload);
+            expectedReplies--;
+        } else if (msgType == "CVRS") {
+            client.parseCVRS(payload);
+            expectedReplies--;
+        }
+    }
+    bool queried = !completions.empty() || !cvars.empty();
+
+    if (commands.empty() && !keepListening && !queried) {
         commands.push_back("status");
     }
 
+    // Several frames in one segment; the server must run every command
+    if (batch && !commands.empty()) {
+        std::vector<uint8_t> frames;
+        for (const auto& cmd : commands) {
+            appendFrame(frames, "CMND", reinterpret_cast<const uint8_t*>(cmd.c_str()), cmd.size() + 1);
+        }
+        std::cout << std::endl << "=== Sending " << commands.size() << " Commands in One send() ===" << std::endl;
+        if (!client.sendFrame(frames)) {
+            return 1;
+        }
+
+        std::cout << std::endl << "=== Waiting for Responses ===" << std::endl;
+        while (client.readPacket(msgType, payload, timeout)) {
+            if (msgType == "PRNT") {
+                client.parsePRNT(payload);
+            }
+        }
+        commands.clear();
+    }
+
     for (const auto& cmd : commands) {
         std::cout << std::endl << "=== Sending Command: " << cmd << " ===" << std::endl;
         if (!client.sendCommand(cmd)) {
@@ -293,6 +501,15 @@ int main(int argc, char* argv[]) {
         while (client.readPacket(msgType, payload, -1)) {
             if (msgType == "PRNT") {
                 client.parsePRNT(payload);
+            } else if (msgType == "STAT") {
+                client.parseSTAT(payload);
+            } else if (msgType == "TELE") {
+                client.parseTELE(payload);
+            } else if (msgType == "PING") {
+                std::cout << "Received: PING, answering" << std::endl;
+                if (!client.sendFrame(std::vector<uint8_t>(VCON_PONG_FRAME.begin(), VCON_PONG_FRAME.end()))) {
+                    break;
+                }
             } else {
                 std::cout << "Received: " << msgType << " (" << payload.size() << " bytes)" << std::endl;
             }
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Compares the socket I/O backends on the same recording.
+# Usage: tools/bench_io.sh <recording> [clients] [loops] [replay binary]
+
+set -e
+
+RECORDING="$1"
+CLIENTS="${2:-4}"
+LOOPS="${3:-20}"
+REPLAY="${4:-build-x64/Debug/bin/vconsole-replay}"
+PORT=29100
+
+if [ -z "$RECORDING" ] || [ ! -x "$REPLAY" ]; then
+    echo "Usage: $0 <recording> [clients] [loops] [replay binary]"
+    echo "Build the vconsole-replay target first and record with vcon_record."
+    exit 1
+fi
+
+for backend in poll epoll io_uring; do
+    echo "=== $backend ($CLIENTS clients, $LOOPS passes, max speed) ==="
+    "$REPLAY" "$RECORDING" -p "$PORT" -m -n "$LOOPS" -c "$CLIENTS" --latency --io "$backend" |
+        grep -E "^Using|^Replayed|I/O backend|end to end|^Built-in"
+    PORT=$((PORT + 1))
+    echo
+done
@@ -0,0 +1,502 @@
+// Standalone fan-out relay: holds one VConsole connection to the plugin and
+// serves any number of downstream clients from its own VConsoleServer, so
+// viewers put no socket or encoding load on the game server. Downstream
+// clients get the relay's scrollback on connect and the usual per-client
+// backlog limit; commands are forwarded upstream unless --read-only.
+#include <extdll.h>
+#include "vconsole_server.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+
+enginefuncs_t g_engfuncs;
+
+static void printToStdout(const char* msg) {
+    fputs(msg, stdout);
+}
+
+static volatile sig_atomic_t g_stop = 0;
+static volatile sig_atomic_t g_dumpStats = 0;
+
+static void onStopSignal(int) { g_stop = 1; }
+static void onStatsSignal(int) { g_dumpStats = 1; }
+
+static const uint32_t RELAY_NOTICE_COLOR = 0xFF00FFFF;
+static const int RECONNECT_MIN_MS = 1000;
+static const int RECONNECT_MAX_MS = 30000;
+// A connect the host never answers is given up on after this long
+static const int CONNECT_TIMEOUT_MS = 5000;
+
+// Drops lines before they reach the relay's scrollback and clients. An empty
+// channel mask passes every channel.
+struct RelayFilter {
+    uint32_t channelMask = 0;
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+
+    bool pass(int32_t channelId, std::string_view text) const {
+        if (channelMask != 0 && (channelId < 0 || channelId >= CHANNEL_COUNT ||
+                                 !(channelMask & (1u << channelId)))) {
+            return false;
+        }
+        if (!include.empty() &&
+            std::none_of(include.begin(), include.end(),
+                         [&](const std::string& s) { return text.find(s) != std::string_view::npos; })) {
+            return false;
+        }
+        return std::none_of(exclude.begin(), exclude.end(),
+                            [&](const std::string& s) { return text.find(s) != std::string_view::npos; });
+    }
+};
+
+// The single connection to the plugin. Non-blocking, connect included, so
+// an unreachable host never holds up the viewers; frames are parsed out of
+// m_in as they complete and commands wait in m_out until the socket takes
+// them. The host is resolved once, on the first attempt that succeeds.
+class Upstream {
+public:
+    Upstream(const std::string& host, int port)
+        : m_host(host), m_port(port), m_addr{}, m_resolved(false), m_socket(INVALID_SOCKET), m_connected(false),
+          m_backoffMs(RECONNECT_MIN_MS), m_nextAttempt(0), m_connectDeadline(0), m_lines(0), m_filtered(0),
+          m_commands(0), m_reconnects(0) {}
+
+    ~Upstream() { disconnect(); }
+
+    bool connected() const { return m_connected; }
+    // A connect is in progress; the socket turns writable once it is done
+    bool connecting() const { return !m_connected && m_socket != INVALID_SOCKET; }
+    SOCKET socket() const { return m_socket; }
+    bool wantsWrite() const { return !m_out.empty(); }
+
+    // Starts a connect once the backoff has passed, and gives up on one
+    // that has taken too long
+    void connectIfDue(uint64_t nowNs);
+    void finishConnect(uint64_t nowNs);
+    void disconnect();
+    // Reads what is available and hands every complete PRNT line to the
+    // server. Returns false once the connection is lost.
+    bool read(VConsoleServer& server, const RelayFilter& filter);
+    bool flush();
+    bool queueCommand(const std::string& cmd);
+
+    void printStats() const;
+
+private:
+    void notice(const char* text);
+    bool resolve();
+    void established();
+    void retryLater(uint64_t nowNs);
+
+    std::string m_host;
+    int m_port;
+    sockaddr_in m_addr;
+    bool m_resolved;
+    SOCKET m_socket;
+    bool m_connected;
+    int m_backoffMs;
+    uint64_t m_nextAttempt;
+    uint64_t m_connectDeadline;
+    std::vector<uint8_t> m_in;
+    std::vector<uint8_t> m_out;
+    uint64_t m_lines;
+    uint64_t m_filtered;
+    uint64_t m_commands;
+    uint64_t m_reconnects;
+};
+
+void Upstream::notice(const char* text) {
+    VConsoleServer::getInstance().broadcastPrint(text, CHANNEL_NOTICE, RELAY_NOTICE_COLOR);
+    VConsoleServer::getInstance().logLocal(text);
+}
+
+bool Upstream::resolve() {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    std::string port = std::to_string(m_port);
+    if (getaddrinfo(m_host.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+    memcpy(&m_addr, result->ai_addr, sizeof(m_addr));
+    freeaddrinfo(result);
+    m_resolved = true;
+    return true;
+}
+
+void Upstream::connectIfDue(uint64_t nowNs) {
+    if (connecting()) {
+        if (nowNs >= m_connectDeadline) {
+            retryLater(nowNs);
+        }
+        return;
+    }
+    if (m_connected || nowNs < m_nextAttempt) {
+        return;
+    }
+    if (!m_resolved && !resolve()) {
+        retryLater(nowNs);
+        return;
+    }
+
+    m_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_socket == INVALID_SOCKET) {
+        retryLater(nowNs);
+        return;
+    }
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+    if (connect(m_socket, reinterpret_cast<const sockaddr*>(&m_addr), sizeof(m_addr)) == 0) {
+        established();
+    } else if (errno == EINPROGRESS) {
+        m_connectDeadline = nowNs + static_cast<uint64_t>(CONNECT_TIMEOUT_MS) * 1000000;
+    } else {
+        retryLater(nowNs);
+    }
+}
+
+void Upstream::finishConnect(uint64_t nowNs) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0) {
+        established();
+    } else {
+        retryLater(nowNs);
+    }
+}
+
+void Upstream::established() {
+    m_connected = true;
+    m_backoffMs = RECONNECT_MIN_MS;
+    m_in.clear();
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "[VConsole] Relay connected to %s:%d\n", m_host.c_str(), m_port);
+    notice(msg);
+}
+
+// A failed attempt; the next one waits out a growing backoff
+void Upstream::retryLater(uint64_t nowNs) {
+    if (m_socket != INVALID_SOCKET) {
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+    }
+    m_nextAttempt = nowNs + static_cast<uint64_t>(m_backoffMs) * 1000000;
+    m_backoffMs = std::min(m_backoffMs * 2, RECONNECT_MAX_MS);
+}
+
+void Upstream::disconnect() {
+    if (m_socket != INVALID_SOCKET) {
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+    }
+    if (m_connected) {
+        m_connected = false;
+        m_reconnects++;
+        m_out.clear();
+        m_nextAttempt = monotonicNanos() + static_cast<uint64_t>(m_backoffMs) * 1000000;
+
+        char msg[256];
+        snprintf(msg, sizeof(msg), "[VConsole] Relay lost %s:%d, reconnecting\n", m_host.c_str(), m_port);
+        notice(msg);
+    }
+}
+
+bool Upstream::read(VConsoleServer& server, const RelayFilter& filter) {
+    for (;;) {
+        size_t used = m_in.size();
+        m_in.resize(used + 64 * 1024);
+        ssize_t received = recv(m_socket, m_in.data() + used, 64 * 1024, 0);
+        if (received <= 0) {
+            m_in.resize(used);
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                return false;
+            }
+            break;
+        }
+        m_in.resize(used + received);
+    }
+
+    size_t offset = 0;
+    VConFrameHeader header;
+    while (readFrameHeader(m_in.data() + offset, m_in.size() - offset, header) &&
+           header.length <= m_in.size() - offset) {
+        const uint8_t* payload = m_in.data() + offset + sizeof(VConChunk);
+        size_t payloadLen = header.length - sizeof(VConChunk);
+
+        // AINF/ADON/CHAN describe the plugin; the relay sends its own
+        if (header.is("PRNT") && payloadLen > VCON_PRNT_HEADER_SIZE) {
+            int32_t channelId = static_cast<int32_t>(payload[0] << 24 | payload[1] << 16 |
+                                                     payload[2] << 8 | payload[3]);
+            uint32_t color = static_cast<uint32_t>(payload[12]) << 24 | payload[13] << 16 |
+                             payload[14] << 8 | payload[15];
+            const char* text = reinterpret_cast<const char*>(payload + VCON_PRNT_HEADER_SIZE);
+            std::string_view line(text, strnlen(text, payloadLen - VCON_PRNT_HEADER_SIZE));
+
+            m_lines++;
+            if (filter.pass(channelId, line)) {
+                server.broadcastPrint(line, channelId, color, monotonicNanos());
+            } else {
+                m_filtered++;
+            }
+        }
+        offset += header.length;
+    }
+
+    if (offset < m_in.size() && m_in.size() - offset >= sizeof(VConChunk) &&
+        !readFrameHeader(m_in.data() + offset, m_in.size() - offset, header)) {
+        return false;  // corrupt length field, resync by reconnecting
+    }
+    m_in.erase(m_in.begin(), m_in.begin() + offset);
+    return true;
+}
+
+bool Upstream::flush() {
+    while (!m_out.empty()) {
+        ssize_t sent = send(m_socket, m_out.data(), m_out.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        m_out.erase(m_out.begin(), m_out.begin() + sent);
+    }
+    return true;
+}
+
+bool Upstream::queueCommand(const std::string& cmd) {
+    if (!m_connected) {
+        return false;
+    }
+    std::string payload = cmd.substr(0, VCON_MAX_PAYLOAD_SIZE - 1);
+    appendFrame(m_out, "CMND", reinterpret_cast<const uint8_t*>(payload.c_str()), payload.size() + 1);
+    m_commands++;
+    return true;
+}
+
+void Upstream::printStats() const {
+    printf("[VConsole] Relay upstream %s:%d %s, %llu lines (%llu filtered), %llu commands forwarded, "
+           "%llu reconnects\n",
+           m_host.c_str(), m_port, m_connected ? "connected" : "down",
+           static_cast<unsigned long long>(m_lines), static_cast<unsigned long long>(m_filtered),
+           static_cast<unsigned long long>(m_commands), static_cast<unsigned long long>(m_reconnects));
+}
+
+static Upstream* g_upstream = nullptr;
+static bool g_readOnly = false;
+
+// Called by the server's tick() for commands that passed the per-client
+// rate limit
+void executeServerCommand(const std::string& cmd) {
+    const char* reason = nullptr;
+    if (g_readOnly) {
+        reason = "relay is read-only";
+    } else if (!g_upstream || !g_upstream->queueCommand(cmd)) {
+        reason = "upstream is not connected";
+    }
+    if (reason) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "[VConsole] Command not forwarded (%s): %s\n", reason, cmd.c_str());
+        VConsoleServer::getInstance().broadcastPrint(msg, CHANNEL_WARNING, 0xFFFF0000);
+    }
+}
+
+static bool parseHostPort(const std::string& value, std::string& host, int& port) {
+    size_t colon = value.rfind(':');
+    if (colon == std::string::npos) {
+        host = value;
+        return !host.empty();
+    }
+    host = value.substr(0, colon);
+    port = std::atoi(value.c_str() + colon + 1);
+    return !host.empty() && port > 0 && port <= 65535;
+}
+
+// Accepts channel names from the CHAN table or numeric ids, comma separated
+static bool parseChannels(const std::string& list, uint32_t& mask) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(start, end - start);
+        bool found = false;
+        for (const ConsoleChannel& channel : VCON_CHANNELS) {
+            if (strcasecmp(channel.name, name.c_str()) == 0 || name == std::to_string(channel.id)) {
+                mask |= 1u << channel.id;
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cerr << "Unknown channel " << name << std::endl;
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] --upstream <host:port>" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -u, --upstream <host:port>  Plugin to relay (default port: 29000)" << std::endl;
+    std::cout << "  -p, --port <port>           Listen port (default: 29001)" << std::endl;
+    std::cout << "  -b, --bind <ip>             Bind address (default: 0.0.0.0)" << std::endl;
+    std::cout << "  --max-clients <n>           Downstream client limit, 0 = unlimited (default: 0)" << std::endl;
+    std::cout << "  --scrollback <lines>        Lines replayed to new clients (default: 1000)" << std::endl;
+    std::cout << "  --channels <list>           Only relay these channels, by name or id" << std::endl;
+    std::cout << "  --include <text>            Only relay lines containing text (repeatable)" << std::endl;
+    std::cout << "  --exclude <text>            Drop lines containing text (repeatable)" << std::endl;
+    std::cout << "  --read-only                 Do not forward commands upstream" << std::endl;
+    std::cout << "  --cmd-rate <n>              Commands per second per client (default: 5)" << std::endl;
+    std::cout << "  --cmd-burst <n>             Command burst per client (default: 10)" << std::endl;
+    std::cout << "  --io <backend>              auto, io_uring, epoll or poll (default: auto)" << std::endl;
+    std::cout << "  --frame-us <us>             Longest wait between ticks (default: 10000)" << std::endl;
+    std::cout << "  --help                      Show this help" << std::endl;
+    std::cout << "Send SIGUSR1 to print statistics." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string upstreamHost;
+    int upstreamPort = 29000;
+    std::string bind = "0.0.0.0";
+    int port = 29001;
+    int maxClients = 0;
+    size_t scrollback = 1000;
+    RelayFilter filter;
+    double cmdRate = 5.0;
+    int cmdBurst = 10;
+    IoBackendType ioBackend = IO_BACKEND_AUTO;
+    int frameMs = 10;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-u" || arg == "--upstream") && i + 1 < argc) {
+            if (!parseHostPort(argv[++i], upstreamHost, upstreamPort)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if ((arg == "-b" || arg == "--bind") && i + 1 < argc) {
+            bind = argv[++i];
+        } else if (arg == "--max-clients" && i + 1 < argc) {
+            maxClients = std::stoi(argv[++i]);
+        } else if (arg == "--scrollback" && i + 1 < argc) {
+            scrollback = std::stoul(argv[++i]);
+        } else if (arg == "--channels" && i + 1 < argc) {
+            if (!parseChannels(argv[++i], filter.channelMask)) {
+                return 1;
+            }
+        } else if (arg == "--include" && i + 1 < argc) {
+            filter.include.push_back(argv[++i]);
+        } else if (arg == "--exclude" && i + 1 < argc) {
+            filter.exclude.push_back(argv[++i]);
+        } else if (arg == "--read-only") {
+            g_readOnly = true;
+        } else if (arg == "--cmd-rate" && i + 1 < argc) {
+            cmdRate = std::stod(argv[++i]);
+        } else if (arg == "--cmd-burst" && i + 1 < argc) {
+            cmdBurst = std::stoi(argv[++i]);
+        } else if (arg == "--io" && i + 1 < argc) {
+            if (!parseIoBackend(argv[++i], ioBackend)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--frame-us" && i + 1 < argc) {
+            frameMs = std::max(1, std::stoi(argv[++i]) / 1000);
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (upstreamHost.empty() || maxClients < 0 || cmdRate < 0.0 || cmdBurst < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    g_engfuncs.pfnServerPrint = printToStdout;
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    signal(SIGUSR1, onStatsSignal);
+
+    VConsoleServer& server = VConsoleServer::getInstance();
+    server.setOutputCapture(false);
+    server.setMaxConnections(maxClients);
+    server.setLogging(true);
+    server.setCommandRateLimit(cmdRate, cmdBurst);
+    server.setScrollback(scrollback);
+    server.setIoBackend(ioBackend);
+    if (!server.initialize(static_cast<uint16_t>(port), bind)) {
+        std::cerr << "Failed to listen on " << bind << ":" << port << std::endl;
+        return 1;
+    }
+    printf("Relaying %s:%d on %s:%d with %s I/O, %zu lines of scrollback%s\n", upstreamHost.c_str(),
+           upstreamPort, bind.c_str(), port, server.getIoBackendName(), scrollback,
+           g_readOnly ? ", read-only" : "");
+
+    Upstream upstream(upstreamHost, upstreamPort);
+    g_upstream = &upstream;
+
+    // The upstream socket sets the pace: the loop wakes when the plugin
+    // sends something and otherwise ticks the downstream side every frame
+    while (!g_stop) {
+        upstream.connectIfDue(monotonicNanos());
+
+        if (upstream.connecting()) {
+            pollfd pfd{};
+            pfd.fd = upstream.socket();
+            pfd.events = POLLOUT;
+            if (::poll(&pfd, 1, frameMs) > 0) {
+                upstream.finishConnect(monotonicNanos());
+            }
+        } else if (upstream.connected()) {
+            pollfd pfd{};
+            pfd.fd = upstream.socket();
+            pfd.events = POLLIN | (upstream.wantsWrite() ? POLLOUT : 0);
+            if (::poll(&pfd, 1, frameMs) > 0) {
+                bool alive = !(pfd.revents & (POLLERR | POLLNVAL));
+                if (alive && (pfd.revents & (POLLIN | POLLHUP))) {
+                    alive = upstream.read(server, filter);
+                }
+                if (alive && (pfd.revents & POLLOUT)) {
+                    alive = upstream.flush();
+                }
+                if (!alive) {
+                    upstream.disconnect();
+                }
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(frameMs));
+        }
+
+        server.tick();
+        if (upstream.connected() && upstream.wantsWrite() && !upstream.flush()) {
+            upstream.disconnect();
+        }
+
+        if (g_dumpStats) {
+            g_dumpStats = 0;
+            upstream.printStats();
+            server.printStats();
+        }
+    }
+
+    upstream.printStats();
+    server.printStats();
+    g_upstream = nullptr;
+    server.shutdown();
+    return 0;
+}
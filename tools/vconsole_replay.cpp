@@ -0,0 +1,252 @@
+// Standalone replay driver: feeds a vcon_record recording into VConsoleServer
+// outside the engine, so capture and broadcast changes can be compared
+// between builds on identical traffic.
+#include <extdll.h>
+#include "vconsole_server.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enginefuncs_t g_engfuncs;
+
+// Replayed commands from connected clients are only echoed
+void executeServerCommand(const std::string& cmd) {
+    printf("[replay] command: %s\n", cmd.c_str());
+}
+
+static void printToStdout(const char* msg) {
+    fputs(msg, stdout);
+}
+
+static void sleepNanos(uint64_t ns) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+
+// Built-in client that reads and discards everything until the server
+// closes the connection, so a bench needs no external consumers
+static void drainClient(std::string host, int port, std::atomic<uint64_t>* received) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    if (connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        std::vector<char> buf(64 * 1024);
+        ssize_t n;
+        while ((n = recv(s, buf.data(), buf.size(), 0)) > 0) {
+            received->fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        }
+    }
+    closesocket(s);
+}
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] <recording>" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -p, --port <port>     Listen port (default: 29000)" << std::endl;
+    std::cout << "  -b, --bind <ip>       Bind address (default: 127.0.0.1)" << std::endl;
+    std::cout << "  -s, --speed <factor>  Replay at factor x recorded speed (default: 1)" << std::endl;
+    std::cout << "  -m, --max             Replay as fast as possible" << std::endl;
+    std::cout << "  -w, --wait <clients>  Wait for this many clients before starting (default: 0)" << std::endl;
+    std::cout << "  -c, --clients <n>     Connect n built-in clients that discard output (default: 0)" << std::endl;
+    std::cout << "  --io <backend>        auto, io_uring, epoll or poll (default: auto)" << std::endl;
+    std::cout << "  -n, --loops <count>   Replay the recording count times (default: 1)" << std::endl;
+    std::cout << "  --frame-us <us>       Server frame interval for tick() (default: 1000)" << std::endl;
+    std::cout << "  --budget-us <us>      Plugin time budget per frame, 0 = unlimited (default: 0)" << std::endl;
+    std::cout << "  --latency             Append latency trailers to PRNT frames" << std::endl;
+    std::cout << "  --shm <name>          Also publish into a shared memory ring for vconsole-tail" << std::endl;
+    std::cout << "  --help                Show this help" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string bind = "127.0.0.1";
+    int port = 29000;
+    double speed = 1.0;
+    bool maxSpeed = false;
+    int waitClients = 0;
+    int clients = 0;
+    IoBackendType ioBackend = IO_BACKEND_AUTO;
+    int loops = 1;
+    uint64_t frameNs = 1000000;
+    uint32_t budgetUs = 0;
+    bool latency = false;
+    std::string shmRing;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if ((arg == "-b" || arg == "--bind") && i + 1 < argc) {
+            bind = argv[++i];
+        } else if ((arg == "-s" || arg == "--speed") && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        } else if (arg == "-m" || arg == "--max") {
+            maxSpeed = true;
+        } else if ((arg == "-w" || arg == "--wait") && i + 1 < argc) {
+            waitClients = std::stoi(argv[++i]);
+        } else if ((arg == "-c" || arg == "--clients") && i + 1 < argc) {
+            clients = std::stoi(argv[++i]);
+        } else if (arg == "--io" && i + 1 < argc) {
+            if (!parseIoBackend(argv[++i], ioBackend)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if ((arg == "-n" || arg == "--loops") && i + 1 < argc) {
+            loops = std::stoi(argv[++i]);
+        } else if (arg == "--frame-us" && i + 1 < argc) {
+            frameNs = static_cast<uint64_t>(std::stoul(argv[++i])) * 1000;
+        } else if (arg == "--budget-us" && i + 1 < argc) {
+            budgetUs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--latency") {
+            latency = true;
+        } else if (arg == "--shm" && i + 1 < argc) {
+            shmRing = argv[++i];
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (path.empty() || speed <= 0.0 || loops < 1 || frameNs == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Load everything up front so file I/O does not show up in the timings
+    std::vector<LogRecord> records;
+    uint64_t totalBytes = 0;
+    {
+        LogSinkReader reader;
+        if (!reader.open(path)) {
+            std::cerr << "Cannot read recording " << path << std::endl;
+            return 1;
+        }
+        LogRecord record;
+        while (reader.next(record)) {
+            totalBytes += record.line.size();
+            records.push_back(std::move(record));
+        }
+    }
+    if (records.empty()) {
+        std::cerr << "Recording " << path << " has no lines" << std::endl;
+        return 1;
+    }
+
+    uint64_t recordedNs = records.back().unixNanos - records.front().unixNanos;
+    printf("Loaded %zu lines (%llu bytes) spanning %.3f s\n", records.size(),
+           static_cast<unsigned long long>(totalBytes), recordedNs / 1e9);
+
+    g_engfuncs.pfnServerPrint = printToStdout;
+    signal(SIGPIPE, SIG_IGN);
+
+    VConsoleServer& server = VConsoleServer::getInstance();
+    server.setOutputCapture(false);
+    server.setMaxConnections(0);
+    server.setLogging(true);
+    server.setLatencyDebug(latency);
+    server.setIoBackend(ioBackend);
+    server.setTickBudget(budgetUs);
+    if (!server.initialize(static_cast<uint16_t>(port), bind)) {
+        std::cerr << "Failed to listen on " << bind << ":" << port << std::endl;
+        return 1;
+    }
+    printf("Using %s I/O\n", server.getIoBackendName());
+    if (!shmRing.empty() && !server.openShmRing(shmRing, 1024 * 1024)) {
+        std::cerr << "Failed to create shared memory ring " << shmRing << std::endl;
+        return 1;
+    }
+
+    std::atomic<uint64_t> drained(0);
+    std::vector<std::thread> drainers;
+    for (int i = 0; i < clients; i++) {
+        drainers.emplace_back(drainClient, bind == "0.0.0.0" ? "127.0.0.1" : bind, port, &drained);
+    }
+    waitClients = std::max(waitClients, clients);
+
+    if (waitClients > 0) {
+        printf("Waiting for %d client(s) on %s:%d\n", waitClients, bind.c_str(), port);
+        while (static_cast<int>(server.getClientCount()) < waitClients) {
+            server.tick();
+            sleepNanos(frameNs);
+        }
+    }
+
+    if (maxSpeed) {
+        printf("Replaying %d time(s) at max speed\n", loops);
+    } else {
+        printf("Replaying %d time(s) at %gx\n", loops, speed);
+    }
+
+    // Lines are injected as the server would see them between frames: every
+    // line due by the current frame is captured, then the frame is ticked.
+    // At max speed a frame is simply every 64 lines.
+    const size_t maxSpeedBatch = 64;
+    uint64_t start = monotonicNanos();
+    uint64_t ticks = 0;
+
+    for (int loop = 0; loop < loops; loop++) {
+        uint64_t loopStart = monotonicNanos();
+        size_t next = 0;
+
+        while (next < records.size()) {
+            if (maxSpeed) {
+                size_t end = std::min(next + maxSpeedBatch, records.size());
+                for (; next < end; next++) {
+                    const LogRecord& r = records[next];
+                    server.captureLine(r.source, r.line, r.channelId, r.color, monotonicNanos());
+                }
+            } else {
+                uint64_t elapsed = static_cast<uint64_t>((monotonicNanos() - loopStart) * speed);
+                while (next < records.size() &&
+                       records[next].unixNanos - records.front().unixNanos <= elapsed) {
+                    const LogRecord& r = records[next++];
+                    server.captureLine(r.source, r.line, r.channelId, r.color, monotonicNanos());
+                }
+            }
+
+            server.tick();
+            ticks++;
+
+            if (!maxSpeed) {
+                sleepNanos(frameNs);
+            }
+        }
+    }
+
+    uint64_t replayNs = monotonicNanos() - start;
+
+    // Give clients a moment to drain what is still queued
+    for (int i = 0; i < 1000 && server.getClientCount() > 0 && g_metrics.outputQueueBytes.load() > 0; i++) {
+        server.tick();
+        sleepNanos(frameNs);
+    }
+
+    double seconds = replayNs / 1e9;
+    uint64_t lines = static_cast<uint64_t>(records.size()) * loops;
+    printf("Replayed %llu lines in %.3f s over %llu ticks: %.0f lines/s, %.2f MB/s\n",
+           static_cast<unsigned long long>(lines), seconds, static_cast<unsigned long long>(ticks),
+           lines / seconds, totalBytes * static_cast<double>(loops) / seconds / (1024 * 1024));
+
+    server.printStats();
+    server.printLatency();
+    server.shutdown();
+
+    for (auto& t : drainers) {
+        t.join();
+    }
+    if (clients > 0) {
+        printf("Built-in clients received %llu bytes\n", static_cast<unsigned long long>(drained.load()));
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Tails the plugin's shared-memory console ring (shm_ring in config.ini).
+// Lines are read straight from the mapping; the process only enters the
+// kernel to sleep when it has caught up.
+#include "shm_ring.hpp"
+#include <csignal>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void onStopSignal(int) { g_stop = 1; }
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] [name]" << std::endl;
+    std::cout << "Tails the shared memory ring <name> (default: /vconsole)" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -a, --all          Start with the oldest line still in the ring" << std::endl;
+    std::cout << "  -n, --no-follow    Exit once the ring has been read" << std::endl;
+    std::cout << "  -t, --timestamps   Prefix lines with their capture time" << std::endl;
+    std::cout << "  -v, --verbose      Prefix lines with sequence number, source and channel" << std::endl;
+    std::cout << "  --help             Show this help" << std::endl;
+}
+
+static void printLine(const ShmRingLine& line, bool timestamps, bool verbose) {
+    if (timestamps) {
+        time_t seconds = static_cast<time_t>(line.unixNanos / 1000000000ULL);
+        struct tm tmv;
+        localtime_r(&seconds, &tmv);
+        char stamp[32];
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", &tmv);
+        printf("%s.%03u ", stamp, static_cast<unsigned>(line.unixNanos / 1000000ULL % 1000));
+    }
+    if (verbose) {
+        printf("#%llu %s ch%d ", static_cast<unsigned long long>(line.seq), captureSourceName(line.source),
+               line.channelId);
+    }
+    fwrite(line.text.data(), 1, line.text.size(), stdout);
+    if (line.text.empty() || line.text.back() != '\n') {
+        fputc('\n', stdout);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string name = "/vconsole";
+    bool fromStart = false;
+    bool follow = true;
+    bool timestamps = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-a" || arg == "--all") {
+            fromStart = true;
+        } else if (arg == "-n" || arg == "--no-follow") {
+            follow = false;
+        } else if (arg == "-t" || arg == "--timestamps") {
+            timestamps = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg[0] != '-') {
+            name = arg[0] == '/' ? arg : "/" + arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+
+    ShmRingReader reader;
+    ShmRingLine line;
+    bool waiting = false;
+    uint64_t reported = 0;
+
+    while (!g_stop) {
+        if (!reader.isOpen()) {
+            if (!reader.open(name, fromStart)) {
+                if (!follow) {
+                    std::cerr << "Cannot open shared memory ring " << name << std::endl;
+                    return 1;
+                }
+                if (!waiting) {
+                    std::cerr << "Waiting for shared memory ring " << name << std::endl;
+                    waiting = true;
+                    fromStart = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            waiting = false;
+            reported = 0;
+            // After the writer restarts, everything in the new ring is unseen
+            fromStart = true;
+        }
+
+        ShmReadResult result = reader.next(line);
+        if (result == SHM_READ_LINE) {
+            // Lines skipped by an overrun are counted once the next one arrives
+            if (reader.getLost() > reported) {
+                fflush(stdout);
+                std::cerr << "[overrun: " << reader.getLost() - reported << " line(s) lost]" << std::endl;
+                reported = reader.getLost();
+            }
+            printLine(line, timestamps, verbose);
+            continue;
+        }
+        if (result == SHM_READ_OVERRUN) {
+            continue;
+        }
+
+        fflush(stdout);
+        if (!follow) {
+            break;
+        }
+        if (reader.isWriterClosed()) {
+            reader.close();
+            continue;
+        }
+        reader.wait(1000);
+    }
+
+    fflush(stdout);
+    if (reader.getLost() > 0) {
+        std::cerr << reader.getLost() << " line(s) lost to overruns" << std::endl;
+    }
+    return 0;
+}